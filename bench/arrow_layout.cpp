@@ -0,0 +1,98 @@
+#include "arrow_layout.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Conversion of an Arrow array of 64K int32 with 10% of nulls to a tombstone
+// column and back, by the kernels and by a loop over the elements.
+
+namespace {
+
+using tombstone = dpsg::optional_tombstone<std::int32_t>;
+
+constexpr std::size_t length = 1U << 16U;
+
+struct fixture {
+  std::vector<std::int32_t> values;
+  std::vector<std::uint8_t> validity;
+  std::vector<tombstone> column;
+
+  fixture()
+      : values(length), validity(dpsg::arrow::validity_size(length)),
+        column(length) {
+    std::uint32_t state = 0x2545F491;
+    for (std::size_t i = 0; i < length; ++i) {
+      state ^= state << 13U;
+      state ^= state >> 17U;
+      state ^= state << 5U;
+      values[i] = static_cast<std::int32_t>(state >> 1U);
+      if (state % 10 != 0) {
+        validity[i / 8] |= static_cast<std::uint8_t>(1U << (i % 8));
+        column[i] = values[i];
+      }
+    }
+  }
+};
+
+void import_loop(benchmark::State &state) {
+  fixture f;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < length; ++i) {
+      if (((f.validity[i / 8] >> (i % 8)) & 1U) != 0) {
+        f.column[i] = f.values[i];
+      } else {
+        f.column[i] = dpsg::nullopt;
+      }
+    }
+    benchmark::DoNotOptimize(f.column.data());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(length));
+}
+
+void import_kernel(benchmark::State &state) {
+  fixture f;
+  for (auto _ : state) {
+    dpsg::arrow::from_arrow(f.values.data(), f.validity.data(), length,
+                            f.column.data());
+    benchmark::DoNotOptimize(f.column.data());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(length));
+}
+
+void export_loop(benchmark::State &state) {
+  fixture f;
+  for (auto _ : state) {
+    std::fill(f.validity.begin(), f.validity.end(), std::uint8_t{0});
+    for (std::size_t i = 0; i < length; ++i) {
+      if (f.column[i].has_value()) {
+        f.validity[i / 8] |= static_cast<std::uint8_t>(1U << (i % 8));
+      }
+    }
+    benchmark::DoNotOptimize(f.validity.data());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(length));
+}
+
+void export_kernel(benchmark::State &state) {
+  fixture f;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(dpsg::arrow::to_validity(
+        f.column.data(), length, f.validity.data()));
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(length));
+}
+
+} // namespace
+
+BENCHMARK(import_loop);
+BENCHMARK(import_kernel);
+BENCHMARK(export_loop);
+BENCHMARK(export_kernel);
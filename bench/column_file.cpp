@@ -0,0 +1,64 @@
+#include "column_file.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Loading a column of a million tombstone optionals and reading one element
+// of it, by reading the whole file in memory and by mapping it.
+
+namespace {
+
+using tombstone = dpsg::optional_tombstone<std::int64_t>;
+
+constexpr std::size_t count = 1U << 20U;
+
+const std::string &column_path() {
+  static const std::string path = [] {
+    std::string result = "dpsg_column_file_bench.bin";
+    std::vector<tombstone> values(count);
+    for (std::size_t i = 0; i < count; i += 3) {
+      values[i] = static_cast<std::int64_t>(i);
+    }
+    std::ofstream out(result, std::ios::binary);
+    dpsg::column_file::write(out, values.data(), values.size());
+    return result;
+  }();
+  return path;
+}
+
+void read_file(benchmark::State &state) {
+  const auto &path = column_path();
+  for (auto _ : state) {
+    std::ifstream in(path, std::ios::binary);
+    const std::vector<char> bytes{std::istreambuf_iterator<char>(in),
+                                  std::istreambuf_iterator<char>()};
+    std::vector<tombstone> values(count);
+    const auto *first = bytes.data() + sizeof(dpsg::column_file::header);
+    std::memcpy(values.data(), first, count * sizeof(tombstone));
+    benchmark::DoNotOptimize(values[count / 2]);
+  }
+}
+
+#if DPSG_COLUMN_FILE_MMAP
+void map_file(benchmark::State &state) {
+  const auto &path = column_path();
+  for (auto _ : state) {
+    const dpsg::column_file::mapping_of<tombstone> mapping{path};
+    benchmark::DoNotOptimize(mapping.span()[count / 2]);
+  }
+}
+#endif
+
+} // namespace
+
+BENCHMARK(read_file);
+#if DPSG_COLUMN_FILE_MMAP
+BENCHMARK(map_file);
+#endif
@@ -0,0 +1,79 @@
+#include "optional_columns.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// a + b * c over columns with a third of empty elements, evaluated with the
+// column kernels and with a per-element has_value() branch.
+
+namespace {
+
+constexpr std::size_t rows = 4096;
+
+template <class O> std::vector<O> make_column(unsigned seed) {
+  std::vector<O> result(rows);
+  unsigned state = seed;
+  for (std::size_t i = 0; i < rows; ++i) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    if (state % 3 != 0) {
+      result[i] = static_cast<typename O::value_type>(state % 1000);
+    }
+  }
+  return result;
+}
+
+template <class O> void set_items(benchmark::State &state) {
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(rows));
+}
+
+template <class O> void branching(benchmark::State &state) {
+  const auto a = make_column<O>(0x2545F491);
+  const auto b = make_column<O>(0x9E3779B9);
+  const auto c = make_column<O>(0x85EBCA6B);
+  std::vector<O> out(rows);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < rows; ++i) {
+      if (a[i].has_value() && b[i].has_value() && c[i].has_value()) {
+        out[i] = *a[i] + *b[i] * *c[i];
+      } else {
+        out[i].reset();
+      }
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  set_items<O>(state);
+}
+
+template <class O> void kernels(benchmark::State &state) {
+  const auto a = make_column<O>(0x2545F491);
+  const auto b = make_column<O>(0x9E3779B9);
+  const auto c = make_column<O>(0x85EBCA6B);
+  std::vector<O> out(rows);
+  for (auto _ : state) {
+    dpsg::columns::multiply(b.data(), c.data(), out.data(), rows);
+    dpsg::columns::add(a.data(), out.data(), out.data(), rows);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  set_items<O>(state);
+}
+
+using tint = dpsg::optional_tombstone<std::int64_t>;
+using tdouble = dpsg::optional_tombstone<double>;
+using fdouble = dpsg::optional<double>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(branching, tint);
+BENCHMARK_TEMPLATE(kernels, tint);
+BENCHMARK_TEMPLATE(branching, tdouble);
+BENCHMARK_TEMPLATE(kernels, tdouble);
+BENCHMARK_TEMPLATE(branching, fdouble);
+BENCHMARK_TEMPLATE(kernels, fdouble);
@@ -0,0 +1,53 @@
+#include "generalized_optional.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Sort then dedup of a batch of optionals of which a fifth are empty, as done
+// by the sort and dedup stages of a query.
+
+namespace {
+
+constexpr std::size_t batch = 4096;
+
+template <class O> std::vector<O> make_batch() {
+  std::vector<O> result(batch);
+  std::uint32_t state = 0x2545F491;
+  for (auto &o : result) {
+    state ^= state << 13U;
+    state ^= state >> 17U;
+    state ^= state << 5U;
+    if (state % 5 != 0) {
+      o = static_cast<std::int64_t>(state % 1024);
+    }
+  }
+  return result;
+}
+
+template <class O> void sort_unique(benchmark::State &state) {
+  const auto input = make_batch<O>();
+  std::vector<O> values;
+  for (auto _ : state) {
+    values = input;
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(batch));
+}
+
+using tombstone = dpsg::optional_tombstone<std::int64_t>;
+using flag = dpsg::optional<std::int64_t>;
+using standard = std::optional<std::int64_t>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(sort_unique, tombstone);
+BENCHMARK_TEMPLATE(sort_unique, flag);
+BENCHMARK_TEMPLATE(sort_unique, standard);
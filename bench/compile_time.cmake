@@ -0,0 +1,46 @@
+# Compile time benchmark, run by the compile_bench target.
+#
+# Compiles compile_time.cpp with N distinct optional types, once against
+# generalized_optional and once against std::optional, and reports the
+# front-end time (-fsyntax-only), the full compilation time and the size of
+# the resulting object file.
+#
+# cmake -DCXX=<compiler> -DSOURCE=<compile_time.cpp> -DINCLUDE=<include dir>
+#       -DOUTPUT=<dir> [-DN=<count>] -P compile_time.cmake
+cmake_minimum_required(VERSION 3.23)
+
+if(NOT DEFINED N)
+  set(N 200)
+endif()
+
+function(now_us out)
+  string(TIMESTAMP stamp "%s%f")
+  set(${out} ${stamp} PARENT_SCOPE)
+endfunction()
+
+function(measure name)
+  set(command ${CXX} -std=c++17 -I${INCLUDE} -DDPSG_COMPILE_BENCH_N=${N}
+              ${ARGN})
+  now_us(start)
+  execute_process(COMMAND ${command} -fsyntax-only ${SOURCE}
+                  RESULT_VARIABLE result)
+  if(result)
+    message(FATAL_ERROR "${name}: compilation failed")
+  endif()
+  now_us(parsed)
+  set(object ${OUTPUT}/compile_time_${name}.o)
+  execute_process(COMMAND ${command} -O2 -c ${SOURCE} -o ${object}
+                  RESULT_VARIABLE result)
+  if(result)
+    message(FATAL_ERROR "${name}: compilation failed")
+  endif()
+  now_us(compiled)
+  file(SIZE ${object} size)
+  math(EXPR front_end "(${parsed} - ${start}) / 1000")
+  math(EXPR total "(${compiled} - ${parsed}) / 1000")
+  message(STATUS "${name} (N=${N}): front-end ${front_end} ms, "
+                 "compilation ${total} ms, object ${size} bytes")
+endfunction()
+
+measure(generalized_optional)
+measure(std_optional -DDPSG_COMPILE_BENCH_STD)
@@ -0,0 +1,52 @@
+#include "generalized_optional.hpp"
+
+#include <optional>
+#include <utility>
+
+// Instantiates DPSG_COMPILE_BENCH_N distinct optional types and the usual
+// member functions of each of them. Compiled, not run, by the compile_bench
+// target (see compile_time.cmake). Define DPSG_COMPILE_BENCH_STD to get the
+// std::optional baseline.
+
+#ifndef DPSG_COMPILE_BENCH_N
+#define DPSG_COMPILE_BENCH_N 200
+#endif
+
+namespace {
+
+template <int I> struct payload {
+  int value;
+};
+
+#ifdef DPSG_COMPILE_BENCH_STD
+template <int I> using opt = std::optional<payload<I>>;
+#else
+template <int I> using opt = dpsg::optional<payload<I>>;
+#endif
+
+template <int I> int exercise(int seed) {
+  opt<I> o;
+  o = payload<I>{seed};
+  opt<I> copy{o};
+  opt<I> moved{std::move(copy)};
+  int sum = moved.has_value() ? moved->value : 0;
+  sum += o.value_or(payload<I>{I}).value;
+  o.reset();
+  o.emplace(payload<I>{seed + I});
+  sum += (*o).value + o.value().value;
+  o.swap(moved);
+  return sum;
+}
+
+template <int... Is>
+int exercise_all(int seed,
+                 [[maybe_unused]] std::integer_sequence<int, Is...> seq) {
+  return (exercise<Is>(seed) + ...);
+}
+
+} // namespace
+
+int main(int argc, [[maybe_unused]] char **argv) {
+  return exercise_all(argc,
+                      std::make_integer_sequence<int, DPSG_COMPILE_BENCH_N>{});
+}
@@ -0,0 +1,83 @@
+#include "flat_map.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Lookups of random 64 bit keys, half of which are in the map, in
+// flat_map and std::unordered_map.
+
+namespace {
+
+constexpr std::size_t entries = 1U << 16U;
+
+std::vector<std::int64_t> make_keys(std::uint64_t seed, std::size_t count) {
+  std::vector<std::int64_t> result(count);
+  std::uint64_t state = seed;
+  for (auto &key : result) {
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    key = static_cast<std::int64_t>(state >> 1U);
+  }
+  return result;
+}
+
+template <class Map> void lookup(benchmark::State &state) {
+  const auto keys = make_keys(0x2545F4914F6CDD1D, entries);
+  auto queries = make_keys(0x9E3779B97F4A7C15, entries);
+  for (std::size_t i = 0; i < entries; i += 2) {
+    queries[i] = keys[(i * 7919) % entries];
+  }
+  Map map;
+  map.reserve(entries);
+  for (auto key : keys) {
+    map[key] = key;
+  }
+  for (auto _ : state) {
+    std::int64_t sum = 0;
+    for (auto key : queries) {
+      const auto it = map.find(key);
+      if (it != map.end()) {
+        sum += (*it).second;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(entries));
+}
+
+template <class Map> void insert_erase(benchmark::State &state) {
+  const auto keys = make_keys(0x2545F4914F6CDD1D, entries);
+  for (auto _ : state) {
+    Map map;
+    for (auto key : keys) {
+      map[key] = key;
+    }
+    for (std::size_t i = 0; i < entries; i += 2) {
+      map.erase(keys[i]);
+    }
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(entries));
+}
+
+using linear = dpsg::flat_map<std::int64_t, std::int64_t>;
+using quadratic = dpsg::flat_map<std::int64_t, std::int64_t,
+                                 std::hash<std::int64_t>,
+                                 dpsg::probing::quadratic>;
+using unordered = std::unordered_map<std::int64_t, std::int64_t>;
+
+} // namespace
+
+BENCHMARK_TEMPLATE(lookup, linear);
+BENCHMARK_TEMPLATE(lookup, quadratic);
+BENCHMARK_TEMPLATE(lookup, unordered);
+BENCHMARK_TEMPLATE(insert_erase, linear);
+BENCHMARK_TEMPLATE(insert_erase, quadratic);
+BENCHMARK_TEMPLATE(insert_erase, unordered);
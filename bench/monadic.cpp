@@ -0,0 +1,191 @@
+#include "monadic_optional.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A validation chain as found on a request path, written with the lazy
+// pipeline of access::monadic and with the monadic members of std::optional
+// (C++23), which build an intermediate optional at every step.
+//
+// With string steps, the pipeline saves the moves and destructions of the
+// intermediate optionals and is about 10% faster than std::optional.
+//
+// With integer steps it is not: GCC inlines both chains into the same loop
+// without any intermediate optional, then turns the last step of the
+// std::optional chain into a conditional move and keeps a branch in the
+// pipeline, which ends up 20 to 30% slower. Handing a presence flag from
+// step to step instead of branching does not help, GCC threads the flag back
+// into the same branches. Making the integer chain win is a follow-up.
+
+namespace {
+
+constexpr std::size_t batch = 1024;
+
+struct request {
+  std::uint32_t port;
+  std::uint32_t user;
+  std::string path;
+};
+
+template <class O> std::vector<O> make_requests() {
+  std::vector<O> result;
+  result.reserve(batch);
+  unsigned state = 0x2545F491;
+  for (std::size_t i = 0; i < batch; ++i) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    if ((state & 7U) == 0) {
+      result.emplace_back();
+    } else {
+      result.emplace_back(request{
+          state % 70000, state >> 20,
+          std::string(8 + i % 24, static_cast<char>('a' + i % 26))});
+    }
+  }
+  return result;
+}
+
+constexpr auto port = [](const request &r) { return r.port; };
+constexpr auto valid_port = [](std::uint32_t p) { return p > 0 && p < 65536; };
+constexpr auto scale = [](std::uint32_t p) { return p * 3 + 1; };
+
+template <class O> constexpr auto lookup = [](std::uint32_t p) {
+  if ((p & 3U) == 0) {
+    return O{};
+  }
+  return O{p >> 2};
+};
+
+constexpr auto path = [](const request &r) { return r.path; };
+constexpr auto long_path = [](const std::string &p) { return p.size() > 16; };
+constexpr auto trim = [](std::string &&p) {
+  p.erase(0, 4);
+  return std::move(p);
+};
+constexpr auto path_key = [](const std::string &p) {
+  return static_cast<std::uint32_t>(p.size()) +
+         static_cast<unsigned char>(p[0]);
+};
+
+void set_items(benchmark::State &state) {
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(batch));
+}
+
+void monadic_pipeline(benchmark::State &state) {
+  using O = dpsg::optional_monadic<request>;
+  const auto requests = make_requests<O>();
+  for (auto _ : state) {
+    std::uint32_t sum = 0;
+    for (const auto &r : requests) {
+      sum += r.transform(port)
+                 .filter(valid_port)
+                 .transform(scale)
+                 .and_then(lookup<dpsg::optional<std::uint32_t>>)
+                 .filter([](std::uint32_t p) { return p != 7; })
+                 .or_else([] { return dpsg::optional<std::uint32_t>{1U}; })
+                 .value_or(0U);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items(state);
+}
+BENCHMARK(monadic_pipeline);
+
+// Non-trivial intermediate values, moved from step to step
+void monadic_pipeline_string(benchmark::State &state) {
+  using O = dpsg::optional_monadic<request>;
+  const auto requests = make_requests<O>();
+  for (auto _ : state) {
+    std::uint32_t sum = 0;
+    for (const auto &r : requests) {
+      sum += r.transform(path)
+                 .filter(long_path)
+                 .transform(trim)
+                 .filter(long_path)
+                 .transform(path_key)
+                 .value_or(0U);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items(state);
+}
+BENCHMARK(monadic_pipeline_string);
+
+#if defined(__cpp_lib_optional) && __cpp_lib_optional >= 202110L
+void std_monadic_chain(benchmark::State &state) {
+  using O = std::optional<request>;
+  const auto requests = make_requests<O>();
+  for (auto _ : state) {
+    std::uint32_t sum = 0;
+    for (const auto &r : requests) {
+      sum += r.transform(port)
+                 .and_then([](std::uint32_t p) {
+                   return valid_port(p) ? std::optional{p} : std::nullopt;
+                 })
+                 .transform(scale)
+                 .and_then(lookup<std::optional<std::uint32_t>>)
+                 .and_then([](std::uint32_t p) {
+                   return p != 7 ? std::optional{p} : std::nullopt;
+                 })
+                 .or_else([] { return std::optional<std::uint32_t>{1U}; })
+                 .value_or(0U);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items(state);
+}
+BENCHMARK(std_monadic_chain);
+
+void std_monadic_chain_string(benchmark::State &state) {
+  using O = std::optional<request>;
+  const auto requests = make_requests<O>();
+  const auto keep_long = [](std::string &&p) {
+    return long_path(p) ? std::optional{std::move(p)} : std::nullopt;
+  };
+  for (auto _ : state) {
+    std::uint32_t sum = 0;
+    for (const auto &r : requests) {
+      sum += r.transform(path)
+                 .and_then(keep_long)
+                 .transform(trim)
+                 .and_then(keep_long)
+                 .transform(path_key)
+                 .value_or(0U);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items(state);
+}
+BENCHMARK(std_monadic_chain_string);
+#endif
+
+// Same chain, written by hand
+void handwritten(benchmark::State &state) {
+  using O = std::optional<request>;
+  const auto requests = make_requests<O>();
+  for (auto _ : state) {
+    std::uint32_t sum = 0;
+    for (const auto &r : requests) {
+      std::uint32_t result = 1;
+      if (r.has_value() && valid_port(r->port)) {
+        const auto found = lookup<std::optional<std::uint32_t>>(scale(r->port));
+        if (found.has_value() && *found != 7) {
+          result = *found;
+        }
+      }
+      sum += result;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items(state);
+}
+BENCHMARK(handwritten);
+
+} // namespace
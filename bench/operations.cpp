@@ -0,0 +1,279 @@
+#include "generalized_optional.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Cost of the basic operations of every policy combination, compared with
+// std::optional. Each benchmark runs over a batch of optionals of which
+// roughly half are engaged, so that has_value cannot be predicted.
+
+namespace {
+
+constexpr std::size_t batch = 1024;
+
+template <std::size_t N> struct blob {
+  blob() noexcept = default;
+  explicit blob(int i) noexcept { data.fill(static_cast<unsigned char>(i)); }
+  std::array<unsigned char, N> data{};
+};
+using blob16 = blob<16>;
+using blob64 = blob<64>;
+using blob256 = blob<256>;
+
+template <class T> T make(int i) {
+  if constexpr (std::is_same_v<T, int>) {
+    return i;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    // Long enough to defeat the small string optimization
+    return std::string(32, static_cast<char>('a' + i % 26));
+  } else {
+    return T{i};
+  }
+}
+
+template <class T> int key(const T &value) {
+  if constexpr (std::is_same_v<T, int>) {
+    return value;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    return static_cast<int>(value.size()) + value.front();
+  } else {
+    return value.data.front() + value.data.back();
+  }
+}
+
+template <class T>
+using unchecked_optional = dpsg::generalized_optional<
+    T, dpsg::policy<dpsg::access::unchecked, dpsg::control::dependent_bool,
+                    dpsg::storage::aligned>>;
+
+template <class T>
+using throwing_optional = dpsg::generalized_optional<
+    T, dpsg::policy<dpsg::access::throw_exception,
+                    dpsg::control::dependent_bool, dpsg::storage::aligned>>;
+
+template <class O> struct is_std_optional : std::false_type {};
+template <class T>
+struct is_std_optional<std::optional<T>> : std::true_type {};
+
+template <class O> using value_t = typename O::value_type;
+
+template <class O> O make_optional(int i, bool engaged) {
+  if (engaged) {
+    return O{make<value_t<O>>(i)};
+  }
+  return O{};
+}
+
+// Same pattern of engaged elements for every benchmark
+template <class O> std::vector<O> make_batch(bool all_engaged = false) {
+  std::vector<O> result;
+  result.reserve(batch);
+  unsigned state = 0x2545F491;
+  for (std::size_t i = 0; i < batch; ++i) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    result.push_back(make_optional<O>(static_cast<int>(i),
+                                      all_engaged || (state & 1U) == 0));
+  }
+  return result;
+}
+
+template <class O> void set_items(benchmark::State &state) {
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(batch));
+}
+
+template <class O> void construct_empty(benchmark::State &state) {
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < batch; ++i) {
+      O o{};
+      benchmark::DoNotOptimize(o);
+    }
+  }
+  set_items<O>(state);
+}
+
+template <class O> void construct_value(benchmark::State &state) {
+  std::vector<value_t<O>> values;
+  for (std::size_t i = 0; i < batch; ++i) {
+    values.push_back(make<value_t<O>>(static_cast<int>(i)));
+  }
+  for (auto _ : state) {
+    for (const auto &v : values) {
+      O o{v};
+      benchmark::DoNotOptimize(o);
+    }
+  }
+  set_items<O>(state);
+}
+
+template <class O> void copy_construct(benchmark::State &state) {
+  const auto source = make_batch<O>();
+  for (auto _ : state) {
+    for (const auto &s : source) {
+      O o{s}; // NOLINT
+      benchmark::DoNotOptimize(o);
+    }
+  }
+  set_items<O>(state);
+}
+
+template <class O> void move_construct(benchmark::State &state) {
+  auto source = make_batch<O>();
+  for (auto _ : state) {
+    for (auto &s : source) {
+      // Moved back so that every iteration moves a payload
+      O o{std::move(s)};
+      benchmark::DoNotOptimize(o);
+      s = std::move(o);
+    }
+  }
+  set_items<O>(state);
+}
+
+template <class O> void copy_assign(benchmark::State &state) {
+  const auto source = make_batch<O>();
+  auto destination = make_batch<O>();
+  std::rotate(destination.begin(), destination.begin() + 1,
+              destination.end());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < batch; ++i) {
+      destination[i] = source[i];
+    }
+    benchmark::ClobberMemory();
+  }
+  set_items<O>(state);
+}
+
+template <class O> void assign_value(benchmark::State &state) {
+  auto destination = make_batch<O>();
+  const auto value = make<value_t<O>>(1);
+  for (auto _ : state) {
+    for (auto &d : destination) {
+      d = value;
+    }
+    benchmark::ClobberMemory();
+    destination[0] = O{};
+  }
+  set_items<O>(state);
+}
+
+template <class O> void has_value(benchmark::State &state) {
+  const auto source = make_batch<O>();
+  for (auto _ : state) {
+    int count = 0;
+    for (const auto &s : source) {
+      count += s.has_value() ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  set_items<O>(state);
+}
+
+template <class O> void value(benchmark::State &state) {
+  const auto source = make_batch<O>(true);
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto &s : source) {
+      sum += key(s.value());
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items<O>(state);
+}
+
+template <class O> void dereference(benchmark::State &state) {
+  const auto source = make_batch<O>(true);
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto &s : source) {
+      sum += key(*s);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items<O>(state);
+}
+
+template <class O> void value_or(benchmark::State &state) {
+  const auto source = make_batch<O>();
+  const auto fallback = make<value_t<O>>(0);
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto &s : source) {
+      sum += key(s.value_or(fallback));
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items<O>(state);
+}
+
+template <class O> void with_value(benchmark::State &state) {
+  const auto source = make_batch<O>();
+  const auto f = [](const value_t<O> &v) { return key(v); };
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto &s : source) {
+      if constexpr (is_std_optional<O>::value) {
+        // Closest equivalent
+        sum += s.has_value() ? f(*s) : -1;
+      } else {
+        sum += s.with_value(f, -1);
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_items<O>(state);
+}
+
+template <class O> void swap(benchmark::State &state) {
+  auto lhv = make_batch<O>();
+  auto rhv = make_batch<O>();
+  std::rotate(rhv.begin(), rhv.begin() + 1, rhv.end());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < batch; ++i) {
+      using std::swap;
+      swap(lhv[i], rhv[i]);
+    }
+    benchmark::ClobberMemory();
+  }
+  set_items<O>(state);
+}
+
+} // namespace
+
+#define DPSG_BENCH_OPERATIONS(O)                                               \
+  BENCHMARK_TEMPLATE(construct_empty, O);                                      \
+  BENCHMARK_TEMPLATE(construct_value, O);                                      \
+  BENCHMARK_TEMPLATE(copy_construct, O);                                       \
+  BENCHMARK_TEMPLATE(move_construct, O);                                       \
+  BENCHMARK_TEMPLATE(copy_assign, O);                                          \
+  BENCHMARK_TEMPLATE(assign_value, O);                                         \
+  BENCHMARK_TEMPLATE(has_value, O);                                            \
+  BENCHMARK_TEMPLATE(value, O);                                                \
+  BENCHMARK_TEMPLATE(dereference, O);                                          \
+  BENCHMARK_TEMPLATE(value_or, O);                                             \
+  BENCHMARK_TEMPLATE(swap, O)
+
+#define DPSG_BENCH_ALL_POLICIES(T)                                             \
+  DPSG_BENCH_OPERATIONS(std::optional<T>);                                     \
+  BENCHMARK_TEMPLATE(with_value, std::optional<T>);                            \
+  DPSG_BENCH_OPERATIONS(dpsg::optional<T>);                                    \
+  BENCHMARK_TEMPLATE(with_value, dpsg::optional<T>);                           \
+  DPSG_BENCH_OPERATIONS(unchecked_optional<T>);                                \
+  DPSG_BENCH_OPERATIONS(throwing_optional<T>)
+
+DPSG_BENCH_ALL_POLICIES(int);
+DPSG_BENCH_OPERATIONS(dpsg::optional_tombstone<int>);
+BENCHMARK_TEMPLATE(with_value, dpsg::optional_tombstone<int>);
+DPSG_BENCH_ALL_POLICIES(blob16);
+DPSG_BENCH_ALL_POLICIES(blob64);
+DPSG_BENCH_ALL_POLICIES(blob256);
+DPSG_BENCH_ALL_POLICIES(std::string);
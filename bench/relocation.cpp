@@ -0,0 +1,64 @@
+#include "generalized_optional.hpp"
+#include "optional_vector.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Growth of an optional_vector and reversal (swaps) of a vector of optionals,
+// of a payload owning a heap block, which is trivially relocatable or not.
+
+namespace {
+
+constexpr std::size_t count = 1U << 14U;
+
+struct handle {
+  explicit handle(int v) : value(std::make_unique<int>(v)) {}
+  std::unique_ptr<int> value;
+};
+struct relocatable_handle : handle {
+  using handle::handle;
+};
+
+} // namespace
+
+template <>
+struct dpsg::is_trivially_relocatable<relocatable_handle> : std::true_type {};
+
+namespace {
+
+template <class T> void growth(benchmark::State &state) {
+  for (auto _ : state) {
+    dpsg::optional_vector<T> vec;
+    for (std::size_t i = 0; i < count; ++i) {
+      vec.emplace_back(static_cast<int>(i));
+    }
+    benchmark::DoNotOptimize(vec.data());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(count));
+}
+
+template <class T> void reverse(benchmark::State &state) {
+  std::vector<dpsg::optional<T>> values(count);
+  for (std::size_t i = 0; i < count; i += 2) {
+    values[i].emplace(static_cast<int>(i));
+  }
+  for (auto _ : state) {
+    std::reverse(values.begin(), values.end());
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(count));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(growth, handle);
+BENCHMARK_TEMPLATE(growth, relocatable_handle);
+BENCHMARK_TEMPLATE(reverse, handle);
+BENCHMARK_TEMPLATE(reverse, relocatable_handle);
@@ -0,0 +1,540 @@
+#ifndef GUARD_ARROW_LAYOUT_HEADER
+#define GUARD_ARROW_LAYOUT_HEADER
+
+#include "generalized_optional.hpp"
+#include "optional_span.hpp"
+#include "optional_vector.hpp"
+#include "tombstone_scan.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Conversions between columns of optionals and the memory layout of Apache
+// Arrow primitive arrays, without depending on Arrow itself.
+//
+// An Arrow array of length n and offset k is made of a values buffer, whose
+// elements k to k + n are used, and of a validity bitmap, bit k + i (counting
+// from the least significant bit of each byte) telling whether element i is
+// valid. The bitmap may be missing (nullptr) when there are no nulls. The
+// content of the values of null elements is unspecified.
+//
+// Most conversions need no copy:
+// - an optional_vector is a values buffer followed by a bitmap whose 64 bit
+//   words have the layout of Arrow bitmaps on little endian platforms,
+// - an array of tombstone optionals is a valid values buffer by itself, only
+//   its bitmap needs to be computed,
+// - an Arrow array whose bitmap is suitably aligned can be viewed as an
+//   optional_span of dpsg::optional.
+// Filling tombstone columns from Arrow arrays, or computing bitmaps of
+// tombstone columns, is done by kernels processing whole vectors of elements
+// at a time. Other optionals use a plain loop.
+//
+// A tombstone column cannot hold its sentinel: valid Arrow values equal to it
+// are read back as empty.
+
+namespace dpsg {
+namespace arrow {
+
+// Whether 64 bit bitmap words (as used by optional_vector and optional_span)
+// have the same layout as Arrow bitmaps
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+constexpr static inline bool native_bitmaps =
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+constexpr static inline bool native_bitmaps = false;
+#endif
+
+// Size in bytes of the validity bitmap of length elements
+[[nodiscard]] constexpr std::size_t validity_size(std::size_t length) noexcept {
+  return (length + 7) / 8;
+}
+
+namespace detail {
+// Tombstone optionals with the layout of their payload, see optional_span
+template <class O> constexpr static inline bool tombstone_layout_v = false;
+template <class T, class P>
+constexpr static inline bool tombstone_layout_v<generalized_optional<T, P>> =
+    dpsg::detail::is_tombstone_layout_v<T, P>;
+
+constexpr std::uint64_t low_bits(std::size_t count) noexcept {
+  return count >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << count) - 1;
+}
+
+inline int popcount(std::uint64_t bits) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(bits);
+#else
+  int result = 0;
+  for (; bits != 0; bits &= bits - 1) {
+    ++result;
+  }
+  return result;
+#endif
+}
+
+// Validity of the count <= 64 elements starting at bit
+inline std::uint64_t load_bits(const std::uint8_t *validity, std::size_t bit,
+                               std::size_t count) noexcept {
+  const std::uint8_t *first = validity + bit / 8;
+  const std::size_t shift = bit % 8;
+  const std::size_t bytes = (shift + count + 7) / 8;
+  std::uint64_t result = 0;
+  for (std::size_t i = 0; i < std::min<std::size_t>(bytes, 8); ++i) {
+    result |= std::uint64_t{first[i]} << (8 * i);
+  }
+  result >>= shift;
+  if (bytes > 8) {
+    result |= std::uint64_t{first[8]} << (64 - shift);
+  }
+  return result & low_bits(count);
+}
+
+// Writes the validity of count <= 64 elements starting at a byte boundary
+inline void store_bits(std::uint8_t *validity, std::uint64_t bits,
+                       std::size_t count) noexcept {
+  for (std::size_t i = 0; i < validity_size(count); ++i) {
+    validity[i] = static_cast<std::uint8_t>(bits >> (8 * i));
+  }
+}
+
+// Kernels working on blocks of up to 64 elements. expand copies the raw
+// elements of src to dst, replacing those whose bit is not set by the
+// sentinel. valid_bits sets the bits of the elements that are not the
+// sentinel.
+
+struct scalar {
+  template <class W>
+  static void expand(const unsigned char *src, unsigned char *dst,
+                     std::size_t count, std::uint64_t bits,
+                     W sentinel) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+      const W w = scan::detail::load<W>(src + i * sizeof(W));
+      scan::detail::store<W>(dst + i * sizeof(W),
+                             ((bits >> i) & 1U) != 0 ? w : sentinel);
+    }
+  }
+
+  template <class W>
+  static std::uint64_t valid_bits(const unsigned char *src, std::size_t count,
+                                  W sentinel) noexcept {
+    std::uint64_t result = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      result |= std::uint64_t{scan::detail::load<W>(src + i * sizeof(W)) !=
+                              sentinel}
+                << i;
+    }
+    return result;
+  }
+};
+
+#if DPSG_SCAN_X86
+
+// SSE2 and AVX2 turn bits into lane masks by broadcasting them, keeping one
+// bit per lane and comparing the result with that bit.
+
+struct sse2 {
+  using base = scan::detail::sse2;
+  constexpr static inline std::size_t width = 16;
+
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static __m128i lane_mask(std::uint64_t bits) noexcept {
+    __m128i selected;
+    if constexpr (sizeof(W) == 1) {
+      // Byte j of the mask in lanes 8j to 8j + 7
+      __m128i v = _mm_cvtsi32_si128(static_cast<int>(bits & 0xFFFFU));
+      v = _mm_unpacklo_epi8(v, v);
+      v = _mm_unpacklo_epi16(v, v);
+      v = _mm_unpacklo_epi32(v, v);
+      selected = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16,
+                               32, 64, -128);
+      return _mm_cmpeq_epi8(_mm_and_si128(v, selected), selected);
+    } else if constexpr (sizeof(W) == 2) {
+      selected = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+    } else if constexpr (sizeof(W) == 4) {
+      selected = _mm_setr_epi32(1, 2, 4, 8);
+    } else {
+      selected = _mm_set_epi64x(2, 1);
+    }
+    const __m128i v = base::broadcast(static_cast<W>(bits));
+    return base::equal<W>(_mm_and_si128(v, selected), selected);
+  }
+
+  // One bit per lane from a comparison result
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static std::uint64_t compress(__m128i mask) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return static_cast<std::uint16_t>(_mm_movemask_epi8(mask));
+    } else if constexpr (sizeof(W) == 2) {
+      return static_cast<std::uint8_t>(
+          _mm_movemask_epi8(_mm_packs_epi16(mask, _mm_setzero_si128())));
+    } else if constexpr (sizeof(W) == 4) {
+      return static_cast<std::uint64_t>(
+          _mm_movemask_ps(_mm_castsi128_ps(mask)));
+    } else {
+      return static_cast<std::uint64_t>(
+          _mm_movemask_pd(_mm_castsi128_pd(mask)));
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static void
+  expand(const unsigned char *src, unsigned char *dst, std::size_t count,
+         std::uint64_t bits, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m128i s = base::broadcast(sentinel);
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+      const __m128i m = lane_mask<W>(bits >> i);
+      const __m128i v = base::load(src + i * sizeof(W));
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i *>(dst + i * sizeof(W)), // NOLINT
+          _mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, s)));
+    }
+    if (i < count) {
+      scalar::expand(src + i * sizeof(W), dst + i * sizeof(W), count - i,
+                     bits >> i, sentinel);
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static std::uint64_t
+  valid_bits(const unsigned char *src, std::size_t count,
+             W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m128i s = base::broadcast(sentinel);
+    std::uint64_t result = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+      const __m128i empty = base::equal<W>(base::load(src + i * sizeof(W)), s);
+      result |= (~compress<W>(empty) & low_bits(lanes)) << i;
+    }
+    if (i < count) {
+      result |= scalar::valid_bits(src + i * sizeof(W), count - i, sentinel)
+                << i;
+    }
+    return result;
+  }
+};
+
+struct avx2 {
+  using base = scan::detail::avx2;
+  constexpr static inline std::size_t width = 32;
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static __m256i lane_mask(std::uint64_t bits) noexcept {
+    __m256i v;
+    __m256i selected;
+    if constexpr (sizeof(W) == 1) {
+      // Byte j of the mask in lanes 8j to 8j + 7
+      v = _mm256_shuffle_epi8(
+          _mm256_set1_epi32(static_cast<int>(bits & 0xFFFFFFFFU)),
+          _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2,
+                           2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3));
+      selected = _mm256_set1_epi64x(
+          static_cast<long long>(0x8040201008040201ULL));
+    } else if constexpr (sizeof(W) == 2) {
+      v = base::broadcast(static_cast<W>(bits));
+      selected = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128, 256, 512,
+                                   1024, 2048, 4096, 8192, 16384, -32768);
+    } else if constexpr (sizeof(W) == 4) {
+      v = base::broadcast(static_cast<W>(bits));
+      selected = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    } else {
+      v = base::broadcast(static_cast<W>(bits));
+      selected = _mm256_setr_epi64x(1, 2, 4, 8);
+    }
+    return base::equal<W>(_mm256_and_si256(v, selected), selected);
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static std::uint64_t compress(__m256i mask) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return static_cast<std::uint32_t>(_mm256_movemask_epi8(mask));
+    } else if constexpr (sizeof(W) == 2) {
+      return static_cast<std::uint16_t>(_mm_movemask_epi8(
+          _mm_packs_epi16(_mm256_castsi256_si128(mask),
+                          _mm256_extracti128_si256(mask, 1))));
+    } else if constexpr (sizeof(W) == 4) {
+      return static_cast<std::uint64_t>(
+          _mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+    } else {
+      return static_cast<std::uint64_t>(
+          _mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static void
+  expand(const unsigned char *src, unsigned char *dst, std::size_t count,
+         std::uint64_t bits, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m256i s = base::broadcast(sentinel);
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+      const __m256i m = lane_mask<W>(bits >> i);
+      const __m256i v = base::load(src + i * sizeof(W));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i *>(dst + i * sizeof(W)), // NOLINT
+          _mm256_blendv_epi8(s, v, m));
+    }
+    if (i < count) {
+      scalar::expand(src + i * sizeof(W), dst + i * sizeof(W), count - i,
+                     bits >> i, sentinel);
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static std::uint64_t
+  valid_bits(const unsigned char *src, std::size_t count,
+             W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m256i s = base::broadcast(sentinel);
+    std::uint64_t result = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+      const __m256i empty = base::equal<W>(base::load(src + i * sizeof(W)), s);
+      result |= (~compress<W>(empty) & low_bits(lanes)) << i;
+    }
+    if (i < count) {
+      result |= scalar::valid_bits(src + i * sizeof(W), count - i, sentinel)
+                << i;
+    }
+    return result;
+  }
+};
+
+// AVX-512 comparisons and blends work on bit masks directly
+struct avx512 {
+  using base = scan::detail::avx512;
+  constexpr static inline std::size_t width = 64;
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX512 static void
+  expand(const unsigned char *src, unsigned char *dst, std::size_t count,
+         std::uint64_t bits, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m512i s = base::broadcast(sentinel);
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+      _mm512_storeu_si512(dst + i * sizeof(W),
+                          base::blend<W>(bits >> i, s,
+                                         base::load(src + i * sizeof(W))));
+    }
+    if (i < count) {
+      scalar::expand(src + i * sizeof(W), dst + i * sizeof(W), count - i,
+                     bits >> i, sentinel);
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX512 static std::uint64_t
+  valid_bits(const unsigned char *src, std::size_t count,
+             W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m512i s = base::broadcast(sentinel);
+    std::uint64_t result = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+      const std::uint64_t empty =
+          base::empty_mask<W>(src + i * sizeof(W), s);
+      result |= (~empty & base::full_mask<W>()) << i;
+    }
+    if (i < count) {
+      result |= scalar::valid_bits(src + i * sizeof(W), count - i, sentinel)
+                << i;
+    }
+    return result;
+  }
+};
+
+#endif // DPSG_SCAN_X86
+
+template <class F> decltype(auto) dispatch(scan::isa target, F &&f) {
+  switch (target) {
+#if DPSG_SCAN_X86
+  case scan::isa::avx512:
+    return std::forward<F>(f)(avx512{});
+  case scan::isa::avx2:
+    return std::forward<F>(f)(avx2{});
+  case scan::isa::sse2:
+    return std::forward<F>(f)(sse2{});
+#endif
+  default:
+    return std::forward<F>(f)(scalar{});
+  }
+}
+} // namespace detail
+
+// Whether an Arrow array of T can be viewed as an optional_span of
+// dpsg::optional<T>: its bitmap must be present, its offset a multiple of 64
+// and its buffers aligned as the span expects.
+template <class T>
+[[nodiscard]] bool viewable(const T *values, const std::uint8_t *validity,
+                            std::size_t offset = 0) noexcept {
+  return native_bitmaps && validity != nullptr && offset % 64 == 0 &&
+         reinterpret_cast<std::uintptr_t>(values) % alignof(T) == 0 &&
+         reinterpret_cast<std::uintptr_t>(validity) %
+                 alignof(std::uint64_t) ==
+             0;
+}
+
+// Arrow array viewed as dpsg::optional<T>, without copying. Throws
+// std::invalid_argument unless viewable(values, validity, offset).
+template <class T>
+[[nodiscard]] optional_span_of<optional<T>>
+view(const T *values, const std::uint8_t *validity, std::size_t length,
+     std::size_t offset = 0) {
+  static_assert(std::is_arithmetic_v<T>, "Arrow primitive arrays only");
+  if (!viewable(values, validity, offset)) {
+    throw std::invalid_argument("Arrow array cannot be viewed in place");
+  }
+  const auto *words = reinterpret_cast<const std::uint64_t *>( // NOLINT
+      validity + offset / 8);
+  return optional_span_of<optional<T>>{values + offset, words, length};
+}
+
+// Bitmap of an optional_vector as an Arrow validity bitmap, its values
+// buffer being vec.data(). Only available when native_bitmaps.
+template <class T, class Access, class Allocator>
+[[nodiscard]] const std::uint8_t *
+validity(const optional_vector<T, Access, Allocator> &vec) noexcept {
+  static_assert(native_bitmaps, "bitmap words do not have Arrow's layout");
+  return reinterpret_cast<const std::uint8_t *>(vec.bitmap()); // NOLINT
+}
+
+// Array of tombstone optionals as an Arrow values buffer. Its bitmap is
+// computed by to_validity.
+template <class O>
+[[nodiscard]] const typename O::value_type *values(const O *data) noexcept {
+  static_assert(detail::tombstone_layout_v<O>,
+                "only tombstone optionals are their own values buffer");
+  return reinterpret_cast<const typename O::value_type *>(data); // NOLINT
+}
+
+// The overloads taking an isa force a specific code path, which must be
+// supported by the running CPU. The others use scan::best_isa().
+
+// Fills out[0, length) from an Arrow array. validity may be nullptr when the
+// array has no null.
+template <class O>
+void from_arrow(scan::isa target, const typename O::value_type *values,
+                const std::uint8_t *validity, std::size_t length, O *out,
+                std::size_t offset = 0) {
+  using T = typename O::value_type;
+  if constexpr (detail::tombstone_layout_v<O>) {
+    using layout = scan::detail::tombstone_layout<O>;
+    const auto sentinel = layout::sentinel();
+    const auto *src = scan::detail::bytes(values + offset);
+    auto *dst = scan::detail::bytes(out);
+    if (validity == nullptr) {
+      // values may be null for an empty array
+      if (length > 0) {
+        std::memmove(dst, src, length * sizeof(T));
+      }
+      return;
+    }
+    detail::dispatch(target, [&](auto kernels) {
+      for (std::size_t i = 0; i < length; i += 64) {
+        const std::size_t count = std::min<std::size_t>(64, length - i);
+        const std::uint64_t bits =
+            detail::load_bits(validity, offset + i, count);
+        if (bits == detail::low_bits(count)) {
+          std::memmove(dst + i * sizeof(T), src + i * sizeof(T),
+                       count * sizeof(T));
+        } else {
+          decltype(kernels)::expand(src + i * sizeof(T), dst + i * sizeof(T),
+                                    count, bits, sentinel);
+        }
+      }
+    });
+  } else {
+    for (std::size_t i = 0; i < length; ++i) {
+      const std::size_t bit = offset + i;
+      if (validity == nullptr || ((validity[bit / 8] >> (bit % 8)) & 1U) != 0) {
+        out[i] = values[bit];
+      } else {
+        out[i] = nullopt;
+      }
+    }
+  }
+}
+
+// Writes the Arrow validity bitmap of data[0, size) to validity, which must
+// hold validity_size(size) bytes, and returns the number of nulls
+template <class O>
+std::size_t to_validity(scan::isa target, const O *data, std::size_t size,
+                        std::uint8_t *validity) {
+  std::size_t nulls = 0;
+  if constexpr (detail::tombstone_layout_v<O>) {
+    using layout = scan::detail::tombstone_layout<O>;
+    const auto sentinel = layout::sentinel();
+    const auto *src = scan::detail::bytes(data);
+    detail::dispatch(target, [&](auto kernels) {
+      for (std::size_t i = 0; i < size; i += 64) {
+        const std::size_t count = std::min<std::size_t>(64, size - i);
+        const std::uint64_t bits = decltype(kernels)::valid_bits(
+            src + i * sizeof(typename O::value_type), count, sentinel);
+        nulls += count - static_cast<std::size_t>(detail::popcount(bits));
+        detail::store_bits(validity + i / 8, bits, count);
+      }
+    });
+  } else {
+    std::fill(validity, validity + validity_size(size), std::uint8_t{0});
+    for (std::size_t i = 0; i < size; ++i) {
+      if (data[i].has_value()) {
+        validity[i / 8] |= static_cast<std::uint8_t>(1U << (i % 8));
+      } else {
+        ++nulls;
+      }
+    }
+  }
+  return nulls;
+}
+
+// Writes the values buffer (with 0 for empty elements) and validity bitmap of
+// data[0, size) and returns the number of nulls. Tombstone columns do not need
+// the copy of their values, see values().
+template <class O>
+std::size_t to_arrow(scan::isa target, const O *data, std::size_t size,
+                     typename O::value_type *values,
+                     std::uint8_t *validity) {
+  using T = typename O::value_type;
+  if constexpr (detail::tombstone_layout_v<O>) {
+    scan::value_or(target, data, size, values, T{});
+  } else {
+    for (std::size_t i = 0; i < size; ++i) {
+      values[i] = data[i].has_value() ? *data[i] : T{};
+    }
+  }
+  return to_validity(target, data, size, validity);
+}
+
+template <class O>
+void from_arrow(const typename O::value_type *values,
+                const std::uint8_t *validity, std::size_t length, O *out,
+                std::size_t offset = 0) {
+  from_arrow(scan::best_isa(), values, validity, length, out, offset);
+}
+
+template <class O>
+std::size_t to_validity(const O *data, std::size_t size,
+                        std::uint8_t *validity) {
+  return to_validity(scan::best_isa(), data, size, validity);
+}
+
+template <class O>
+std::size_t to_arrow(const O *data, std::size_t size,
+                     typename O::value_type *values,
+                     std::uint8_t *validity) {
+  return to_arrow(scan::best_isa(), data, size, values, validity);
+}
+
+} // namespace arrow
+} // namespace dpsg
+
+#endif // GUARD_ARROW_LAYOUT_HEADER
@@ -0,0 +1,313 @@
+#ifndef GUARD_ATOMIC_OPTIONAL_HEADER
+#define GUARD_ATOMIC_OPTIONAL_HEADER
+
+#include "generalized_optional.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+namespace detail {
+// std::atomic::wait/notify when available (C++20), polling otherwise
+template <class U>
+void atomic_wait(const std::atomic<U> &atomic, U old,
+                 std::memory_order order) noexcept {
+#if defined(__cpp_lib_atomic_wait)
+  atomic.wait(old, order);
+#else
+  while (atomic.load(order) == old) {
+    std::this_thread::yield();
+  }
+#endif
+}
+
+template <class U>
+void atomic_notify_one([[maybe_unused]] std::atomic<U> &atomic) noexcept {
+#if defined(__cpp_lib_atomic_wait)
+  atomic.notify_one();
+#endif
+}
+
+template <class U>
+void atomic_notify_all([[maybe_unused]] std::atomic<U> &atomic) noexcept {
+#if defined(__cpp_lib_atomic_wait)
+  atomic.notify_all();
+#endif
+}
+} // namespace detail
+
+namespace storage {
+// Payload held in a std::atomic. Only read-only references to it are handed
+// out: every write goes through the atomic, from the control policy.
+struct atomic {
+  template <class B> class type : public B {
+  private:
+    using T = typename B::type;
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "atomic storage requires a trivially copyable type");
+    static_assert(sizeof(std::atomic<T>) == sizeof(T),
+                  "std::atomic<T> must have the representation of T");
+
+  protected:
+    std::atomic<T> _value;
+
+    type() = default;
+
+    template <class... Args>
+    explicit type([[maybe_unused]] in_place_t marker, Args &&... args) noexcept
+        : _value(T{std::forward<Args>(args)...}) {}
+
+    std::atomic<T> &get_atomic() noexcept { return _value; }
+    const std::atomic<T> &get_atomic() const noexcept { return _value; }
+
+    const T *get_ptr() const noexcept {
+      return reinterpret_cast<const T *>(&_value); // NOLINT
+    }
+    const T &get_ref() const &noexcept { return *get_ptr(); }
+    const T &&get_ref() const &&noexcept { return std::move(*get_ptr()); }
+
+    template <class... Args> void build(Args &&... args) noexcept {
+      _value.store(T{std::forward<Args>(args)...}, std::memory_order_release);
+    }
+    void destroy() noexcept {}
+  };
+};
+} // namespace storage
+
+namespace control {
+// Tombstone read and written atomically, for storage::atomic. Makes a
+// lock-free single word slot: has_value, load and wait acquire, every write
+// releases and wakes up the waiters.
+//
+// atomic_optional_tombstone adds no access policy, so there is no operator*
+// or value(). value_or, which generalized_optional always provides, reads the
+// payload without synchronization: use load() when other threads may write to
+// the slot.
+template <class T, T V = T{}> struct atomic_tombstone {
+  static_assert(std::is_integral_v<T> || std::is_enum_v<T> ||
+                    std::is_pointer_v<T>,
+                "atomic tombstones compare by value, use an integral, "
+                "enumeration or pointer type");
+  static_assert(std::atomic<T>::is_always_lock_free,
+                "atomic tombstones must be lock-free");
+
+  template <class B> struct type : B {
+    static_assert(std::is_same_v<T, typename B::type>,
+                  "Type & tombstone mismatch");
+    constexpr static inline T tombstone_value = V;
+
+    // Non-atomic optional with the same representation
+    using snapshot = generalized_optional<
+        T, policy<access::extended, tombstone<T, V>, storage::aligned>>;
+
+  private:
+    static T _raw(const snapshot &value) noexcept {
+      return value.has_value() ? *value : V;
+    }
+
+    static snapshot _wrap(T raw) noexcept {
+      if (raw == V) {
+        return snapshot{};
+      }
+      return snapshot{raw};
+    }
+
+  public:
+    type() noexcept : B(in_place, V) {}
+
+    template <class... Args>
+    explicit type([[maybe_unused]] bool initial_value, Args &&... args)
+        : B(std::forward<Args>(args)...) {
+      assert(initial_value == has_value(std::memory_order_relaxed));
+    }
+
+    [[nodiscard]] bool has_value(
+        std::memory_order order = std::memory_order_acquire) const noexcept {
+      return B::get_atomic().load(order) != V;
+    }
+
+    [[nodiscard]] snapshot
+    load(std::memory_order order = std::memory_order_acquire) const noexcept {
+      return _wrap(B::get_atomic().load(order));
+    }
+
+    // Fills the slot if it is empty. Returns false if another value was
+    // already there.
+    template <class... Args> bool try_emplace(Args &&... args) noexcept {
+      const T desired{std::forward<Args>(args)...};
+      assert(desired != V && "emplacing the tombstone value");
+      T expected = V;
+      if (B::get_atomic().compare_exchange_strong(expected, desired,
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_acquire)) {
+        detail::atomic_notify_all(B::get_atomic());
+        return true;
+      }
+      return false;
+    }
+
+    // Stores desired, possibly empty
+    void store(const snapshot &desired,
+               std::memory_order order = std::memory_order_release) noexcept {
+      B::get_atomic().store(_raw(desired), order);
+      detail::atomic_notify_all(B::get_atomic());
+    }
+
+    // Stores desired (possibly empty), returns the previous content
+    snapshot exchange(
+        const snapshot &desired,
+        std::memory_order order = std::memory_order_acq_rel) noexcept {
+      const T previous = B::get_atomic().exchange(_raw(desired), order);
+      detail::atomic_notify_all(B::get_atomic());
+      return _wrap(previous);
+    }
+
+    // Stores desired if the slot holds expected. Otherwise expected receives
+    // the current content.
+    bool compare_exchange(
+        snapshot &expected, const snapshot &desired,
+        std::memory_order success = std::memory_order_acq_rel,
+        std::memory_order failure = std::memory_order_acquire) noexcept {
+      T raw = _raw(expected);
+      if (B::get_atomic().compare_exchange_strong(raw, _raw(desired), success,
+                                                  failure)) {
+        detail::atomic_notify_all(B::get_atomic());
+        return true;
+      }
+      expected = _wrap(raw);
+      return false;
+    }
+
+    // Blocks while the slot holds old
+    void wait(const snapshot &old,
+              std::memory_order order = std::memory_order_acquire) const
+        noexcept {
+      detail::atomic_wait(B::get_atomic(), _raw(old), order);
+    }
+
+    // Blocks until the slot is filled, returns its value
+    [[nodiscard]] T wait_for_value(
+        std::memory_order order = std::memory_order_acquire) const noexcept {
+      for (;;) {
+        const T raw = B::get_atomic().load(order);
+        if (raw != V) {
+          return raw;
+        }
+        detail::atomic_wait(B::get_atomic(), V, order);
+      }
+    }
+
+    void notify_one() noexcept { detail::atomic_notify_one(B::get_atomic()); }
+    void notify_all() noexcept { detail::atomic_notify_all(B::get_atomic()); }
+
+  protected:
+    template <class... Args> void build(Args &&... args) noexcept {
+      store(T{std::forward<Args>(args)...});
+    }
+
+    void reset() noexcept { store(snapshot{}); }
+  };
+};
+
+// dependent_bool with an atomic flag. The flag goes through a building state
+// while the payload is constructed, so that a single thread wins try_emplace
+// and a reader never sees a partially built value. Building and reset are
+// published with release semantics, has_value and waits acquire.
+//
+// The payload itself is not atomic: once published it must not be modified
+// or reset while other threads read it.
+struct atomic_flag {
+  template <class B> struct type : B {
+  private:
+    using T = typename B::type;
+    enum state : unsigned char { empty, building, ready };
+    std::atomic<unsigned char> _state;
+
+    void _publish(unsigned char value) noexcept {
+      _state.store(value, std::memory_order_release);
+      detail::atomic_notify_all(_state);
+    }
+
+    template <class... Args> void _build(Args &&... args) {
+      try {
+        B::build(std::forward<Args>(args)...);
+      } catch (...) {
+        _publish(empty);
+        throw;
+      }
+      _publish(ready);
+    }
+
+  protected:
+    type() noexcept : _state(empty) {}
+
+    template <class... Args>
+    explicit type(bool initial_value, Args &&... args)
+        : B(std::forward<Args>(args)...),
+          _state(initial_value ? ready : empty) {}
+
+    void reset() noexcept {
+      _state.store(building, std::memory_order_relaxed);
+      B::destroy();
+      _publish(empty);
+    }
+
+    template <class... Args> void build(Args &&... args) {
+      _state.store(building, std::memory_order_relaxed);
+      _build(std::forward<Args>(args)...);
+    }
+
+  public:
+    [[nodiscard]] bool has_value(
+        std::memory_order order = std::memory_order_acquire) const noexcept {
+      return _state.load(order) == ready;
+    }
+
+    // Builds the value if the slot is empty and no other thread is building
+    // one. Returns false otherwise.
+    template <class... Args> bool try_emplace(Args &&... args) {
+      unsigned char expected = empty;
+      if (!_state.compare_exchange_strong(expected, building,
+                                          std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+        return false;
+      }
+      _build(std::forward<Args>(args)...);
+      return true;
+    }
+
+    // Blocks until the slot is filled, returns its value
+    const T &wait_for_value(
+        std::memory_order order = std::memory_order_acquire) const noexcept {
+      for (;;) {
+        const unsigned char current = _state.load(order);
+        if (current == ready) {
+          return B::get_ref();
+        }
+        detail::atomic_wait(_state, current, order);
+      }
+    }
+
+    void notify_one() noexcept { detail::atomic_notify_one(_state); }
+    void notify_all() noexcept { detail::atomic_notify_all(_state); }
+  };
+};
+} // namespace control
+
+// Lock-free single word slot. Not copyable, use load() to get a copy.
+template <class T, T Default = detail::deduce_tombstone_value<T>::value>
+using atomic_optional_tombstone = generalized_optional<
+    T, policy<control::atomic_tombstone<T, Default>, storage::atomic>>;
+
+// Slot of any type, published through an atomic flag
+template <class T>
+using atomic_optional = generalized_optional<
+    T, policy<access::extended, control::atomic_flag, storage::aligned>>;
+
+} // namespace dpsg
+
+#endif // GUARD_ATOMIC_OPTIONAL_HEADER
@@ -0,0 +1,201 @@
+#ifndef GUARD_BITMAP_REFERENCE_HEADER
+#define GUARD_BITMAP_REFERENCE_HEADER
+
+#include "generalized_optional.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+namespace storage {
+// Refers to a value owned by someone else (typically a container). The
+// lifetime of the pointed-to memory is managed by the owner, this policy only
+// builds and destroys the object living in it.
+struct external {
+  template <class B> class type : public B {
+  private:
+    using T = typename B::type;
+
+  protected:
+    T *_value;
+
+    constexpr explicit type(T *value) noexcept : _value(value) {}
+
+    constexpr T *get_ptr() noexcept { return _value; }
+    constexpr const T *get_ptr() const noexcept { return _value; }
+    constexpr T &&get_ref() &&noexcept { return std::move(*_value); }
+    constexpr const T &&get_ref() const &&noexcept {
+      return std::move(*_value);
+    }
+    constexpr T &get_ref() &noexcept { return *_value; }
+    constexpr const T &get_ref() const &noexcept { return *_value; }
+    template <class... Args> constexpr void build(Args &&... args) {
+      dpsg::detail::construct_at<T>(_value, std::forward<Args>(args)...);
+    }
+    constexpr void destroy() noexcept { _value->~T(); }
+  };
+};
+} // namespace storage
+
+namespace control {
+// Presence is a single bit of a word owned by someone else. Several optionals
+// share the same word, each with its own mask.
+template <class Word = std::uint64_t> struct bitmask {
+  static_assert(std::is_unsigned_v<Word>, "bitmask words must be unsigned");
+
+  template <class B> struct type : B {
+    constexpr static inline bool relocatable = false;
+
+  protected:
+    Word *_word;
+    std::remove_const_t<Word> _mask;
+
+    template <class... Args>
+    constexpr explicit type(Word *word, std::remove_const_t<Word> mask,
+                            Args &&... args)
+        : B(std::forward<Args>(args)...), _word(word), _mask(mask) {}
+
+    constexpr void reset() noexcept {
+      B::destroy();
+      *_word &= ~_mask;
+    }
+
+    template <class... Args>
+    constexpr void build(Args &&... args) noexcept(
+        noexcept(B::build(std::forward<Args>(args)...))) {
+      B::build(std::forward<Args>(args)...);
+      *_word |= _mask;
+    }
+
+  public:
+    [[nodiscard]] constexpr bool has_value() const noexcept {
+      return (*_word & _mask) != 0;
+    }
+  };
+};
+} // namespace control
+
+// Reference to an optional value whose payload and presence bit live in
+// separate arrays. Behaves like std::vector<bool>::reference: copying the
+// proxy copies the reference, assigning to it assigns the referred element.
+// Constness is shallow, and the referred element is never moved from through
+// a temporary proxy.
+template <class T, class Access = access::extended,
+          class Word = std::uint64_t>
+class bitmap_reference
+    : public detail::base<bitmap_reference<T, Access, Word>, Access,
+                          control::bitmask<Word>, storage::external> {
+  using base = detail::base<bitmap_reference<T, Access, Word>, Access,
+                            control::bitmask<Word>, storage::external>;
+  using value_t = std::remove_const_t<T>;
+
+  constexpr base &as_lvalue() const noexcept {
+    return const_cast<bitmap_reference &>(*this); // NOLINT shallow constness
+  }
+
+public:
+  using value_type = T;
+  using word_type = Word;
+  using base::has_value;
+
+  constexpr bitmap_reference(T *value, Word *word,
+                             std::remove_const_t<Word> mask) noexcept
+      : base(word, mask, value) {}
+  constexpr bitmap_reference(const bitmap_reference &) noexcept = default;
+  ~bitmap_reference() = default;
+
+  constexpr bitmap_reference &operator=(const bitmap_reference &other) {
+    if (other.has_value()) {
+      *this = other.get_ref();
+    } else {
+      reset();
+    }
+    return *this;
+  }
+
+  // NOLINTNEXTLINE(misc-unconventional-assign-operator)
+  constexpr bitmap_reference &operator=(
+      [[maybe_unused]] nullopt_t empty_assignment) noexcept {
+    reset();
+    return *this;
+  }
+
+  template <class U = value_t,
+            std::enable_if_t<
+                std::conjunction_v<
+                    std::negation<std::is_same<detail::remove_cvref_t<U>,
+                                               bitmap_reference>>,
+                    std::is_constructible<value_t, U>>,
+                int> = 0>
+  constexpr bitmap_reference &operator=(U &&value) {
+    if (has_value()) {
+      base::get_ref() = std::forward<U>(value);
+    } else {
+      base::build(std::forward<U>(value));
+    }
+    return *this;
+  }
+
+  constexpr explicit operator bool() const noexcept { return has_value(); }
+
+  constexpr decltype(auto) value() const { return as_lvalue().value(); }
+  constexpr decltype(auto) operator*() const { return *as_lvalue(); }
+  constexpr decltype(auto) operator->() const {
+    return as_lvalue().operator->();
+  }
+  template <class... Args>
+  constexpr decltype(auto) with_value(Args &&... args) const {
+    return as_lvalue().with_value(std::forward<Args>(args)...);
+  }
+
+  template <class U> constexpr value_t value_or(U &&default_value) const {
+    if (has_value()) {
+      return base::get_ref();
+    }
+    return static_cast<value_t>(std::forward<U>(default_value));
+  }
+
+  constexpr void reset() noexcept {
+    if (has_value()) {
+      base::reset();
+    }
+  }
+
+  template <class... Args> constexpr T &emplace(Args &&... args) {
+    reset();
+    base::build(std::forward<Args>(args)...);
+    return base::get_ref();
+  }
+
+  // Copies the referred element into an owning optional
+  template <class P> operator generalized_optional<value_t, P>() const {
+    generalized_optional<value_t, P> result;
+    if (has_value()) {
+      result = base::get_ref();
+    }
+    return result;
+  }
+
+  friend void swap(bitmap_reference lhv, bitmap_reference rhv) {
+    if (lhv.has_value()) {
+      if (rhv.has_value()) {
+        using std::swap;
+        swap(lhv.get_ref(), rhv.get_ref());
+      } else {
+        rhv.base::build(std::move(lhv.get_ref()));
+        lhv.reset();
+      }
+    } else if (rhv.has_value()) {
+      lhv.base::build(std::move(rhv.get_ref()));
+      rhv.reset();
+    }
+  }
+};
+
+} // namespace dpsg
+
+#endif // GUARD_BITMAP_REFERENCE_HEADER
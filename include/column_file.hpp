@@ -0,0 +1,369 @@
+#ifndef GUARD_COLUMN_FILE_HEADER
+#define GUARD_COLUMN_FILE_HEADER
+
+#include "generalized_optional.hpp"
+#include "optional_span.hpp"
+#include "optional_vector.hpp"
+#include "tombstone_scan.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>) && __has_include(<fcntl.h>) &&               \
+    __has_include(<unistd.h>)
+#define DPSG_COLUMN_FILE_MMAP 1
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#else
+#define DPSG_COLUMN_FILE_MMAP 0
+#endif
+
+// Binary format of a column of optionals, which can be used in place once
+// the file is mapped in memory.
+//
+//   header (64 bytes) | values | padding to 8 bytes | bitmap
+//
+// Tombstone columns are the raw array of optionals, empty elements holding
+// the sentinel, and have no bitmap. Other columns store the payloads (0 when
+// empty) followed by a validity bitmap of 64 bit words, bit i % 64 of word
+// i / 64 telling whether element i is engaged.
+//
+// Everything is written in the byte order of the writer. Columns written
+// with the other byte order are rejected, as they could not be used without
+// a copy.
+
+namespace dpsg {
+namespace column_file {
+
+constexpr static inline std::uint16_t current_version = 1;
+constexpr static inline char magic[8] = {'D', 'P', 'S', 'G',
+                                         'O', 'P', 'T', '\0'};
+
+enum class encoding : std::uint8_t { tombstone = 0, bitmap = 1 };
+
+enum class element_type : std::uint8_t {
+  i8 = 1,
+  i16,
+  i32,
+  i64,
+  u8,
+  u16,
+  u32,
+  u64,
+  f32,
+  f64,
+  boolean
+};
+
+enum class byte_order : std::uint8_t { little = 0, big = 1 };
+
+struct header {
+  char magic[8];
+  std::uint16_t version;
+  encoding layout;
+  element_type type;
+  byte_order order;
+  std::uint8_t element_size;
+  std::uint8_t reserved[2];
+  std::uint64_t count;
+  // Object representation of the tombstone, 0 for bitmap columns
+  std::uint64_t sentinel;
+  // From the start of the file. The bitmap offset is 0 for tombstone columns.
+  std::uint64_t values_offset;
+  std::uint64_t bitmap_offset;
+  std::uint8_t padding[16];
+};
+static_assert(sizeof(header) == 64 && std::is_trivially_copyable_v<header>,
+              "the values following the header must be aligned");
+
+// The file is not a column of the requested type
+class format_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+inline byte_order native_order() noexcept {
+  const std::uint16_t probe = 1;
+  unsigned char first;
+  std::memcpy(&first, &probe, 1);
+  return first == 1 ? byte_order::little : byte_order::big;
+}
+
+template <class T> constexpr element_type element_type_of() noexcept {
+  static_assert(std::is_arithmetic_v<T>, "columns hold arithmetic types");
+  if constexpr (std::is_same_v<T, bool>) {
+    return element_type::boolean;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8,
+                  "unsupported floating point type");
+    return sizeof(T) == 4 ? element_type::f32 : element_type::f64;
+  } else {
+    constexpr int log = sizeof(T) == 1 ? 0
+                        : sizeof(T) == 2 ? 1
+                        : sizeof(T) == 4 ? 2
+                                         : 3;
+    const auto first = std::is_signed_v<T> ? element_type::i8
+                                           : element_type::u8;
+    return static_cast<element_type>(static_cast<int>(first) + log);
+  }
+}
+
+constexpr std::uint64_t align_up(std::uint64_t offset,
+                                 std::uint64_t alignment) noexcept {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+constexpr std::uint64_t word_count(std::uint64_t count) noexcept {
+  return (count + 63) / 64;
+}
+
+template <class T, class Policy>
+header make_header(std::uint64_t count) noexcept {
+  using span = optional_span<T, Policy>;
+  header h{};
+  std::memcpy(h.magic, column_file::magic, sizeof(h.magic));
+  h.version = current_version;
+  h.type = element_type_of<T>();
+  h.order = native_order();
+  h.element_size = sizeof(T);
+  h.count = count;
+  h.values_offset = sizeof(header);
+  if constexpr (span::tombstone_layout) {
+    h.layout = encoding::tombstone;
+    h.sentinel = scan::detail::tombstone_layout<
+        generalized_optional<T, Policy>>::sentinel();
+  } else {
+    h.layout = encoding::bitmap;
+    h.bitmap_offset = align_up(h.values_offset + count * sizeof(T),
+                               alignof(typename span::word_type));
+  }
+  return h;
+}
+
+inline void write_bytes(std::ostream &out, const void *data,
+                        std::uint64_t size) {
+  out.write(static_cast<const char *>(data),
+            static_cast<std::streamsize>(size));
+}
+
+inline void write_padding(std::ostream &out, std::uint64_t from,
+                          std::uint64_t to) {
+  const char zeros[8] = {};
+  write_bytes(out, zeros, to - from);
+}
+
+template <class O> struct column_policy;
+template <class T, class P> struct column_policy<generalized_optional<T, P>> {
+  using type = P;
+};
+
+[[noreturn]] inline void fail(const char *reason) {
+  throw format_error(std::string("invalid optional column: ") + reason);
+}
+} // namespace detail
+
+// Writes count optionals starting at data
+template <class T, class Policy>
+void write(std::ostream &out, const generalized_optional<T, Policy> *data,
+           std::size_t count) {
+  const header h = detail::make_header<T, Policy>(count);
+  detail::write_bytes(out, &h, sizeof(h));
+  if constexpr (optional_span<T, Policy>::tombstone_layout) {
+    detail::write_bytes(out, data, count * sizeof(T));
+  } else {
+    // Not a vector, which would be packed for bool
+    const auto values = std::make_unique<T[]>(count);
+    std::vector<std::uint64_t> bitmap(detail::word_count(count));
+    for (std::size_t i = 0; i < count; ++i) {
+      if (data[i].has_value()) {
+        values[i] = *data[i];
+        bitmap[i / 64] |= std::uint64_t{1} << (i % 64);
+      }
+    }
+    detail::write_bytes(out, values.get(), count * sizeof(T));
+    detail::write_padding(out, h.values_offset + count * sizeof(T),
+                          h.bitmap_offset);
+    detail::write_bytes(out, bitmap.data(),
+                        bitmap.size() * sizeof(std::uint64_t));
+  }
+}
+
+// optional_vector already has the layout of a bitmap column, with the
+// payloads of empty elements value-initialized. Read back as
+// optional_span_of<optional<T>>.
+template <class T, class Access, class Allocator>
+void write(std::ostream &out,
+           const optional_vector<T, Access, Allocator> &vec) {
+  using column_policy = typename detail::column_policy<optional<T>>::type;
+  const std::size_t count = vec.size();
+  const header h = detail::make_header<T, column_policy>(count);
+  detail::write_bytes(out, &h, sizeof(h));
+  detail::write_bytes(out, vec.data(), count * sizeof(T));
+  detail::write_padding(out, h.values_offset + count * sizeof(T),
+                        h.bitmap_offset);
+  detail::write_bytes(out, vec.bitmap(),
+                      detail::word_count(count) * sizeof(std::uint64_t));
+}
+
+// Column held by size bytes starting at data, which must stay valid (and
+// unmodified) as long as the view is used. Throws format_error unless data
+// holds a column of generalized_optional<T, Policy> of the native byte order.
+template <class T, class Policy>
+optional_span<T, Policy> view(const void *data, std::size_t size) {
+  using span = optional_span<T, Policy>;
+  const auto *bytes = static_cast<const unsigned char *>(data);
+  const header expected = detail::make_header<T, Policy>(0);
+  header h;
+  if (size < sizeof(header)) {
+    detail::fail("truncated header");
+  }
+  std::memcpy(&h, bytes, sizeof(header));
+  if (std::memcmp(h.magic, magic, sizeof(magic)) != 0) {
+    detail::fail("bad magic number");
+  }
+  if (h.version != current_version) {
+    detail::fail("unsupported version");
+  }
+  if (h.order != expected.order) {
+    detail::fail("foreign byte order");
+  }
+  if (h.layout != expected.layout) {
+    detail::fail("encoding mismatch");
+  }
+  if (h.type != expected.type || h.element_size != sizeof(T)) {
+    detail::fail("element type mismatch");
+  }
+  if (h.sentinel != expected.sentinel) {
+    detail::fail("tombstone mismatch");
+  }
+  if (h.values_offset % alignof(T) != 0 ||
+      reinterpret_cast<std::uintptr_t>(bytes) % alignof(T) != 0) {
+    detail::fail("misaligned values");
+  }
+  if (h.count > size / sizeof(T) || h.values_offset > size ||
+      h.count * sizeof(T) > size - h.values_offset) {
+    detail::fail("truncated values");
+  }
+  if constexpr (span::tombstone_layout) {
+    const auto *values = std::launder(
+        reinterpret_cast<const generalized_optional<T, Policy> *>( // NOLINT
+            bytes + h.values_offset));
+    return span{values, static_cast<std::size_t>(h.count)};
+  } else {
+    const std::uint64_t words = detail::word_count(h.count);
+    if (h.bitmap_offset % alignof(std::uint64_t) != 0 ||
+        reinterpret_cast<std::uintptr_t>(bytes) % alignof(std::uint64_t) !=
+            0) {
+      detail::fail("misaligned bitmap");
+    }
+    if (h.bitmap_offset > size ||
+        words > (size - h.bitmap_offset) / sizeof(std::uint64_t)) {
+      detail::fail("truncated bitmap");
+    }
+    const auto *values = std::launder(
+        reinterpret_cast<const T *>(bytes + h.values_offset)); // NOLINT
+    const auto *bitmap = std::launder(reinterpret_cast<const std::uint64_t *>(
+        bytes + h.bitmap_offset)); // NOLINT
+    return span{values, bitmap, static_cast<std::size_t>(h.count)};
+  }
+}
+
+#if DPSG_COLUMN_FILE_MMAP
+// Column file mapped read-only in memory. The optionals are used where they
+// are in the mapping, nothing is copied: pages are only read from disk when
+// first accessed.
+template <class T, class Policy> class mapping {
+public:
+  using span_type = optional_span<T, Policy>;
+
+  // Throws std::system_error if the file cannot be mapped, format_error if it
+  // does not hold a column of generalized_optional<T, Policy>
+  explicit mapping(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+      const int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), path);
+    }
+    _size = static_cast<std::size_t>(info.st_size);
+    if (_size > 0) {
+      _memory = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    const int error = errno;
+    ::close(fd);
+    if (_memory == MAP_FAILED) { // NOLINT
+      _memory = nullptr;
+      throw std::system_error(error, std::generic_category(), path);
+    }
+    try {
+      _span = view<T, Policy>(_memory, _size);
+    } catch (...) {
+      _unmap();
+      throw;
+    }
+  }
+
+  mapping(const mapping &) = delete;
+  mapping &operator=(const mapping &) = delete;
+
+  mapping(mapping &&other) noexcept
+      : _memory(std::exchange(other._memory, nullptr)),
+        _size(std::exchange(other._size, 0)),
+        _span(std::exchange(other._span, span_type{})) {}
+
+  mapping &operator=(mapping &&other) noexcept {
+    if (std::addressof(other) != this) {
+      _unmap();
+      _memory = std::exchange(other._memory, nullptr);
+      _size = std::exchange(other._size, 0);
+      _span = std::exchange(other._span, span_type{});
+    }
+    return *this;
+  }
+
+  ~mapping() { _unmap(); }
+
+  // Valid as long as the mapping
+  [[nodiscard]] const span_type &span() const noexcept { return _span; }
+
+private:
+  void *_memory = nullptr;
+  std::size_t _size = 0;
+  span_type _span;
+
+  void _unmap() noexcept {
+    if (_memory != nullptr) {
+      ::munmap(_memory, _size);
+      _memory = nullptr;
+    }
+  }
+};
+
+// Mapping of a column of O, e.g. mapping_of<optional_tombstone<int>>
+template <class O>
+using mapping_of =
+    mapping<typename O::value_type, typename detail::column_policy<O>::type>;
+#endif
+
+} // namespace column_file
+} // namespace dpsg
+
+#endif // GUARD_COLUMN_FILE_HEADER
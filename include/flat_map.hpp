@@ -0,0 +1,688 @@
+#ifndef GUARD_FLAT_MAP_HEADER
+#define GUARD_FLAT_MAP_HEADER
+
+#include "generalized_optional.hpp"
+#include "tombstone_scan.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+// Sequence of groups visited by a lookup, starting from the group the hash
+// of the key points to. Both of them visit every group of the table.
+namespace probing {
+struct linear {
+  constexpr static std::size_t
+  next(std::size_t group, [[maybe_unused]] std::size_t step) noexcept {
+    return group + 1;
+  }
+};
+
+// Triangular numbers, which cover power of two tables
+struct quadratic {
+  constexpr static std::size_t next(std::size_t group,
+                                    std::size_t step) noexcept {
+    return group + step;
+  }
+};
+} // namespace probing
+
+namespace detail {
+// Second sentinel of flat_map keys, marking slots whose key was erased
+template <class K, class = void> struct deduce_deleted_value;
+template <class K>
+struct deduce_deleted_value<
+    K, std::enable_if_t<std::is_integral_v<K> && std::is_signed_v<K>>> {
+  constexpr static inline K value = std::numeric_limits<K>::min() + 1;
+};
+template <class K>
+struct deduce_deleted_value<K, std::enable_if_t<std::is_unsigned_v<K>>> {
+  constexpr static inline K value = std::numeric_limits<K>::max() - 1;
+};
+template <> struct deduce_deleted_value<float> {
+  constexpr static inline std::uint32_t value =
+      deduce_tombstone_value<float>::value + 1;
+};
+template <> struct deduce_deleted_value<double> {
+  constexpr static inline std::uint64_t value =
+      deduce_tombstone_value<double>::value + 1;
+};
+
+// Object representation of a sentinel given as a template parameter
+template <class K>
+constexpr scan::detail::raw_word_t<K>
+sentinel_word(tombstone_value_t<K> value) noexcept {
+  return static_cast<scan::detail::raw_word_t<K>>(value);
+}
+
+// Lanes of a group selected by a comparison. Comparisons may set several bits
+// per lane, Stride of them, of which only the lowest is kept.
+template <std::size_t Stride> class lane_mask {
+  constexpr static std::uint32_t _low_bits() noexcept {
+    std::uint32_t result = 0;
+    for (std::size_t i = 0; i < 32; i += Stride) {
+      result |= std::uint32_t{1} << i;
+    }
+    return result;
+  }
+
+  std::uint32_t _bits;
+
+public:
+  constexpr explicit lane_mask(std::uint32_t bits) noexcept
+      : _bits(bits & _low_bits()) {}
+
+  [[nodiscard]] constexpr bool any() const noexcept { return _bits != 0; }
+
+  [[nodiscard]] std::size_t lowest() const noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_ctz(_bits)) / Stride;
+#else
+    std::size_t result = 0;
+    for (std::uint32_t b = _bits; (b & 1U) == 0; b >>= 1U) {
+      ++result;
+    }
+    return result / Stride;
+#endif
+  }
+
+  constexpr lane_mask operator|(lane_mask other) const noexcept {
+    return lane_mask{_bits | other._bits};
+  }
+};
+
+constexpr static inline std::size_t key_group_bytes = 16;
+
+// Keys are probed a group at a time, with a single SSE2 comparison on x86-64.
+// The keys are their own control bytes: empty and erased slots are found by
+// comparing the raw words with the sentinels.
+template <class K> struct key_group {
+  using word = scan::detail::raw_word_t<K>;
+  constexpr static inline std::size_t lanes = key_group_bytes / sizeof(K);
+#if DPSG_SCAN_X86
+  constexpr static inline std::size_t stride = sizeof(K);
+#else
+  constexpr static inline std::size_t stride = 1;
+#endif
+  using mask = lane_mask<stride>;
+
+  static mask match(const unsigned char *ptr, word w) noexcept {
+#if DPSG_SCAN_X86
+    using sse = scan::detail::sse2;
+    return mask{static_cast<std::uint32_t>(_mm_movemask_epi8(
+        sse::equal<word>(sse::load(ptr), sse::broadcast(w))))};
+#else
+    std::uint32_t bits = 0;
+    for (std::size_t lane = 0; lane < lanes; ++lane) {
+      bits |= static_cast<std::uint32_t>(
+                  scan::detail::load<word>(ptr + lane * sizeof(word)) == w)
+              << lane;
+    }
+    return mask{bits};
+#endif
+  }
+
+  // Lanes holding key. Floating point keys are compared by value, 0.0 and
+  // -0.0 being the same key.
+  static mask find(const unsigned char *ptr, const K &key) noexcept {
+    if constexpr (std::is_integral_v<K>) {
+      word w;
+      std::memcpy(&w, &key, sizeof(word));
+      return match(ptr, w);
+    } else {
+      std::uint32_t bits = 0;
+      for (std::size_t lane = 0; lane < lanes; ++lane) {
+        K k;
+        std::memcpy(&k, ptr + lane * sizeof(K), sizeof(K));
+        bits |= static_cast<std::uint32_t>(k == key) << (lane * stride);
+      }
+      return mask{bits};
+    }
+  }
+};
+
+// Cell of a value, only built for the occupied slots
+template <class V>
+struct flat_map_cell
+    : storage::aligned::template type<base<flat_map_cell<V>>> {
+  using storage_type =
+      typename storage::aligned::template type<base<flat_map_cell<V>>>;
+  using storage_type::build;
+  using storage_type::destroy;
+  using storage_type::get_ref;
+};
+} // namespace detail
+
+// Open addressing hash map of arithmetic keys. The keys are stored as
+// optional_tombstone<K, Empty>, so that the table needs no metadata besides
+// the keys themselves: a probe reads a single array. Erased slots hold the
+// Deleted sentinel until the next rehash. Neither sentinel can be used as a
+// key.
+//
+// Values live in a separate array of cells, built only for occupied slots.
+// References and iterators are invalidated by every insertion that grows or
+// rehashes the table.
+template <class K, class V, class Hash = std::hash<K>,
+          class Probing = probing::linear,
+          detail::tombstone_value_t<K> Empty =
+              detail::deduce_tombstone_value<K>::value,
+          detail::tombstone_value_t<K> Deleted =
+              detail::deduce_deleted_value<K>::value>
+class flat_map {
+  static_assert(std::is_arithmetic_v<K>, "flat_map keys must be arithmetic");
+  static_assert(Empty != Deleted,
+                "the empty and deleted markers must be different");
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using hasher = Hash;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using key_slot = optional_tombstone<K, Empty>;
+  using reference = std::pair<const K &, V &>;
+  using const_reference = std::pair<const K &, const V &>;
+
+private:
+  using group = detail::key_group<K>;
+  using word = typename group::word;
+  using cell = detail::flat_map_cell<V>;
+
+  constexpr static inline word empty_word = detail::sentinel_word<K>(Empty);
+  constexpr static inline word deleted_word =
+      detail::sentinel_word<K>(Deleted);
+
+public:
+  // Slots per group. Capacities are powers of two multiples of it.
+  constexpr static inline size_type group_size = group::lanes;
+
+private:
+  template <bool Const> class basic_iterator {
+    using container = std::conditional_t<Const, const flat_map, flat_map>;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<K, V>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, const_reference,
+                                         typename flat_map::reference>;
+    using pointer = void;
+
+    constexpr basic_iterator() noexcept = default;
+    constexpr basic_iterator(container *c, size_type idx) noexcept
+        : _container(c), _index(idx) {}
+    // NOLINTNEXTLINE
+    constexpr basic_iterator(const basic_iterator<false> &other) noexcept
+        : _container(other._container), _index(other._index) {}
+
+    reference operator*() const {
+      return reference{*_container->_keys[_index],
+                       _container->_cells[_index].get_ref()};
+    }
+
+    basic_iterator &operator++() noexcept {
+      _index = _container->_next_occupied(_index + 1);
+      return *this;
+    }
+    basic_iterator operator++(int) noexcept {
+      auto cpy = *this;
+      ++*this;
+      return cpy;
+    }
+
+    friend constexpr bool operator==(const basic_iterator &lhv,
+                                     const basic_iterator &rhv) noexcept {
+      return lhv._index == rhv._index;
+    }
+    friend constexpr bool operator!=(const basic_iterator &lhv,
+                                     const basic_iterator &rhv) noexcept {
+      return lhv._index != rhv._index;
+    }
+
+  private:
+    friend flat_map;
+    friend basic_iterator<!Const>;
+    container *_container = nullptr;
+    size_type _index = 0;
+  };
+
+public:
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  flat_map() noexcept(std::is_nothrow_default_constructible_v<Hash>) = default;
+  explicit flat_map(size_type count, const Hash &hash = Hash()) : _hash(hash) {
+    reserve(count);
+  }
+
+  // Same layout as other, erased slots included
+  flat_map(const flat_map &other)
+      : flat_map(other._hash, other._max_load_factor) {
+    if (other._capacity == 0) {
+      return;
+    }
+    _allocate(other._capacity);
+    for (size_type i = 0; i < other._capacity; ++i) {
+      if (other._occupied(i)) {
+        _cells[i].build(other._cells[i].get_ref());
+        _keys[i] = *other._keys[i];
+        ++_size;
+      } else if (other._raw(i) == deleted_word) {
+        _mark(i, deleted_word);
+      }
+    }
+    _used = other._used;
+  }
+
+  flat_map(flat_map &&other) noexcept
+      : _hash(std::move(other._hash)),
+        _max_load_factor(other._max_load_factor),
+        _keys(std::exchange(other._keys, nullptr)),
+        _cells(std::exchange(other._cells, nullptr)),
+        _capacity(std::exchange(other._capacity, 0)),
+        _size(std::exchange(other._size, 0)),
+        _used(std::exchange(other._used, 0)) {}
+
+  flat_map &operator=(const flat_map &other) {
+    if (std::addressof(other) != this) {
+      flat_map cpy{other};
+      swap(cpy);
+    }
+    return *this;
+  }
+
+  flat_map &operator=(flat_map &&other) noexcept {
+    flat_map cpy{std::move(other)};
+    swap(cpy);
+    return *this;
+  }
+
+  ~flat_map() {
+    clear();
+    _deallocate(_keys, _cells, _capacity);
+  }
+
+  void swap(flat_map &other) noexcept {
+    using std::swap;
+    swap(_hash, other._hash);
+    swap(_max_load_factor, other._max_load_factor);
+    swap(_keys, other._keys);
+    swap(_cells, other._cells);
+    swap(_capacity, other._capacity);
+    swap(_size, other._size);
+    swap(_used, other._used);
+  }
+
+  friend void swap(flat_map &lhv, flat_map &rhv) noexcept { lhv.swap(rhv); }
+
+  [[nodiscard]] hasher hash_function() const { return _hash; }
+
+  // Capacity
+
+  [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+  [[nodiscard]] size_type size() const noexcept { return _size; }
+  [[nodiscard]] size_type bucket_count() const noexcept { return _capacity; }
+
+  [[nodiscard]] float load_factor() const noexcept {
+    return _capacity == 0 ? 0.F
+                          : static_cast<float>(_size) /
+                                static_cast<float>(_capacity);
+  }
+  [[nodiscard]] float max_load_factor() const noexcept {
+    return _max_load_factor;
+  }
+  // Erased slots count towards the load until the next rehash. Must be in
+  // (0, 1): lookups stop on the first group with an empty slot.
+  void max_load_factor(float value) {
+    assert(value > 0.F && value < 1.F);
+    _max_load_factor = value;
+    if (static_cast<float>(_used) > _max_used(_capacity)) {
+      rehash(_size);
+    }
+  }
+
+  void reserve(size_type count) {
+    const size_type capacity = _capacity_for(count);
+    if (capacity > _capacity) {
+      _rehash(capacity);
+    }
+  }
+
+  // Rebuilds the table with room for at least count elements, dropping the
+  // erased slots
+  void rehash(size_type count) {
+    _rehash(_capacity_for(std::max(count, _size)));
+  }
+
+  // Lookup
+
+  [[nodiscard]] iterator find(const K &key) noexcept {
+    return iterator{this, _find(key)};
+  }
+  [[nodiscard]] const_iterator find(const K &key) const noexcept {
+    return const_iterator{this, _find(key)};
+  }
+  [[nodiscard]] bool contains(const K &key) const noexcept {
+    return _find(key) != _capacity;
+  }
+  [[nodiscard]] size_type count(const K &key) const noexcept {
+    return contains(key) ? 1 : 0;
+  }
+
+  [[nodiscard]] V &at(const K &key) {
+    return _cells[_checked_find(key)].get_ref();
+  }
+  [[nodiscard]] const V &at(const K &key) const {
+    return _cells[_checked_find(key)].get_ref();
+  }
+
+  V &operator[](const K &key) {
+    const size_type idx = _emplace(key).first;
+    return _cells[idx].get_ref();
+  }
+
+  // Iterators
+
+  [[nodiscard]] iterator begin() noexcept {
+    return iterator{this, _next_occupied(0)};
+  }
+  [[nodiscard]] iterator end() noexcept { return iterator{this, _capacity}; }
+  [[nodiscard]] const_iterator begin() const noexcept {
+    return const_iterator{this, _next_occupied(0)};
+  }
+  [[nodiscard]] const_iterator end() const noexcept {
+    return const_iterator{this, _capacity};
+  }
+  [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+  [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+  // Modifiers
+
+  void clear() noexcept {
+    for (size_type i = 0; i < _capacity; ++i) {
+      if (_occupied(i)) {
+        _cells[i].destroy();
+      }
+      _keys[i].reset();
+    }
+    _size = 0;
+    _used = 0;
+  }
+
+  // Does nothing if key is already present
+  template <class... Args>
+  std::pair<iterator, bool> try_emplace(const K &key, Args &&... args) {
+    const auto [idx, inserted] = _emplace(key, std::forward<Args>(args)...);
+    return {iterator{this, idx}, inserted};
+  }
+
+  template <class M>
+  std::pair<iterator, bool> insert_or_assign(const K &key, M &&value) {
+    const auto [idx, inserted] = _emplace(key, std::forward<M>(value));
+    if (!inserted) {
+      _cells[idx].get_ref() = std::forward<M>(value);
+    }
+    return {iterator{this, idx}, inserted};
+  }
+
+  size_type erase(const K &key) {
+    const size_type idx = _find(key);
+    if (idx == _capacity) {
+      return 0;
+    }
+    _erase(idx);
+    return 1;
+  }
+
+  iterator erase(const_iterator pos) {
+    _erase(pos._index);
+    return iterator{this, _next_occupied(pos._index + 1)};
+  }
+
+private:
+  constexpr static inline std::size_t key_group_alignment =
+      std::max(detail::key_group_bytes, alignof(key_slot));
+
+  Hash _hash{};
+  float _max_load_factor = 0.875F;
+  key_slot *_keys = nullptr;
+  cell *_cells = nullptr;
+  size_type _capacity = 0;
+  size_type _size = 0;
+  // Occupied and erased slots
+  size_type _used = 0;
+
+  flat_map(const Hash &hash, float max_load_factor)
+      : _hash(hash), _max_load_factor(max_load_factor) {}
+
+  [[nodiscard]] size_type _group_mask() const noexcept {
+    return _capacity / group_size - 1;
+  }
+
+  [[nodiscard]] const unsigned char *_group_ptr(size_type g) const noexcept {
+    return scan::detail::bytes(_keys + g * group_size);
+  }
+
+  // Fibonacci hashing, so that identity hashes of integers still spread over
+  // the whole table
+  [[nodiscard]] size_type _home_group(const K &key) const {
+    const auto hash = static_cast<std::uint64_t>(_hash(key));
+    return static_cast<size_type>((hash * 0x9E3779B97F4A7C15ULL) >> 32U) &
+           _group_mask();
+  }
+
+  [[nodiscard]] word _raw(size_type idx) const noexcept {
+    return scan::detail::load<word>(scan::detail::bytes(_keys + idx));
+  }
+
+  [[nodiscard]] bool _occupied(size_type idx) const noexcept {
+    const word w = _raw(idx);
+    return w != empty_word && w != deleted_word;
+  }
+
+  void _mark(size_type idx, word w) noexcept {
+    scan::detail::store<word>(scan::detail::bytes(_keys + idx), w);
+  }
+
+  [[nodiscard]] static bool _is_marker(const K &key) noexcept {
+    word w;
+    std::memcpy(&w, &key, sizeof(word));
+    return w == empty_word || w == deleted_word;
+  }
+
+  [[nodiscard]] size_type _next_occupied(size_type idx) const noexcept {
+    while (idx < _capacity && !_occupied(idx)) {
+      ++idx;
+    }
+    return idx;
+  }
+
+  [[nodiscard]] float _max_used(size_type capacity) const noexcept {
+    return _max_load_factor * static_cast<float>(capacity);
+  }
+
+  [[nodiscard]] size_type _capacity_for(size_type count) const noexcept {
+    size_type capacity = group_size;
+    while (static_cast<float>(count) > _max_used(capacity)) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  // Index of the slot of key, or the capacity
+  [[nodiscard]] size_type _find(const K &key) const noexcept {
+    if (_size == 0 || _is_marker(key)) {
+      return _capacity;
+    }
+    size_type g = _home_group(key);
+    for (size_type step = 1; step <= _capacity / group_size; ++step) {
+      const unsigned char *ptr = _group_ptr(g);
+      const auto found = group::find(ptr, key);
+      if (found.any()) {
+        return g * group_size + found.lowest();
+      }
+      if (group::match(ptr, empty_word).any()) {
+        break;
+      }
+      g = Probing::next(g, step) & _group_mask();
+    }
+    return _capacity;
+  }
+
+  [[nodiscard]] size_type _checked_find(const K &key) const {
+    const size_type idx = _find(key);
+    if (idx == _capacity) {
+      throw std::out_of_range("flat_map::at");
+    }
+    return idx;
+  }
+
+  // First empty or erased slot on the path of key, which must not be in the
+  // table. There is always one, the load factor being below 1.
+  [[nodiscard]] size_type _free_slot(const K &key) const noexcept {
+    size_type g = _home_group(key);
+    for (size_type step = 1;; ++step) {
+      const unsigned char *ptr = _group_ptr(g);
+      const auto free =
+          group::match(ptr, empty_word) | group::match(ptr, deleted_word);
+      if (free.any()) {
+        return g * group_size + free.lowest();
+      }
+      g = Probing::next(g, step) & _group_mask();
+    }
+  }
+
+  template <class... Args>
+  std::pair<size_type, bool> _emplace(const K &key, Args &&... args) {
+    assert(!_is_marker(key) && "flat_map sentinels cannot be used as keys");
+    size_type idx = _find(key);
+    if (idx != _capacity) {
+      return {idx, false};
+    }
+    if (static_cast<float>(_used + 1) > _max_used(_capacity)) {
+      // Also reclaims the erased slots when there are many of them
+      _rehash(std::max(_capacity, _capacity_for(2 * (_size + 1))));
+    }
+    idx = _free_slot(key);
+    _cells[idx].build(std::forward<Args>(args)...);
+    if (_raw(idx) == empty_word) {
+      ++_used;
+    }
+    _keys[idx] = key;
+    ++_size;
+    return {idx, true};
+  }
+
+  void _erase(size_type idx) noexcept {
+    _cells[idx].destroy();
+    // Lookups stop on a group with an empty slot, so none went past this one
+    // if it already had one: the slot can be emptied rather than marked
+    if (group::match(_group_ptr(idx / group_size), empty_word).any()) {
+      _keys[idx].reset();
+      --_used;
+    } else {
+      _mark(idx, deleted_word);
+    }
+    --_size;
+  }
+
+  void _allocate(size_type capacity) {
+    _keys = static_cast<key_slot *>(::operator new(
+        capacity * sizeof(key_slot), std::align_val_t{key_group_alignment}));
+    try {
+      _cells = static_cast<cell *>(::operator new(
+          capacity * sizeof(cell), std::align_val_t{alignof(cell)}));
+    } catch (...) {
+      ::operator delete(_keys, std::align_val_t{key_group_alignment});
+      _keys = nullptr;
+      throw;
+    }
+    for (size_type i = 0; i < capacity; ++i) {
+      ::new (static_cast<void *>(_keys + i)) key_slot{};
+      ::new (static_cast<void *>(_cells + i)) cell;
+    }
+    _capacity = capacity;
+  }
+
+  static void _deallocate(key_slot *keys, cell *cells,
+                          size_type capacity) noexcept {
+    if (capacity > 0) {
+      ::operator delete(keys, std::align_val_t{key_group_alignment});
+      ::operator delete(cells, std::align_val_t{alignof(cell)});
+    }
+  }
+
+  // Leaves the table untouched if an allocation or a move throws
+  void _rehash(size_type capacity) {
+    key_slot *keys = _keys;
+    cell *cells = _cells;
+    const size_type old_capacity = _capacity;
+    const size_type old_size = _size;
+    const size_type old_used = _used;
+    const auto occupied = [keys](size_type i) {
+      const word w =
+          scan::detail::load<word>(scan::detail::bytes(keys + i));
+      return w != empty_word && w != deleted_word;
+    };
+    bool allocated = false;
+    try {
+      _allocate(capacity);
+      allocated = true;
+      _size = 0;
+      _used = 0;
+      for (size_type i = 0; i < old_capacity; ++i) {
+        if (occupied(i)) {
+          const size_type idx = _free_slot(*keys[i]);
+          if constexpr (is_trivially_relocatable_v<V>) {
+            std::memcpy(static_cast<void *>(_cells + idx),
+                        static_cast<const void *>(cells + i), sizeof(cell));
+          } else {
+            _cells[idx].build(std::move_if_noexcept(cells[i].get_ref()));
+          }
+          _keys[idx] = *keys[i];
+          ++_size;
+          ++_used;
+        }
+      }
+    } catch (...) {
+      if (allocated) {
+        for (size_type i = 0; i < capacity; ++i) {
+          if (_occupied(i)) {
+            _cells[i].destroy();
+          }
+        }
+        _deallocate(_keys, _cells, capacity);
+      }
+      _keys = keys;
+      _cells = cells;
+      _capacity = old_capacity;
+      _size = old_size;
+      _used = old_used;
+      throw;
+    }
+    // The old values are only destroyed once all of them were moved
+    if constexpr (!is_trivially_relocatable_v<V>) {
+      for (size_type i = 0; i < old_capacity; ++i) {
+        if (occupied(i)) {
+          cells[i].destroy();
+        }
+      }
+    }
+    _deallocate(keys, cells, old_capacity);
+  }
+};
+
+} // namespace dpsg
+
+#endif // GUARD_FLAT_MAP_HEADER
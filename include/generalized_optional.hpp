@@ -1,21 +1,214 @@
 #ifndef GUARD_GENERALIZED_OPTIONAL_HEADER
 #define GUARD_GENERALIZED_OPTIONAL_HEADER
 
+#include <cassert>
+#if defined(__cpp_impl_three_way_comparison)
+#include <compare>
+#endif
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <exception>
+#include <functional>
 #include <initializer_list>
 #include <limits>
+#include <memory>
+#include <new>
 #include <optional>
 #include <type_traits>
 #include <utility>
 
+// Storage of empty optionals poisoned by access::checked_in_debug
+#if defined(__SANITIZE_ADDRESS__)
+#define DPSG_OPTIONAL_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define DPSG_OPTIONAL_ASAN 1
+#endif
+#endif
+#if defined(DPSG_OPTIONAL_ASAN) && !defined(NDEBUG)
+#define DPSG_OPTIONAL_POISONING 1
+#include <sanitizer/asan_interface.h>
+#endif
+
 namespace dpsg {
 
 struct in_place_t {
 } constexpr static inline in_place;
 
+// Builds the value from the result of a callable, see emplace_with
+struct from_invoke_t {
+} constexpr static inline from_invoke;
+
+// Whether a T can be moved to another address, ending the lifetime of the
+// original, by copying its bytes. True for trivially copyable types, others
+// opt in by specializing it. Most types qualify, but not those pointing into
+// themselves, such as std::string in libstdc++ (short strings are stored in
+// the object).
+template <class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+template <class T, class D>
+struct is_trivially_relocatable<std::unique_ptr<T, D>>
+    : is_trivially_relocatable<D> {};
+template <class T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+template <class T>
+struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type {};
+template <class T>
+constexpr static inline bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+// Moves *src to dst, where no object lives, and ends the lifetime of *src
+template <class T>
+T *relocate_at(T *src, T *dst) noexcept(
+    is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    std::memcpy(static_cast<void *>(dst), static_cast<const void *>(src),
+                sizeof(T));
+    return std::launder(dst);
+  } else {
+    T *result = ::new (static_cast<void *>(dst)) T(std::move(*src));
+    src->~T();
+    return result;
+  }
+}
+
+// Relocates [first, last) to the uninitialized range starting at dst, which
+// must not overlap it. Returns the end of the destination range. If a move
+// throws, the elements already relocated are left at dst.
+template <class T>
+T *uninitialized_relocate(T *first, T *last, T *dst) noexcept(
+    is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    const auto count = static_cast<std::size_t>(last - first);
+    if (count > 0) {
+      std::memcpy(static_cast<void *>(dst), static_cast<const void *>(first),
+                  count * sizeof(T));
+    }
+    return dst + count;
+  } else {
+    for (; first != last; ++first, ++dst) {
+      relocate_at(first, dst);
+    }
+    return dst;
+  }
+}
+
 namespace detail {
 template <class T>
 using remove_cvref_t = std::remove_cv_t<std::remove_reference_t<T>>;
+
+// Values are built with parentheses, as std::optional does, unless T has no
+// matching constructor (aggregates before C++20).
+template <class T, class... Args>
+T *construct_at(void *where, Args &&... args) {
+  if constexpr (std::is_constructible_v<T, Args...>) {
+    return ::new (where) T(std::forward<Args>(args)...);
+  } else {
+    return ::new (where) T{std::forward<Args>(args)...};
+  }
+}
+// The prvalue returned by f initializes the value itself (guaranteed copy
+// elision), which needs not be movable.
+template <class T, class F>
+T *construct_at(void *where, [[maybe_unused]] from_invoke_t marker, F &&f) {
+  return ::new (where) T(std::forward<F>(f)());
+}
+
+// Same, as a prvalue
+template <class T, class... Args> constexpr T make(Args &&... args) {
+  if constexpr (std::is_constructible_v<T, Args...>) {
+    return T(std::forward<Args>(args)...);
+  } else {
+    return T{std::forward<Args>(args)...};
+  }
+}
+template <class T, class F>
+constexpr T make([[maybe_unused]] from_invoke_t marker, F &&f) {
+  return T(std::forward<F>(f)());
+}
+
+template <class T, class... Args> T *allocate(Args &&... args) {
+  if constexpr (std::is_constructible_v<T, Args...>) {
+    return new T(std::forward<Args>(args)...);
+  } else {
+    return new T{std::forward<Args>(args)...};
+  }
+}
+template <class T, class F>
+T *allocate([[maybe_unused]] from_invoke_t marker, F &&f) {
+  return new T(std::forward<F>(f)());
+}
+
+// Storage of storage::constexpr_union. Trivial when T is, otherwise copies and
+// destruction are left to generalized_optional, as for storage::pooled.
+template <class T>
+constexpr static inline bool trivial_slot =
+    std::is_trivially_copy_constructible_v<T> &&
+    std::is_trivially_move_constructible_v<T> &&
+    std::is_trivially_copy_assignable_v<T> &&
+    std::is_trivially_move_assignable_v<T> &&
+    std::is_trivially_destructible_v<T>;
+
+template <class T, bool = trivial_slot<T>> union union_slot {
+  char empty;
+  T value;
+
+  constexpr union_slot() noexcept : empty{} {}
+  template <class... Args>
+  constexpr explicit union_slot([[maybe_unused]] in_place_t marker,
+                                Args &&... args)
+      : value(make<T>(std::forward<Args>(args)...)) {}
+};
+
+template <class T> union union_slot<T, false> {
+  char empty;
+  T value;
+
+  constexpr union_slot() noexcept : empty{} {}
+  template <class... Args>
+  constexpr explicit union_slot([[maybe_unused]] in_place_t marker,
+                                Args &&... args)
+      : value(make<T>(std::forward<Args>(args)...)) {}
+  // NOLINTNEXTLINE(bugprone-copy-constructor-init)
+  constexpr union_slot([[maybe_unused]] const union_slot &other) noexcept
+      : empty{} {}
+  constexpr union_slot([[maybe_unused]] union_slot &&other) noexcept
+      : empty{} {}
+  // NOLINTNEXTLINE(cert-oop54-cpp)
+  constexpr union_slot &
+  operator=([[maybe_unused]] const union_slot &other) noexcept {
+    return *this;
+  }
+  constexpr union_slot &
+  operator=([[maybe_unused]] union_slot &&other) noexcept {
+    return *this;
+  }
+  ~union_slot() {}
+};
+
+template <class T, class... Args>
+struct assigns_on_emplace : std::false_type {};
+template <class T, class U>
+struct assigns_on_emplace<T, U>
+    : std::conjunction<std::is_same<remove_cvref_t<U>, T>,
+                       std::is_assignable<T &, U>> {};
+
+// T can be built from U. A reference only binds to an lvalue it can point to,
+// never to a temporary that would not outlive the optional.
+template <class T, class U>
+struct constructs_from : std::is_constructible<T, U> {};
+template <class T, class U>
+struct constructs_from<T &, U>
+    : std::conjunction<std::is_lvalue_reference<U>,
+                       std::is_convertible<std::remove_reference_t<U> *, T *>> {
+};
+
+// What the special members of generalized_optional copy: references are held
+// as pointers
+template <class T>
+using stored_t =
+    std::conditional_t<std::is_reference_v<T>, std::add_pointer_t<T>, T>;
 } // namespace detail
 
 namespace storage {
@@ -23,13 +216,18 @@ struct aligned {
   template <class B> class type : public B {
   private:
     using T = typename B::type;
-    static_assert(
-        !std::is_reference_v<T>,
-        "generalized_optional cannot contain a reference type. Store a "
-        "reference_wrapper or equivalent.");
+    static_assert(!std::is_reference_v<T>,
+                  "references are held by storage::reference");
+
+  public:
+    constexpr static inline bool relocatable = is_trivially_relocatable_v<T>;
+    constexpr static inline bool inline_value = true;
 
   protected:
-    std::aligned_storage_t<sizeof(T), alignof(T)> _storage;
+    // Not std::aligned_storage_t: behind the special member layers, GCC 12
+    // loses track of its union being typeless storage and at -O2 drops the
+    // stores of the payload before a copy of the whole optional.
+    alignas(T) unsigned char _storage[sizeof(T)];
 
     constexpr type() = default;
 
@@ -61,16 +259,122 @@ struct aligned {
       return reinterpret_cast<const T &>(_storage); // NOLINT
     }
     template <class... Args> constexpr void build(Args &&... args) {
-      ::new (&_storage) T{std::forward<Args>(args)...};
+      detail::construct_at<T>(&_storage, std::forward<Args>(args)...);
     }
     constexpr void destroy() noexcept { get_ref().~T(); }
   };
 };
 
+// The value as the member of a union, which constant expressions can build
+// and read, unlike the bytes of storage::aligned. Building a value in an
+// empty optional (emplace, assignment) is only possible in a constant
+// expression when T is trivially copyable, by assigning the whole union.
+struct constexpr_union {
+  template <class B> class type : public B {
+  private:
+    using T = typename B::type;
+    static_assert(!std::is_reference_v<T>,
+                  "references are held by storage::reference");
+
+  public:
+    constexpr static inline bool relocatable = is_trivially_relocatable_v<T>;
+    constexpr static inline bool inline_value = true;
+
+  protected:
+    detail::union_slot<T> _slot;
+
+    constexpr type() = default;
+
+    constexpr explicit type([[maybe_unused]] std::nullopt_t marker) {}
+
+    template <class... Args>
+    constexpr explicit type(
+        [[maybe_unused]] in_place_t marker,
+        Args &&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>)
+        : _slot(in_place, std::forward<Args>(args)...) {}
+
+    constexpr T *get_ptr() noexcept { return std::addressof(_slot.value); }
+    constexpr const T *get_ptr() const noexcept {
+      return std::addressof(_slot.value);
+    }
+    constexpr T &&get_ref() &&noexcept { return std::move(_slot.value); }
+    constexpr const T &&get_ref() const &&noexcept {
+      return std::move(_slot.value);
+    }
+    constexpr T &get_ref() &noexcept { return _slot.value; }
+    constexpr const T &get_ref() const &noexcept { return _slot.value; }
+    template <class... Args> constexpr void build(Args &&... args) {
+      if constexpr (detail::trivial_slot<T>) {
+        // Assigning the whole union changes its active member
+        _slot = detail::union_slot<T>(in_place, std::forward<Args>(args)...);
+      } else {
+        detail::construct_at<T>(std::addressof(_slot.value),
+                                std::forward<Args>(args)...);
+      }
+    }
+    constexpr void destroy() noexcept {
+      if constexpr (!std::is_trivially_destructible_v<T>) {
+        _slot.value.~T();
+      }
+    }
+  };
+};
+
+// An lvalue reference, held as a pointer which is null when empty (see
+// control::from_storage). As for a pointer, constness is shallow, and
+// assigning an engaged optional rebinds it instead of assigning the referred
+// object.
+struct reference {
+  template <class B> class type : public B {
+  private:
+    using T = typename B::type;
+    static_assert(std::is_lvalue_reference_v<T>,
+                  "storage::reference only holds lvalue references");
+    using U = std::remove_reference_t<T>;
+
+  public:
+    constexpr static inline bool relocatable = true;
+
+  protected:
+    U *_ptr = nullptr;
+
+    constexpr type() = default;
+
+    constexpr explicit type([[maybe_unused]] std::nullopt_t marker) {}
+
+    template <class... Args>
+    constexpr explicit type([[maybe_unused]] in_place_t marker,
+                            Args &&... args) {
+      build(std::forward<Args>(args)...);
+    }
+
+    [[nodiscard]] constexpr bool holds_value() const noexcept {
+      return _ptr != nullptr;
+    }
+
+    constexpr U *get_ptr() const noexcept { return _ptr; }
+    constexpr T get_ref() const noexcept { return *_ptr; }
+    template <class V> constexpr void build(V &&value) noexcept {
+      static_assert(detail::constructs_from<T, V>::value,
+                    "a reference cannot bind to a temporary");
+      T ref = value;
+      _ptr = std::addressof(ref);
+    }
+    template <class F>
+    constexpr void build([[maybe_unused]] from_invoke_t marker, F &&f) {
+      build(std::forward<F>(f)());
+    }
+    constexpr void destroy() noexcept { _ptr = nullptr; }
+  };
+};
+
 } // namespace storage
 
 // Policies
 
+// Several policies used as one. Flattened into the chain they are used in.
+template <class... Args> struct combine {};
+
 namespace detail {
 template <class T> struct extract_value_type_t;
 
@@ -82,8 +386,7 @@ struct extract_value_type_t<G<T, P...>> {
 template <class T>
 using extract_value_type = typename extract_value_type_t<T>::type;
 
-template <class... B> struct base;
-template <class T> struct base<T> {
+template <class T> struct root {
 protected:
   using type = extract_value_type<T>;
   constexpr T *self() noexcept { return static_cast<T *>(this); }
@@ -92,22 +395,136 @@ protected:
   }
 };
 
-template <class T, class A, class... Bs>
-struct base<T, A, Bs...> : A::template type<base<T, Bs...>> {
+// One policy applied on top of the rest of the chain. Policies are all
+// declared as a nested `type`, whose injected class name hides B::type:
+// re-export it here.
+template <class A, class B> struct layer : A::template type<B> {
 private:
-  using my_base = typename A::template type<base<T, Bs...>>;
+  using my_base = typename A::template type<B>;
 
 protected:
-  using type = extract_value_type<T>;
+  using type = typename B::type;
 
 public:
-  constexpr base() = default;
-  template <class... Args>
-  constexpr explicit base(Args &&... args) noexcept(
-      noexcept(std::is_nothrow_constructible_v<my_base, Args...>))
-      : my_base(std::forward<Args>(args)...) {}
+  using my_base::my_base;
+};
+
+template <class... Ts> struct type_list {};
+
+// Splices the policies of combine<...> in place, so that they end up as
+// layers of the main chain.
+template <class L, class... Ps> struct flatten;
+template <class... Rs> struct flatten<type_list<Rs...>> {
+  using type = type_list<Rs...>;
+};
+template <class... Rs, class... Cs, class... Ps>
+struct flatten<type_list<Rs...>, combine<Cs...>, Ps...>
+    : flatten<type_list<Rs...>, Cs..., Ps...> {};
+template <class... Rs, class P, class... Ps>
+struct flatten<type_list<Rs...>, P, Ps...>
+    : flatten<type_list<Rs..., P>, Ps...> {};
+
+template <class T, class L> struct compose;
+template <class T> struct compose<T, type_list<>> {
+  using type = root<T>;
+};
+template <class T, class P, class... Ps>
+struct compose<T, type_list<P, Ps...>> {
+  using type = layer<P, typename compose<T, type_list<Ps...>>::type>;
 };
 
+// Chain of policies of T, outermost first. base<T> alone is the root of the
+// chain.
+template <class T, class... Policies>
+using base = typename compose<
+    T, typename flatten<type_list<>, Policies...>::type>::type;
+
+} // namespace detail
+
+// Number of low bits that are always 0 in a valid value of T. Pointers to
+// object types get theirs from alignment, integer or enumeration handles can
+// declare theirs by specializing this template.
+template <class T, class = void>
+struct tag_bits : std::integral_constant<unsigned, 0> {};
+
+namespace detail {
+constexpr unsigned log2(std::size_t n) noexcept {
+  return n <= 1 ? 0 : 1 + log2(n / 2);
+}
+
+template <class T, class = void> struct is_complete : std::false_type {};
+template <class T>
+struct is_complete<T, std::void_t<decltype(sizeof(T))>> : std::true_type {};
+} // namespace detail
+
+template <class T>
+struct tag_bits<T *, std::enable_if_t<std::is_object_v<T> &&
+                                      detail::is_complete<T>::value>>
+    : std::integral_constant<unsigned, detail::log2(alignof(T))> {};
+
+template <class T>
+constexpr static inline unsigned tag_bits_v = tag_bits<T>::value;
+
+namespace detail {
+template <std::size_t N> struct unsigned_of_size;
+template <> struct unsigned_of_size<1> { using type = std::uint8_t; };
+template <> struct unsigned_of_size<2> { using type = std::uint16_t; };
+template <> struct unsigned_of_size<4> { using type = std::uint32_t; };
+template <> struct unsigned_of_size<8> { using type = std::uint64_t; };
+template <class T>
+using unsigned_of_size_t = typename unsigned_of_size<sizeof(T)>::type;
+
+// Storages that can hand their value over to another one (steal), and
+// controls that rely on it to implement moves
+template <class B, class = void> struct stealable : std::false_type {};
+template <class B>
+struct stealable<B, std::void_t<decltype(B::stealable)>>
+    : std::bool_constant<B::stealable> {};
+template <class B>
+constexpr static inline bool stealable_v = stealable<B>::value;
+
+// Policy chains whose objects can be relocated by copying their bytes. The
+// storage decides, controls referring to memory outside of the optional can
+// veto.
+template <class B, class = void> struct relocatable : std::false_type {};
+template <class B>
+struct relocatable<B, std::void_t<decltype(B::relocatable)>>
+    : std::bool_constant<B::relocatable> {};
+template <class B>
+constexpr static inline bool relocatable_v = relocatable<B>::value;
+
+template <class B, class = void> struct steals_on_move : std::false_type {};
+template <class B>
+struct steals_on_move<B, std::void_t<decltype(B::steals_on_move)>>
+    : std::bool_constant<B::steals_on_move> {};
+template <class B>
+constexpr static inline bool steals_on_move_v = steals_on_move<B>::value;
+
+// Chains whose storage holds the value inline (inline_value) and is not read
+// to know whether the optional is engaged (separate_presence): the storage of
+// empty optionals can then be poisoned
+template <class B, class = void> struct poisonable : std::false_type {};
+template <class B>
+struct poisonable<B, std::void_t<decltype(B::inline_value),
+                                 decltype(B::separate_presence)>>
+    : std::bool_constant<B::inline_value && B::separate_presence> {};
+template <class B>
+constexpr static inline bool poisonable_v = poisonable<B>::value;
+
+// Access policies that count the uses of the optional (access::counted),
+// including value_or
+template <class B, class = void> struct observes_access : std::false_type {};
+template <class B>
+struct observes_access<B, std::void_t<decltype(B::observes_access)>>
+    : std::bool_constant<B::observes_access> {};
+template <class B>
+constexpr static inline bool observes_access_v = observes_access<B>::value;
+
+template <class M> struct member_pointer_traits;
+template <class C, class M> struct member_pointer_traits<M C::*> {
+  using class_type = C;
+  using member_type = M;
+};
 } // namespace detail
 
 namespace control {
@@ -115,10 +532,13 @@ template <class T, T V = T{}> struct tombstone {
   template <class B> struct type : B {
     static_assert(std::is_same_v<T, typename B::type>,
                   "Type & tombstone mismatch");
+    constexpr static inline T tombstone_value = V;
+
     constexpr type() noexcept : B(in_place, V) {}
 
     template <class... Args>
-    constexpr explicit type(bool initial_value, Args &&... args)
+    constexpr explicit type([[maybe_unused]] bool initial_value,
+                            Args &&... args)
         : B(std::forward<Args>(args)...) {
       assert(initial_value || B::get_ref() == V);
     }
@@ -133,26 +553,35 @@ template <class T, T V = T{}> struct tombstone {
 };
 struct dependent_bool {
   template <class B> struct type : B {
+    constexpr static inline bool steals_on_move = detail::stealable_v<B>;
+    constexpr static inline bool separate_presence = true;
+
   protected:
     bool _has_value = false;
 
-    constexpr type() noexcept = default;
+    constexpr type() = default;
     template <class... Args>
     constexpr explicit type(bool initial_value, Args &&... args)
         : B(std::forward<Args>(args)...), _has_value(initial_value) {}
 
-    void reset() noexcept {
+    constexpr void reset() noexcept {
       B::destroy();
       _has_value = false;
     }
 
     template <class... Args>
-    void build(Args &&... args) noexcept(
+    constexpr void build(Args &&... args) noexcept(
         noexcept(B::build(std::forward<Args>(args)...))) {
       B::build(std::forward<Args>(args)...);
       _has_value = true;
     }
 
+    // Only used when the storage is stealable
+    void steal(type &other) noexcept {
+      B::steal(other);
+      _has_value = std::exchange(other._has_value, false);
+    }
+
   public:
     [[nodiscard]] constexpr bool has_value() const noexcept {
       return _has_value;
@@ -160,26 +589,256 @@ struct dependent_bool {
   };
 };
 
+// Presence is decided by the storage itself (holds_value), e.g. a null
+// pointer for out-of-line storage, which then needs no separate flag. When the
+// storage is stealable, moves transfer its value and leave the source empty.
+struct from_storage {
+  template <class B> struct type : B {
+    constexpr static inline bool steals_on_move = detail::stealable_v<B>;
+
+  protected:
+    constexpr type() = default;
+    template <class... Args>
+    constexpr explicit type([[maybe_unused]] bool initial_value,
+                            Args &&... args)
+        : B(std::forward<Args>(args)...) {
+      assert(initial_value == has_value());
+    }
+
+    constexpr void reset() noexcept { B::destroy(); }
+
+  public:
+    [[nodiscard]] constexpr bool has_value() const noexcept {
+      return B::holds_value();
+    }
+  };
+};
+
+// Tombstone compared on the object representation rather than with
+// operator!=. Required for floating point types, whose sentinel is a NaN and
+// therefore never compares equal to itself.
+template <class T, detail::unsigned_of_size_t<T> Bits>
+struct bitwise_tombstone {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "bitwise tombstones must be trivially copyable");
+
+  template <class B> struct type : B {
+    static_assert(std::is_same_v<T, typename B::type>,
+                  "Type & tombstone mismatch");
+    using bits_type = detail::unsigned_of_size_t<T>;
+    constexpr static inline bits_type tombstone_bits = Bits;
+
+  private:
+    void _mark_empty() noexcept {
+      std::memcpy(B::get_ptr(), &tombstone_bits, sizeof(bits_type));
+    }
+
+  public:
+    type() noexcept { _mark_empty(); }
+
+    template <class... Args>
+    explicit type([[maybe_unused]] bool initial_value, Args &&... args)
+        : B(std::forward<Args>(args)...) {
+      assert(initial_value == has_value());
+    }
+
+    [[nodiscard]] bool has_value() const noexcept {
+      bits_type bits;
+      std::memcpy(&bits, B::get_ptr(), sizeof(bits_type));
+      return bits != Bits;
+    }
+
+  protected:
+    void reset() noexcept { _mark_empty(); }
+  };
+};
+
+// Tombstone stored in a single data member of T. Only that member is written
+// when the optional is emptied, the rest of the object is left
+// uninitialized.
+//
+// As for other tombstones, an engaged value whose member holds the sentinel
+// is seen as empty, and its destructor is never run.
+//
+// While empty there is no object of class_type, only its storage. The member
+// is never read or written as such: its address is computed, as offsetof
+// would, and its bytes are copied. The class must be standard-layout for
+// that address to be meaningful.
+template <auto Member, auto V> struct member_tombstone {
+  using class_type =
+      typename detail::member_pointer_traits<decltype(Member)>::class_type;
+  using member_type =
+      typename detail::member_pointer_traits<decltype(Member)>::member_type;
+  static_assert(std::is_trivially_copyable_v<member_type> &&
+                    std::is_trivially_destructible_v<member_type>,
+                "member tombstones must be trivial");
+  static_assert(std::is_standard_layout_v<class_type>,
+                "member tombstones need a standard-layout class");
+
+  template <class B> struct type : B {
+    static_assert(std::is_same_v<class_type, typename B::type>,
+                  "Type & member tombstone mismatch");
+    constexpr static inline member_type member_tombstone_value =
+        static_cast<member_type>(V);
+
+  private:
+    void _mark_empty() noexcept {
+      std::memcpy(std::addressof(B::get_ptr()->*Member),
+                  &member_tombstone_value, sizeof(member_type));
+    }
+
+  public:
+    type() noexcept { _mark_empty(); }
+
+    template <class... Args>
+    explicit type([[maybe_unused]] bool initial_value, Args &&... args)
+        : B(std::forward<Args>(args)...) {
+      assert(initial_value == has_value());
+    }
+
+    [[nodiscard]] bool has_value() const noexcept {
+      member_type member;
+      std::memcpy(&member, std::addressof(B::get_ptr()->*Member),
+                  sizeof(member_type));
+      return member != member_tombstone_value;
+    }
+
+  protected:
+    void reset() noexcept {
+      B::destroy();
+      _mark_empty();
+    }
+  };
+};
+
+// Uses the lowest always-0 bit of T as the empty marker (see tag_bits). The
+// optional has the size of T, engaged values are stored untouched, so every
+// value of T (including nullptr) can be held and no masking is needed to
+// access it.
+template <class T> struct tagged {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "tagged values must be trivially copyable");
+  static_assert(tag_bits_v<T> > 0,
+                "T has no spare low bit. Pointed-to types must be aligned on "
+                "at least 2 bytes, handle types must specialize tag_bits");
+
+  template <class B> struct type : B {
+    static_assert(std::is_same_v<T, typename B::type>, "Type & tag mismatch");
+
+  private:
+    using word = detail::unsigned_of_size_t<T>;
+    constexpr static inline word empty_marker = 1;
+
+    [[nodiscard]] word _bits() const noexcept {
+      word result;
+      std::memcpy(&result, B::get_ptr(), sizeof(word));
+      return result;
+    }
+
+    void _mark_empty() noexcept {
+      std::memcpy(B::get_ptr(), &empty_marker, sizeof(word));
+    }
+
+  public:
+    type() noexcept { _mark_empty(); }
+
+    template <class... Args>
+    explicit type([[maybe_unused]] bool initial_value, Args &&... args)
+        : B(std::forward<Args>(args)...) {
+      assert(initial_value == has_value() && "misaligned tagged value");
+    }
+
+    [[nodiscard]] bool has_value() const noexcept {
+      return (_bits() & empty_marker) == 0;
+    }
+
+  protected:
+    void reset() noexcept { _mark_empty(); }
+
+    template <class... Args>
+    void build(Args &&... args) noexcept(
+        noexcept(B::build(std::forward<Args>(args)...))) {
+      B::build(std::forward<Args>(args)...);
+      assert(has_value() && "misaligned tagged value");
+    }
+  };
+};
+
 } // namespace control
 
 // Utilities
 struct bad_optional_access : std::exception {
-  [[nodiscard]] const char *what() const override {
+  [[nodiscard]] const char *what() const noexcept override {
     return "bad optional access";
   }
 };
 
-template <class... Args> struct combine {
-  template <class B> struct type;
+namespace detail {
+#if defined(DPSG_OPTIONAL_POISONING)
+constexpr static inline bool poisoning_enabled = true;
+#else
+constexpr static inline bool poisoning_enabled = false;
+#endif
+
+// Poisons the storage of empty optionals, see access::checked_in_debug
+template <class B, bool = poisoning_enabled && poisonable_v<B>>
+class poisoning : public B {
+public:
+  using B::B;
+};
+
+#if defined(DPSG_OPTIONAL_POISONING)
+// Copies and destruction are left to generalized_optional, as for
+// storage::pooled: the special members below only keep them from reading the
+// poisoned bytes.
+template <class B> class poisoning<B, true> : public B {
+  using T = typename B::type;
 
-  template <template <class...> class B, class T, class... Rs>
-  struct type<B<T, Rs...>> : B<T, Args..., Rs...> {
-    template <class... Args2>
-    constexpr explicit type(Args2 &&... args) noexcept(
-        noexcept(B<T, Args..., Rs...>(std::forward<Args2>(args)...)))
-        : B<T, Args..., Rs...>(std::forward<Args2>(args)...) {}
-  };
+  void _poison() noexcept {
+    __asan_poison_memory_region(B::get_ptr(), sizeof(T));
+  }
+  void _unpoison() noexcept {
+    __asan_unpoison_memory_region(B::get_ptr(), sizeof(T));
+  }
+
+public:
+  // Moving the whole object would read the poisoned bytes
+  constexpr static inline bool relocatable = false;
+
+  using B::B;
+  poisoning() noexcept { _poison(); }
+  template <class... Args>
+  explicit poisoning(bool initial_value, Args &&... args)
+      : B(initial_value, std::forward<Args>(args)...) {
+    if (!B::has_value()) {
+      _poison();
+    }
+  }
+  // NOLINTNEXTLINE(bugprone-copy-constructor-init)
+  poisoning([[maybe_unused]] const poisoning &other) noexcept : poisoning() {}
+  poisoning([[maybe_unused]] poisoning &&other) noexcept : poisoning() {}
+  // NOLINTNEXTLINE(cert-oop54-cpp)
+  poisoning &operator=([[maybe_unused]] const poisoning &other) noexcept {
+    return *this;
+  }
+  poisoning &operator=([[maybe_unused]] poisoning &&other) noexcept {
+    return *this;
+  }
+  ~poisoning() { _unpoison(); }
+
+protected:
+  template <class... Args> void build(Args &&... args) {
+    _unpoison();
+    B::build(std::forward<Args>(args)...);
+  }
+
+  void reset() noexcept {
+    B::reset();
+    _poison();
+  }
 };
+#endif
+} // namespace detail
 
 // Access Control
 
@@ -190,10 +849,7 @@ struct unchecked_value {
     using T = typename B::type;
 
   public:
-    template <class... Args>
-    constexpr explicit type(Args &&... args) noexcept(
-        noexcept(B(std::forward<Args>(args)...)))
-        : B(std::forward<Args>(args)...) {}
+    using B::B;
     constexpr T &value() &noexcept { return B::get_ref(); }
     constexpr const T &value() const &noexcept { return B::get_ref(); }
     constexpr T &&value() &&noexcept {
@@ -209,14 +865,15 @@ struct unchecked_deref {
   template <class B> struct type : B {
   private:
     using T = typename B::type;
+    using pointer = std::add_pointer_t<T>;
+    using const_pointer = std::add_pointer_t<const T>;
 
   public:
-    template <class... Args>
-    constexpr explicit type(Args &&... args) noexcept(
-        noexcept(B(std::forward<Args>(args)...)))
-        : B(std::forward<Args>(args)...) {}
-    constexpr const T *operator->() const noexcept { return B::get_ptr(); }
-    constexpr T *operator->() noexcept { return B::get_ptr(); }
+    using B::B;
+    constexpr const_pointer operator->() const noexcept {
+      return B::get_ptr();
+    }
+    constexpr pointer operator->() noexcept { return B::get_ptr(); }
     constexpr const T &operator*() const &noexcept { return B::get_ref(); }
     constexpr T &operator*() &noexcept { return B::get_ref(); }
     constexpr const T &&operator*() const &&noexcept {
@@ -232,21 +889,20 @@ struct throw_exception_deref {
   template <class B> struct type : B {
   private:
     using T = typename B::type;
+    using pointer = std::add_pointer_t<T>;
+    using const_pointer = std::add_pointer_t<const T>;
 
   public:
-    template <class... Args>
-    constexpr explicit type(Args &&... args) noexcept(
-        noexcept(B(std::forward<Args>(args)...)))
-        : B(std::forward<Args>(args)...) {}
+    using B::B;
 
-    constexpr const T *operator->() const {
+    constexpr const_pointer operator->() const {
       if (B::has_value()) {
         return B::get_ptr();
       }
       throw bad_optional_access{};
     }
 
-    constexpr T *operator->() {
+    constexpr pointer operator->() {
       if (B::has_value()) {
         return B::get_ptr();
       }
@@ -289,10 +945,7 @@ struct throw_exception_value {
     using T = typename B::type;
 
   public:
-    template <class... Args>
-    constexpr explicit type(Args &&... args) noexcept(
-        noexcept(B(std::forward<Args>(args)...)))
-        : B(std::forward<Args>(args)...) {}
+    using B::B;
 
     constexpr T &value() & {
       if (B::has_value()) {
@@ -326,10 +979,7 @@ struct throw_exception_value {
 
 struct functional {
   template <class B> struct type : B {
-    template <class... Args>
-    constexpr explicit type(Args &&... args) noexcept(
-        noexcept(B(std::forward<Args>(args)...)))
-        : B(std::forward<Args>(args)...) {}
+    using B::B;
 
     template <class U, class F>
     [[nodiscard]] constexpr U with_value(F &&func, U &&default_value) const & {
@@ -342,7 +992,8 @@ struct functional {
     template <class U, class F>
     [[nodiscard]] constexpr U with_value(F &&func, U &&default_value) && {
       if (B::has_value()) {
-        return std::forward<F>(func)(std::move(B::get_ref()));
+        return std::forward<F>(func)(
+            static_cast<type &&>(*this).B::get_ref());
       }
       return std::forward<U>(default_value);
     }
@@ -355,7 +1006,7 @@ struct functional {
 
     template <class F> constexpr void with_value(F &&func) && {
       if (B::has_value()) {
-        std::forward<F>(func)(std::move(B::get_ref()));
+        std::forward<F>(func)(static_cast<type &&>(*this).B::get_ref());
       }
     }
   };
@@ -372,20 +1023,277 @@ using extended = combine<functional, standard>;
 using extended_unchecked = combine<functional, unchecked>;
 
 using extended_throw = combine<functional, throw_exception>;
+
+// unchecked in NDEBUG builds. Otherwise value(), operator* and operator->
+// assert that the optional is engaged and, under AddressSanitizer, the
+// storage of empty optionals is poisoned, so that references kept past a
+// reset are reported as well.
+#if defined(NDEBUG)
+using checked_in_debug = unchecked;
+#else
+struct checked_in_debug {
+  template <class B> struct type : detail::poisoning<B> {
+  private:
+    using base = detail::poisoning<B>;
+    using T = typename B::type;
+    using pointer = std::add_pointer_t<T>;
+    using const_pointer = std::add_pointer_t<const T>;
+
+  public:
+    using base::base;
+
+    constexpr T &value() &noexcept {
+      assert(base::has_value());
+      return base::get_ref();
+    }
+    constexpr const T &value() const &noexcept {
+      assert(base::has_value());
+      return base::get_ref();
+    }
+    constexpr T &&value() &&noexcept {
+      assert(base::has_value());
+      return static_cast<type &&>(*this).base::get_ref();
+    }
+    constexpr const T &&value() const &&noexcept {
+      assert(base::has_value());
+      return static_cast<const type &&>(*this).base::get_ref();
+    }
+
+    constexpr pointer operator->() noexcept {
+      assert(base::has_value());
+      return base::get_ptr();
+    }
+    constexpr const_pointer operator->() const noexcept {
+      assert(base::has_value());
+      return base::get_ptr();
+    }
+    constexpr T &operator*() &noexcept {
+      assert(base::has_value());
+      return base::get_ref();
+    }
+    constexpr const T &operator*() const &noexcept {
+      assert(base::has_value());
+      return base::get_ref();
+    }
+    constexpr T &&operator*() &&noexcept {
+      assert(base::has_value());
+      return static_cast<type &&>(*this).base::get_ref();
+    }
+    constexpr const T &&operator*() const &&noexcept {
+      assert(base::has_value());
+      return static_cast<const type &&>(*this).base::get_ref();
+    }
+  };
+};
+#endif
+
+using extended_checked_in_debug = combine<functional, checked_in_debug>;
 } // namespace access
 
 struct nullopt_t {
 } constexpr static inline nullopt;
 
+namespace detail {
+// Special members of generalized_optional. Each of them is only user-provided
+// when either the payload or one of the policies requires it, so that an
+// optional of a trivial type is itself trivial. A policy that cannot be
+// copied or moved (e.g. one holding an atomic) keeps the matching members
+// deleted.
+
+template <class B, class T,
+          bool = std::is_trivially_destructible_v<T>
+              &&std::is_trivially_destructible_v<B>>
+struct destructor_layer : B {
+  using B::B;
+};
+
+template <class B, class T> struct destructor_layer<B, T, false> : B {
+  using B::B;
+  constexpr destructor_layer() = default;
+  constexpr destructor_layer(const destructor_layer &) = default;
+  constexpr destructor_layer(destructor_layer &&) = default;
+  constexpr destructor_layer &operator=(const destructor_layer &) = default;
+  constexpr destructor_layer &
+  operator=(destructor_layer &&) = default;
+  ~destructor_layer() {
+    if (B::has_value()) {
+      B::destroy();
+    }
+  }
+};
+
+template <class B, class T,
+          bool = (std::is_trivially_copy_constructible_v<T> &&
+                  std::is_trivially_copy_constructible_v<B>) ||
+                 !std::is_copy_constructible_v<B>>
+struct copy_ctor_layer : destructor_layer<B, T> {
+  using destructor_layer<B, T>::destructor_layer;
+};
+
+template <class B, class T>
+struct copy_ctor_layer<B, T, false> : destructor_layer<B, T> {
+private:
+  using base = destructor_layer<B, T>;
+
+public:
+  using base::base;
+  constexpr copy_ctor_layer() = default;
+  constexpr copy_ctor_layer(const copy_ctor_layer &other) noexcept(
+      std::is_nothrow_copy_constructible_v<T>)
+      : base() {
+    if (other.has_value()) {
+      base::build(other.get_ref());
+    }
+  }
+  constexpr copy_ctor_layer(copy_ctor_layer &&) = default;
+  constexpr copy_ctor_layer &operator=(const copy_ctor_layer &) = default;
+  constexpr copy_ctor_layer &operator=(copy_ctor_layer &&) = default;
+  ~copy_ctor_layer() = default;
+};
+
+template <class B, class T,
+          bool = (std::is_trivially_move_constructible_v<T> &&
+                  std::is_trivially_move_constructible_v<B>) ||
+                 !std::is_move_constructible_v<B>>
+struct move_ctor_layer : copy_ctor_layer<B, T> {
+  using copy_ctor_layer<B, T>::copy_ctor_layer;
+};
+
+template <class B, class T>
+struct move_ctor_layer<B, T, false> : copy_ctor_layer<B, T> {
+private:
+  using base = copy_ctor_layer<B, T>;
+
+public:
+  using base::base;
+  constexpr move_ctor_layer() = default;
+  constexpr move_ctor_layer(const move_ctor_layer &) = default;
+  constexpr move_ctor_layer(move_ctor_layer &&other) noexcept(
+      std::is_nothrow_move_constructible_v<T> || steals_on_move_v<B>)
+      : base() {
+    if constexpr (steals_on_move_v<B>) {
+      base::steal(other);
+    } else if (other.has_value()) {
+      base::build(std::move(other).get_ref());
+    }
+  }
+  constexpr move_ctor_layer &operator=(const move_ctor_layer &) = default;
+  constexpr move_ctor_layer &operator=(move_ctor_layer &&) = default;
+  ~move_ctor_layer() = default;
+};
+
+template <class B, class T,
+          bool = (std::is_trivially_copy_constructible_v<T> &&
+                  std::is_trivially_copy_assignable_v<T> &&
+                  std::is_trivially_destructible_v<T> &&
+                  std::is_trivially_copy_assignable_v<B>) ||
+                 !std::is_copy_assignable_v<B>>
+struct copy_assign_layer : move_ctor_layer<B, T> {
+  using move_ctor_layer<B, T>::move_ctor_layer;
+};
+
+template <class B, class T>
+struct copy_assign_layer<B, T, false> : move_ctor_layer<B, T> {
+private:
+  using base = move_ctor_layer<B, T>;
+
+public:
+  using base::base;
+  constexpr copy_assign_layer() = default;
+  constexpr copy_assign_layer(const copy_assign_layer &) = default;
+  constexpr copy_assign_layer(copy_assign_layer &&) = default;
+  constexpr copy_assign_layer &operator=(const copy_assign_layer &other) {
+    if (std::addressof(other) == this) {
+      return *this;
+    }
+    if (other.has_value()) {
+      if (base::has_value()) {
+        base::get_ref() = other.get_ref();
+      } else {
+        base::build(other.get_ref());
+      }
+    } else if (base::has_value()) {
+      base::reset();
+    }
+    return *this;
+  }
+  constexpr copy_assign_layer &
+  operator=(copy_assign_layer &&) = default;
+  ~copy_assign_layer() = default;
+};
+
+template <class B, class T,
+          bool = (std::is_trivially_move_constructible_v<T> &&
+                  std::is_trivially_move_assignable_v<T> &&
+                  std::is_trivially_destructible_v<T> &&
+                  std::is_trivially_move_assignable_v<B>) ||
+                 !std::is_move_assignable_v<B>>
+struct move_assign_layer : copy_assign_layer<B, T> {
+  using copy_assign_layer<B, T>::copy_assign_layer;
+};
+
+template <class B, class T>
+struct move_assign_layer<B, T, false> : copy_assign_layer<B, T> {
+private:
+  using base = copy_assign_layer<B, T>;
+
+public:
+  using base::base;
+  constexpr move_assign_layer() = default;
+  constexpr move_assign_layer(const move_assign_layer &) = default;
+  constexpr move_assign_layer(move_assign_layer &&) = default;
+  constexpr move_assign_layer &operator=(const move_assign_layer &) = default;
+  constexpr move_assign_layer &operator=(move_assign_layer &&other) noexcept(
+      (std::is_nothrow_move_assignable_v<T> &&
+       std::is_nothrow_move_constructible_v<T>) ||
+      steals_on_move_v<B>) {
+    if constexpr (steals_on_move_v<B>) {
+      if (std::addressof(other) != this) {
+        if (base::has_value()) {
+          base::reset();
+        }
+        base::steal(other);
+      }
+      return *this;
+    }
+    if (other.has_value()) {
+      if (base::has_value()) {
+        base::get_ref() = std::move(other).get_ref();
+      } else {
+        base::build(std::move(other).get_ref());
+      }
+    } else if (base::has_value()) {
+      base::reset();
+    }
+    return *this;
+  }
+  ~move_assign_layer() = default;
+};
+
+template <class B, class T> using special_members = move_assign_layer<B, T>;
+
+struct optional_access;
+} // namespace detail
+
 template <class T, class Policy>
-class generalized_optional : public Policy::template type<T> {
+class generalized_optional
+    : public detail::special_members<typename Policy::template type<T>,
+                                     detail::stored_t<T>> {
 public:
   using value_type = T;
 
 private:
-  using base = typename Policy::template type<T>;
+  template <class U, class P> friend class generalized_optional;
+  friend detail::optional_access;
+  using base = detail::special_members<typename Policy::template type<T>,
+                                       detail::stored_t<T>>;
   using policy = base;
   using storage = base;
+  // Conversions from other optionals must not hide the (possibly deleted)
+  // special members
+  template <class U, class P>
+  using is_other_optional = std::negation<
+      std::is_same<generalized_optional<U, P>, generalized_optional>>;
   constexpr void _clean() noexcept(std::is_nothrow_destructible_v<value_type>) {
     if (has_value()) {
       storage::reset();
@@ -397,31 +1305,41 @@ private:
   }
   constexpr void
   _move(T &&t) noexcept(std::is_nothrow_move_constructible_v<value_type>) {
-    storage::build(std::move(t));
+    storage::build(std::forward<T>(t));
+  }
+  // References rebind rather than assign the object they refer to
+  template <class U> constexpr void _assign(U &&value) {
+    if constexpr (std::is_reference_v<T>) {
+      storage::build(std::forward<U>(value));
+    } else {
+      storage::get_ref() = std::forward<U>(value);
+    }
   }
+  // A copy for references, the default value would not outlive the call
+  using value_or_type =
+      std::conditional_t<std::is_reference_v<T>, detail::remove_cvref_t<T>, T>;
 
 public:
   using policy::has_value;
-  constexpr generalized_optional() noexcept = default;
+
+  // Payloads stored in the optional must be trivially relocatable, those
+  // stored out of line always are (only their pointer moves)
+  constexpr static inline bool trivially_relocatable =
+      detail::relocatable_v<base>;
+
+  constexpr generalized_optional() = default;
 
   // NOLINTNEXTLINE
   constexpr generalized_optional([
       [maybe_unused]] nullopt_t empty_ctor) noexcept {}
 
-  constexpr generalized_optional(const generalized_optional &other) noexcept(
-      std::is_nothrow_copy_constructible_v<T>) {
-    if (other.has_value()) {
-      _copy(other.get_ref());
-    }
-  }
-  constexpr generalized_optional(generalized_optional &&other) noexcept(
-      std::is_nothrow_move_constructible_v<T>) {
-    if (other.has_value()) {
-      _move(std::move(other).get_ref());
-    }
-  }
+  constexpr generalized_optional(const generalized_optional &other) = default;
+  constexpr generalized_optional(generalized_optional &&other) = default;
   template <class U, class P,
-            std::enable_if_t<std::is_constructible_v<T, U>> = 0>
+            std::enable_if_t<
+                std::conjunction_v<is_other_optional<U, P>,
+                                   detail::constructs_from<T, const U &>>,
+                int> = 0>
   // NOLINTNEXTLINE
   generalized_optional(const generalized_optional<U, P> &other) noexcept(
       std::is_nothrow_constructible_v<T, U>) {
@@ -429,7 +1347,11 @@ public:
       _copy(other.get_ref());
     }
   }
-  template <class U, class P>
+  template <class U, class P,
+            std::enable_if_t<
+                std::conjunction_v<is_other_optional<U, P>,
+                                   detail::constructs_from<T, U &&>>,
+                int> = 0>
   // NOLINTNEXTLINE
   generalized_optional(generalized_optional<U, P> &&other) noexcept(
       std::is_nothrow_constructible_v<T, U>) {
@@ -437,18 +1359,34 @@ public:
       _move(std::move(other).get_ref());
     }
   }
+  // References never bind to the value of an expiring optional, which the
+  // const & overload would otherwise accept
+  template <class U, class P,
+            std::enable_if_t<
+                std::conjunction_v<
+                    std::is_reference<T>, is_other_optional<U, P>,
+                    std::negation<detail::constructs_from<T, U &&>>>,
+                int> = 0>
+  generalized_optional(generalized_optional<U, P> &&other) = delete;
   template <class... Args>
   constexpr explicit generalized_optional(
-      [[maybe_unused]] in_place_t in_place_ctor, Args &&... args)
+      [[maybe_unused]] in_place_t in_place_ctor,
+      Args &&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>)
       : base(true, in_place, std::forward<Args>(args)...) {}
 
+  // Holds the result of f(), which T needs not be able to copy nor move
+  template <class F>
+  constexpr explicit generalized_optional(
+      [[maybe_unused]] from_invoke_t from_invoke_ctor, F &&f)
+      : base(true, in_place, from_invoke, std::forward<F>(f)) {}
+
 private:
   template <class Ty>
   using allow_direct_conversion = std::bool_constant<std::conjunction_v<
       std::negation<
           std::is_same<detail::remove_cvref_t<Ty>, generalized_optional>>,
       std::negation<std::is_same<detail::remove_cvref_t<Ty>, in_place_t>>,
-      std::is_constructible<value_type, Ty>>>;
+      detail::constructs_from<value_type, Ty>>>;
 
 public:
   template <
@@ -457,7 +1395,8 @@ public:
                                           std::is_convertible<U, value_type>>,
                        int> = 0>
   // NOLINTNEXTLINE
-  constexpr generalized_optional(U &&value)
+  constexpr generalized_optional(U &&value) noexcept(
+      std::is_nothrow_constructible_v<T, U>)
       : base(true, in_place, std::forward<U>(value)) {}
 
   template <
@@ -467,69 +1406,44 @@ public:
                              std::negation<std::is_convertible<U, value_type>>>,
           int> = 0>
   // NOLINTNEXTLINE
-  constexpr explicit generalized_optional(U &&value)
+  constexpr explicit generalized_optional(U &&value) noexcept(
+      std::is_nothrow_constructible_v<T, U>)
       : base(true, in_place, std::forward<U>(value)) {}
 
-  ~generalized_optional() {
-    if (base::has_value()) {
-      base::destroy();
-    }
-  }
+  ~generalized_optional() = default;
 
-  generalized_optional &operator=([
+  constexpr generalized_optional &operator=([
       [maybe_unused]] nullopt_t empty_assignment) noexcept {
     _clean();
-  }
-
-  constexpr generalized_optional &operator=(const generalized_optional &other) {
-    if (std::addressof(other) == this) {
-      return *this;
-    }
-    if (other.has_value()) {
-      if (has_value()) {
-        storage::get_ref() = other.get_ref();
-      } else {
-        _copy(other.get_ref());
-      }
-    } else {
-      _clean();
-    }
     return *this;
   }
 
   constexpr generalized_optional &
-  operator=(generalized_optional &&other) noexcept(
-      std::is_nothrow_move_assignable<T>::value
-          &&std::is_nothrow_move_constructible<T>::value) {
-    if (other.has_value()) {
-      if (has_value()) {
-        storage::get_ref() = std::move(other).get_ref();
-      } else {
-        _move(std::move(other).get_ref());
-      }
-    } else {
-      _clean();
-    }
-    return *this;
-  }
+  operator=(const generalized_optional &other) = default;
+  constexpr generalized_optional &
+  operator=(generalized_optional &&other) = default;
 
   template <class U = value_type,
             std::enable_if_t<allow_direct_conversion<U>::value, int> = 0>
   constexpr generalized_optional &operator=(U &&value) {
     if (has_value()) {
-      storage::get_ref() = std::forward<U>(value);
+      _assign(std::forward<U>(value));
     } else {
       storage::build(std::forward<U>(value));
     }
     return *this;
   }
 
-  template <class U, class P>
+  template <class U, class P,
+            std::enable_if_t<
+                std::conjunction_v<is_other_optional<U, P>,
+                                   detail::constructs_from<T, const U &>>,
+                int> = 0>
   constexpr generalized_optional &
   operator=(const generalized_optional<U, P> &other) {
     if (other.has_value()) {
       if (has_value()) {
-        storage::get_ref() = other.get_ref();
+        _assign(other.get_ref());
       } else {
         _copy(other.get_ref());
       }
@@ -539,42 +1453,70 @@ public:
     return *this;
   }
 
-  template <class U, class P>
+  template <class U, class P,
+            std::enable_if_t<
+                std::conjunction_v<is_other_optional<U, P>,
+                                   detail::constructs_from<T, U &&>>,
+                int> = 0>
   constexpr generalized_optional &
   operator=(generalized_optional<U, P> &&other) {
     if (other.has_value()) {
       if (has_value()) {
-        storage::get_ref() = std::move(other).get_ref();
+        _assign(std::move(other).get_ref());
       } else {
         _move(std::move(other).get_ref());
       }
     } else {
       _clean();
     }
+    return *this;
   }
+  template <class U, class P,
+            std::enable_if_t<
+                std::conjunction_v<
+                    std::is_reference<T>, is_other_optional<U, P>,
+                    std::negation<detail::constructs_from<T, U &&>>>,
+                int> = 0>
+  generalized_optional &operator=(generalized_optional<U, P> &&other) = delete;
 
   constexpr explicit operator bool() const noexcept {
     return base::has_value();
   }
 
-  template <class U> constexpr T value_or(U &&default_value) const & {
+  template <class U>
+  constexpr value_or_type value_or(U &&default_value) const & {
+    if constexpr (detail::observes_access_v<base>) {
+      base::_on_access(has_value());
+    }
     if (has_value()) {
       return storage::get_ref();
     }
-    return static_cast<T>(std::forward<U>(default_value));
+    return static_cast<value_or_type>(std::forward<U>(default_value));
   }
-  template <class U> constexpr T value_or(U &&default_value) && {
+  template <class U> constexpr value_or_type value_or(U &&default_value) && {
+    if constexpr (detail::observes_access_v<base>) {
+      base::_on_access(has_value());
+    }
     if (has_value()) {
       return storage::get_ref();
     }
-    return static_cast<T>(std::forward<U>(default_value));
+    return static_cast<value_or_type>(std::forward<U>(default_value));
   }
 
   void swap(generalized_optional &other) noexcept(
-      std::is_nothrow_move_constructible_v<T>
-          &&std::is_nothrow_swappable_v<T>) {
+      trivially_relocatable || (std::is_nothrow_move_constructible_v<T> &&
+                                std::is_nothrow_swappable_v<T>)) {
     using namespace std;
-    if (has_value()) {
+    if constexpr (trivially_relocatable) {
+      // Whole objects, presence included
+      if (this != std::addressof(other)) {
+        alignas(generalized_optional) unsigned char tmp[sizeof(*this)];
+        std::memcpy(tmp, static_cast<void *>(this), sizeof(*this));
+        std::memcpy(static_cast<void *>(this), static_cast<void *>(&other),
+                    sizeof(*this));
+        std::memcpy(static_cast<void *>(&other), tmp, sizeof(*this));
+      }
+    } else if (has_value()) {
       if (other.has_value()) {
         value_type tmp = std::move(storage::get_ref());
         storage::get_ref() = std::move(other).get_ref();
@@ -591,34 +1533,420 @@ public:
 
   friend void
   swap(generalized_optional &lhv, generalized_optional &rhv) noexcept(
-      std::is_nothrow_move_constructible_v<T>
-          &&std::is_nothrow_swappable_v<T>) {
+      noexcept(lhv.swap(rhv))) {
     lhv.swap(rhv);
   }
 
-  void reset() noexcept { _clean(); }
-  template <class... Args> T &emplace(Args &&... args) {
-    if (has_value()) {
-      storage::destroy();
+  constexpr void reset() noexcept { _clean(); }
+  // Emplacing a T in an engaged optional assigns it, as operator= does,
+  // rather than destroying the value and building it again
+  template <class... Args> constexpr T &emplace(Args &&... args) {
+    if constexpr (detail::assigns_on_emplace<T, Args...>::value) {
+      if (has_value()) {
+        _assign(std::forward<Args>(args)...);
+        return storage::get_ref();
+      }
     }
+    _clean();
     storage::build(std::forward<Args>(args)...);
     return storage::get_ref();
   }
 
   template <class U, class... Args>
-  T &emplace(std::initializer_list<U> ilist, Args &&... args) {
-    if (has_value()) {
-      storage::destroy();
-    }
+  constexpr T &emplace(std::initializer_list<U> ilist, Args &&... args) {
+    _clean();
     storage::build(std::move(ilist), std::forward<Args>(args)...);
     return storage::get_ref();
   }
+
+  // Engages the optional with the result of f(), built directly in place
+  template <class F> constexpr T &emplace_with(F &&f) {
+    _clean();
+    storage::build(from_invoke, std::forward<F>(f));
+    return storage::get_ref();
+  }
+};
+
+template <class T, class P>
+struct is_trivially_relocatable<generalized_optional<T, P>>
+    : std::bool_constant<generalized_optional<T, P>::trivially_relocatable> {};
+
+namespace detail {
+// Payload of an optional whatever its access policy, for the comparisons and
+// std::hash. Only valid when engaged, or when compare_traits::readable.
+struct optional_access {
+  template <class T, class P>
+  constexpr static const T &
+  payload(const generalized_optional<T, P> &opt) noexcept {
+    return opt.get_ref();
+  }
+};
+
+// Optionals shared between threads (see atomic_optional.hpp) are never read
+// in place by the comparisons and std::hash, which work on a snapshot taken
+// with a single acquire load instead.
+template <class O, class = void> struct has_snapshot : std::false_type {};
+template <class O>
+struct has_snapshot<O, std::void_t<typename O::snapshot>> : std::true_type {};
+
+template <class O> constexpr decltype(auto) stable_view(const O &opt) {
+  if constexpr (has_snapshot<O>::value) {
+    return opt.load();
+  } else {
+    return (opt);
+  }
+}
+
+template <class O>
+struct is_generalized_optional : std::false_type {};
+template <class T, class P>
+struct is_generalized_optional<generalized_optional<T, P>> : std::true_type {};
+
+template <class O, class = void>
+struct has_tombstone_value : std::false_type {};
+template <class O>
+struct has_tombstone_value<O, std::void_t<decltype(O::tombstone_value)>>
+    : std::true_type {};
+template <class O, class = void> struct has_tombstone_bits : std::false_type {};
+template <class O>
+struct has_tombstone_bits<O, std::void_t<decltype(O::tombstone_bits)>>
+    : std::true_type {};
+
+// How the comparisons look at the payload of an optional, depending on its
+// control policy.
+//  - readable: an empty optional still holds a T (the sentinel), so that the
+//    payload can be read before checking has_value(), without branching.
+//  - ordered: the sentinel of an integral tombstone is the smallest or the
+//    largest T. key() is then the payload itself, or the payload rotated so
+//    that the sentinel becomes 0, and comparing keys compares optionals.
+template <class O> struct compare_traits {
+  using value_type = typename O::value_type;
+
+  constexpr static inline bool readable =
+      (has_tombstone_value<O>::value || has_tombstone_bits<O>::value) &&
+      !has_snapshot<O>::value;
+
+private:
+  constexpr static bool _ordered() noexcept {
+    if constexpr (has_tombstone_value<O>::value &&
+                  std::is_integral_v<value_type> &&
+                  !std::is_same_v<value_type, bool>) {
+      return O::tombstone_value == std::numeric_limits<value_type>::min() ||
+             O::tombstone_value == std::numeric_limits<value_type>::max();
+    } else {
+      return false;
+    }
+  }
+
+public:
+  constexpr static inline bool ordered = _ordered();
+
+  constexpr static auto key(const O &opt) noexcept {
+    using word = std::make_unsigned_t<value_type>;
+    if constexpr (O::tombstone_value ==
+                  std::numeric_limits<value_type>::min()) {
+      return optional_access::payload(opt);
+    } else {
+      return static_cast<word>(
+          static_cast<word>(optional_access::payload(opt)) -
+          static_cast<word>(O::tombstone_value));
+    }
+  }
 };
 
+template <class Compare>
+constexpr static inline bool is_equality_v =
+    std::is_same_v<Compare, std::equal_to<>> ||
+    std::is_same_v<Compare, std::not_equal_to<>>;
+
+// Both payloads can be compared as they are, empty or not. Equality only
+// needs the sentinels to be the same, orderings need them to sort first.
+template <class Compare, class L, class R>
+constexpr bool raw_comparable() noexcept {
+  if constexpr (has_tombstone_value<L>::value &&
+                has_tombstone_value<R>::value && !has_snapshot<L>::value &&
+                !has_snapshot<R>::value &&
+                std::is_same_v<typename L::value_type,
+                               typename R::value_type> &&
+                std::is_integral_v<typename L::value_type>) {
+    return L::tombstone_value == R::tombstone_value &&
+           (is_equality_v<Compare> || compare_traits<L>::ordered);
+  } else {
+    return false;
+  }
+}
+
+// lhv Compare rhv, an empty optional being equal to another and smaller than
+// any value. Whenever both are not engaged, comparing the presences gives the
+// result.
+template <class Compare, class L, class R>
+constexpr bool compare_optionals(const L &lhv, const R &rhv) {
+  constexpr Compare cmp{};
+  if constexpr (has_snapshot<L>::value || has_snapshot<R>::value) {
+    return compare_optionals<Compare>(stable_view(lhv), stable_view(rhv));
+  } else if constexpr (raw_comparable<Compare, L, R>()) {
+    if constexpr (is_equality_v<Compare>) {
+      return cmp(optional_access::payload(lhv), optional_access::payload(rhv));
+    } else {
+      return cmp(compare_traits<L>::key(lhv), compare_traits<R>::key(rhv));
+    }
+  } else if constexpr (compare_traits<L>::readable &&
+                       compare_traits<R>::readable) {
+    const bool both = lhv.has_value() & rhv.has_value();
+    return (both & static_cast<bool>(cmp(optional_access::payload(lhv),
+                                         optional_access::payload(rhv)))) |
+           (!both & cmp(lhv.has_value(), rhv.has_value()));
+  } else {
+    if (lhv.has_value() && rhv.has_value()) {
+      return cmp(optional_access::payload(lhv), optional_access::payload(rhv));
+    }
+    return cmp(lhv.has_value(), rhv.has_value());
+  }
+}
+
+// opt Compare value, or value Compare opt when Reversed
+template <class Compare, bool Reversed, class O, class U>
+constexpr bool compare_with_value(const O &opt, const U &value) {
+  constexpr Compare cmp{};
+  constexpr bool if_empty = Reversed ? cmp(true, false) : cmp(false, true);
+  const auto compare_payload = [&] {
+    if constexpr (Reversed) {
+      return static_cast<bool>(cmp(value, optional_access::payload(opt)));
+    } else {
+      return static_cast<bool>(cmp(optional_access::payload(opt), value));
+    }
+  };
+  if constexpr (has_snapshot<O>::value) {
+    return compare_with_value<Compare, Reversed>(opt.load(), value);
+  } else if constexpr (compare_traits<O>::readable) {
+    return (opt.has_value() & compare_payload()) |
+           (!opt.has_value() & if_empty);
+  } else {
+    return opt.has_value() ? compare_payload() : if_empty;
+  }
+}
+
+template <class U>
+using enable_value_comparison = std::enable_if_t<
+    std::negation_v<std::disjunction<is_generalized_optional<U>,
+                                     std::is_same<U, nullopt_t>>>,
+    int>;
+} // namespace detail
+
+// Relational operators, with the semantics of those of std::optional. For
+// integral tombstones whose sentinel is the smallest or largest value, they
+// compile to a single comparison of the payloads, and other tombstones
+// compare without branching.
+
+template <class T, class P, class U, class Q>
+constexpr bool operator==(const generalized_optional<T, P> &lhv,
+                          const generalized_optional<U, Q> &rhv) {
+  return detail::compare_optionals<std::equal_to<>>(lhv, rhv);
+}
+template <class T, class P, class U, class Q>
+constexpr bool operator!=(const generalized_optional<T, P> &lhv,
+                          const generalized_optional<U, Q> &rhv) {
+  return detail::compare_optionals<std::not_equal_to<>>(lhv, rhv);
+}
+template <class T, class P, class U, class Q>
+constexpr bool operator<(const generalized_optional<T, P> &lhv,
+                         const generalized_optional<U, Q> &rhv) {
+  return detail::compare_optionals<std::less<>>(lhv, rhv);
+}
+template <class T, class P, class U, class Q>
+constexpr bool operator<=(const generalized_optional<T, P> &lhv,
+                          const generalized_optional<U, Q> &rhv) {
+  return detail::compare_optionals<std::less_equal<>>(lhv, rhv);
+}
+template <class T, class P, class U, class Q>
+constexpr bool operator>(const generalized_optional<T, P> &lhv,
+                         const generalized_optional<U, Q> &rhv) {
+  return detail::compare_optionals<std::greater<>>(lhv, rhv);
+}
+template <class T, class P, class U, class Q>
+constexpr bool operator>=(const generalized_optional<T, P> &lhv,
+                          const generalized_optional<U, Q> &rhv) {
+  return detail::compare_optionals<std::greater_equal<>>(lhv, rhv);
+}
+
+template <class T, class P>
+constexpr bool operator==(const generalized_optional<T, P> &opt,
+                          [[maybe_unused]] nullopt_t empty) noexcept {
+  return !opt.has_value();
+}
+template <class T, class P>
+constexpr bool operator==([[maybe_unused]] nullopt_t empty,
+                          const generalized_optional<T, P> &opt) noexcept {
+  return !opt.has_value();
+}
+template <class T, class P>
+constexpr bool operator!=(const generalized_optional<T, P> &opt,
+                          [[maybe_unused]] nullopt_t empty) noexcept {
+  return opt.has_value();
+}
+template <class T, class P>
+constexpr bool operator!=([[maybe_unused]] nullopt_t empty,
+                          const generalized_optional<T, P> &opt) noexcept {
+  return opt.has_value();
+}
+template <class T, class P>
+constexpr bool
+operator<([[maybe_unused]] const generalized_optional<T, P> &opt,
+          [[maybe_unused]] nullopt_t empty) noexcept {
+  return false;
+}
+template <class T, class P>
+constexpr bool operator<([[maybe_unused]] nullopt_t empty,
+                         const generalized_optional<T, P> &opt) noexcept {
+  return opt.has_value();
+}
+template <class T, class P>
+constexpr bool operator<=(const generalized_optional<T, P> &opt,
+                          [[maybe_unused]] nullopt_t empty) noexcept {
+  return !opt.has_value();
+}
+template <class T, class P>
+constexpr bool
+operator<=([[maybe_unused]] nullopt_t empty,
+           [[maybe_unused]] const generalized_optional<T, P> &opt) noexcept {
+  return true;
+}
+template <class T, class P>
+constexpr bool operator>(const generalized_optional<T, P> &opt,
+                         [[maybe_unused]] nullopt_t empty) noexcept {
+  return opt.has_value();
+}
+template <class T, class P>
+constexpr bool
+operator>([[maybe_unused]] nullopt_t empty,
+          [[maybe_unused]] const generalized_optional<T, P> &opt) noexcept {
+  return false;
+}
+template <class T, class P>
+constexpr bool
+operator>=([[maybe_unused]] const generalized_optional<T, P> &opt,
+           [[maybe_unused]] nullopt_t empty) noexcept {
+  return true;
+}
+template <class T, class P>
+constexpr bool operator>=([[maybe_unused]] nullopt_t empty,
+                          const generalized_optional<T, P> &opt) noexcept {
+  return !opt.has_value();
+}
+
+// Against a value, which is not converted to an optional first
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator==(const generalized_optional<T, P> &opt,
+                          const U &value) {
+  return detail::compare_with_value<std::equal_to<>, false>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator==(const U &value,
+                          const generalized_optional<T, P> &opt) {
+  return detail::compare_with_value<std::equal_to<>, true>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator!=(const generalized_optional<T, P> &opt,
+                          const U &value) {
+  return detail::compare_with_value<std::not_equal_to<>, false>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator!=(const U &value,
+                          const generalized_optional<T, P> &opt) {
+  return detail::compare_with_value<std::not_equal_to<>, true>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator<(const generalized_optional<T, P> &opt,
+                         const U &value) {
+  return detail::compare_with_value<std::less<>, false>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator<(const U &value,
+                         const generalized_optional<T, P> &opt) {
+  return detail::compare_with_value<std::less<>, true>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator<=(const generalized_optional<T, P> &opt,
+                          const U &value) {
+  return detail::compare_with_value<std::less_equal<>, false>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator<=(const U &value,
+                          const generalized_optional<T, P> &opt) {
+  return detail::compare_with_value<std::less_equal<>, true>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator>(const generalized_optional<T, P> &opt,
+                         const U &value) {
+  return detail::compare_with_value<std::greater<>, false>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator>(const U &value,
+                         const generalized_optional<T, P> &opt) {
+  return detail::compare_with_value<std::greater<>, true>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator>=(const generalized_optional<T, P> &opt,
+                          const U &value) {
+  return detail::compare_with_value<std::greater_equal<>, false>(opt, value);
+}
+template <class T, class P, class U, detail::enable_value_comparison<U> = 0>
+constexpr bool operator>=(const U &value,
+                          const generalized_optional<T, P> &opt) {
+  return detail::compare_with_value<std::greater_equal<>, true>(opt, value);
+}
+
+#if defined(__cpp_lib_three_way_comparison)
+template <class T, class P, std::three_way_comparable_with<T> U, class Q>
+constexpr std::compare_three_way_result_t<T, U>
+operator<=>(const generalized_optional<T, P> &lhv,
+            const generalized_optional<U, Q> &rhv) {
+  using access = detail::optional_access;
+  if constexpr (detail::has_snapshot<generalized_optional<T, P>>::value ||
+                detail::has_snapshot<generalized_optional<U, Q>>::value) {
+    return detail::stable_view(lhv) <=> detail::stable_view(rhv);
+  } else if constexpr (detail::raw_comparable<std::less<>,
+                                              generalized_optional<T, P>,
+                                              generalized_optional<U, Q>>()) {
+    using traits = detail::compare_traits<generalized_optional<T, P>>;
+    return traits::key(lhv) <=> traits::key(rhv);
+  } else {
+    if (lhv.has_value() && rhv.has_value()) {
+      return access::payload(lhv) <=> access::payload(rhv);
+    }
+    return lhv.has_value() <=> rhv.has_value();
+  }
+}
+
+template <class T, class P>
+constexpr std::strong_ordering
+operator<=>(const generalized_optional<T, P> &opt,
+            [[maybe_unused]] nullopt_t empty) noexcept {
+  return opt.has_value() <=> false;
+}
+
+template <class T, class P, class U>
+  requires(!detail::is_generalized_optional<U>::value &&
+           !std::is_same_v<U, nullopt_t> &&
+           std::three_way_comparable_with<T, U>)
+constexpr std::compare_three_way_result_t<T, U>
+operator<=>(const generalized_optional<T, P> &opt, const U &value) {
+  if constexpr (detail::has_snapshot<generalized_optional<T, P>>::value) {
+    return opt.load() <=> value;
+  } else {
+    if (opt.has_value()) {
+      return detail::optional_access::payload(opt) <=> value;
+    }
+    return std::strong_ordering::less;
+  }
+}
+#endif
+
 namespace detail {
 template <class T, class = void> struct deduce_tombstone_value;
 template <class T>
-struct deduce_tombstone_value<T, std::enable_if_t<std::is_signed_v<T>>> {
+struct deduce_tombstone_value<
+    T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>>> {
   constexpr static inline T value = std::numeric_limits<T>::min();
 };
 template <class T>
@@ -629,6 +1957,28 @@ template <class T>
 struct deduce_tombstone_value<T, std::enable_if_t<std::is_pointer_v<T>>> {
   constexpr static inline T value = nullptr;
 };
+// Signaling NaNs with a recognizable payload. Arithmetic only ever produces
+// quiet NaNs, so every NaN coming out of a computation is a valid value.
+template <> struct deduce_tombstone_value<float> {
+  constexpr static inline std::uint32_t value = 0x7F80DEAD;
+};
+template <> struct deduce_tombstone_value<double> {
+  constexpr static inline std::uint64_t value = 0x7FF0DEADDEADDEAD;
+};
+
+// Floating point values cannot be template parameters, their tombstone is
+// given as an object representation.
+template <class T, class = void> struct tombstone_traits {
+  using value_type = T;
+  template <value_type V> using control = control::tombstone<T, V>;
+};
+template <class T>
+struct tombstone_traits<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+  using value_type = unsigned_of_size_t<T>;
+  template <value_type V> using control = control::bitwise_tombstone<T, V>;
+};
+template <class T>
+using tombstone_value_t = typename tombstone_traits<T>::value_type;
 
 } // namespace detail
 
@@ -639,13 +1989,67 @@ template <class... Args> struct policy {
 
 template <class T>
 using optional = generalized_optional<
-    T, policy<access::extended, control::dependent_bool, storage::aligned>>;
+    T, policy<access::extended, control::dependent_bool,
+              storage::constexpr_union>>;
+
+// A single pointer, null when empty. Assignments rebind the reference.
+template <class T>
+using optional_ref = generalized_optional<
+    T &, policy<access::extended, control::from_storage, storage::reference>>;
 
-template <class T, T Default = detail::deduce_tombstone_value<T>::value>
+template <class T, detail::tombstone_value_t<T> Default =
+                       detail::deduce_tombstone_value<T>::value>
 using optional_tombstone = generalized_optional<
-    T,
-    policy<access::extended, control::tombstone<T, Default>, storage::aligned>>;
+    T, policy<access::extended,
+              typename detail::tombstone_traits<T>::template control<Default>,
+              storage::constexpr_union>>;
+
+template <auto Member, auto V>
+using optional_member_tombstone = generalized_optional<
+    typename control::member_tombstone<Member, V>::class_type,
+    policy<access::extended, control::member_tombstone<Member, V>,
+           storage::aligned>>;
+
+template <class T>
+using optional_tagged = generalized_optional<
+    T, policy<access::extended, control::tagged<T>, storage::aligned>>;
+
+namespace detail {
+template <class O, class T, class = void> struct optional_hash {
+  optional_hash() = delete;
+  optional_hash(const optional_hash &) = delete;
+  optional_hash(optional_hash &&) = delete;
+  optional_hash &operator=(const optional_hash &) = delete;
+  optional_hash &operator=(optional_hash &&) = delete;
+  ~optional_hash() = delete;
+};
+
+// As for std::optional, an engaged optional hashes as its value. Readable
+// payloads are hashed as they are, an empty one holding the sentinel.
+template <class O, class T>
+struct optional_hash<
+    O, T, std::void_t<decltype(std::hash<T>{}(std::declval<const T &>()))>> {
+  std::size_t operator()(const O &opt) const
+      noexcept(noexcept(std::hash<T>{}(std::declval<const T &>()))) {
+    if constexpr (has_snapshot<O>::value) {
+      return optional_hash<typename O::snapshot, T>{}(opt.load());
+    } else if constexpr (compare_traits<O>::readable) {
+      return std::hash<T>{}(optional_access::payload(opt));
+    } else {
+      return opt.has_value() ? std::hash<T>{}(optional_access::payload(opt))
+                             : static_cast<std::size_t>(-3333);
+    }
+  }
+};
+} // namespace detail
 
 } // namespace dpsg
 
+namespace std {
+template <class T, class P>
+struct hash<dpsg::generalized_optional<T, P>>
+    : dpsg::detail::optional_hash<dpsg::generalized_optional<T, P>,
+                                  dpsg::detail::remove_cvref_t<T>> {};
+} // namespace std
+
 #endif // GUARD_GENERALIZED_OPTIONAL_HEADER
\ No newline at end of file
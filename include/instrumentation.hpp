@@ -0,0 +1,474 @@
+#ifndef GUARD_INSTRUMENTATION_HEADER
+#define GUARD_INSTRUMENTATION_HEADER
+
+#include "generalized_optional.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#define DPSG_INSTRUMENTATION_DEMANGLE 1
+#include <cstdlib>
+#include <cxxabi.h>
+#else
+#define DPSG_INSTRUMENTATION_DEMANGLE 0
+#endif
+
+namespace dpsg {
+
+// Usage counters of the optionals using access::instrumented, per optional
+// type. Each thread counts in its own shard, shards are only combined when
+// read, so that counting never contends.
+namespace instrumentation {
+struct counters {
+  std::uint64_t engagements = 0;    // Values built, by any means
+  std::uint64_t resets = 0;         // Values destroyed by reset()
+  std::uint64_t accesses = 0;       // value(), *, ->, value_or, with_value
+  std::uint64_t empty_accesses = 0; // Accesses to an empty optional
+  std::uint64_t throws = 0;         // bad_optional_access thrown by them
+};
+
+struct record {
+  std::string type;
+  counters counts;
+};
+
+namespace detail {
+enum event : std::size_t {
+  engagement,
+  reset,
+  access,
+  empty_access,
+  thrown,
+  event_count
+};
+
+// Counts of one optional type on one thread. Only that thread writes them, a
+// relaxed load and store is enough and readers may run concurrently.
+struct shard {
+  std::atomic<std::uint64_t> values[event_count] = {};
+  shard *next = nullptr;
+  shard *prev = nullptr;
+
+  void bump(event e) noexcept {
+    std::atomic<std::uint64_t> &value = values[e];
+    value.store(value.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+  }
+};
+
+inline std::string demangle(const char *name) {
+#if DPSG_INSTRUMENTATION_DEMANGLE
+  int status = 0;
+  char *result = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && result != nullptr) {
+    std::string demangled{result};
+    std::free(result); // NOLINT
+    return demangled;
+  }
+#endif
+  return name;
+}
+
+template <class Key> std::string type_name() {
+  return demangle(typeid(Key).name());
+}
+
+struct site;
+
+struct registry {
+  std::mutex lock;
+  site *first = nullptr;
+
+  static registry &get() noexcept {
+    static registry instance;
+    return instance;
+  }
+};
+
+// Counts of one optional type: the shards of the running threads, and what
+// the exited ones (or those which could not allocate a shard) left behind
+struct site {
+  std::string (*name)();
+  std::mutex lock;
+  shard *live = nullptr;
+  std::atomic<std::uint64_t> retired[event_count] = {};
+  site *next = nullptr;
+
+  explicit site(std::string (*type_name)()) noexcept : name(type_name) {
+    registry &r = registry::get();
+    const std::lock_guard<std::mutex> guard{r.lock};
+    next = std::exchange(r.first, this);
+  }
+  site(const site &) = delete;
+  site(site &&) = delete;
+  site &operator=(const site &) = delete;
+  site &operator=(site &&) = delete;
+  ~site() = default;
+
+  void attach(shard &s) noexcept {
+    const std::lock_guard<std::mutex> guard{lock};
+    s.next = std::exchange(live, &s);
+    if (s.next != nullptr) {
+      s.next->prev = &s;
+    }
+  }
+
+  void detach(shard &s) noexcept {
+    const std::lock_guard<std::mutex> guard{lock};
+    for (std::size_t e = 0; e < event_count; ++e) {
+      retired[e].fetch_add(s.values[e].load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+    }
+    (s.prev != nullptr ? s.prev->next : live) = s.next;
+    if (s.next != nullptr) {
+      s.next->prev = s.prev;
+    }
+  }
+
+  [[nodiscard]] counters combine() {
+    std::uint64_t totals[event_count] = {};
+    const std::lock_guard<std::mutex> guard{lock};
+    for (std::size_t e = 0; e < event_count; ++e) {
+      totals[e] = retired[e].load(std::memory_order_relaxed);
+    }
+    for (const shard *s = live; s != nullptr; s = s->next) {
+      for (std::size_t e = 0; e < event_count; ++e) {
+        totals[e] += s->values[e].load(std::memory_order_relaxed);
+      }
+    }
+    return counters{totals[engagement], totals[reset], totals[access],
+                    totals[empty_access], totals[thrown]};
+  }
+
+  // Counts racing with a clear may survive it
+  void clear() noexcept {
+    const std::lock_guard<std::mutex> guard{lock};
+    for (std::size_t e = 0; e < event_count; ++e) {
+      retired[e].store(0, std::memory_order_relaxed);
+    }
+    for (shard *s = live; s != nullptr; s = s->next) {
+      for (auto &value : s->values) {
+        value.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+};
+
+template <class Key> site &site_of() noexcept {
+  static site instance{&type_name<Key>};
+  return instance;
+}
+
+// Trivially destructible, so that it is still usable by the destructors of
+// other thread_local objects
+struct local {
+  shard *counts;
+  bool exited;
+};
+
+template <class Key> local &local_of() noexcept {
+  thread_local local l{nullptr, false};
+  return l;
+}
+
+// Hands the shard of the thread over to the site when the thread exits
+template <class Key> struct drain {
+  drain() = default;
+  drain(const drain &) = delete;
+  drain(drain &&) = delete;
+  drain &operator=(const drain &) = delete;
+  drain &operator=(drain &&) = delete;
+  ~drain() {
+    local &l = local_of<Key>();
+    if (l.counts != nullptr) {
+      site_of<Key>().detach(*l.counts);
+      delete l.counts; // NOLINT
+      l.counts = nullptr;
+    }
+    l.exited = true;
+  }
+};
+
+template <class Key> void record(event e) noexcept {
+  local &l = local_of<Key>();
+  if (l.counts == nullptr) {
+    if (!l.exited) {
+      thread_local drain<Key> guard;
+      l.counts = new (std::nothrow) shard; // NOLINT
+      if (l.counts != nullptr) {
+        site_of<Key>().attach(*l.counts);
+      }
+    }
+    if (l.counts == nullptr) {
+      site_of<Key>().retired[e].fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  l.counts->bump(e);
+}
+
+inline void write_string(std::ostream &out, const std::string &text) {
+  constexpr static char hex[] = "0123456789abcdef";
+  out << '"';
+  for (const char c : text) {
+    const auto byte = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (byte < 0x20) {
+      out << "\\u00" << hex[byte >> 4U] << hex[byte & 0xFU];
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+} // namespace detail
+
+// Counts of the optional type O, 0 when it is not instrumented
+template <class O> [[nodiscard]] counters counts_of() {
+  return detail::site_of<O>().combine();
+}
+
+// Counts of every optional type seen so far, in no particular order
+[[nodiscard]] inline std::vector<record> snapshot() {
+  std::vector<detail::site *> sites;
+  {
+    detail::registry &r = detail::registry::get();
+    const std::lock_guard<std::mutex> guard{r.lock};
+    for (detail::site *s = r.first; s != nullptr; s = s->next) {
+      sites.push_back(s);
+    }
+  }
+  std::vector<record> result;
+  result.reserve(sites.size());
+  for (detail::site *s : sites) {
+    result.push_back(record{s->name(), s->combine()});
+  }
+  return result;
+}
+
+// Calls f(const record &) for every optional type seen so far
+template <class F> void report(F &&f) {
+  for (const record &r : snapshot()) {
+    f(r);
+  }
+}
+
+// {"optionals":[{"type":"...","engagements":0,"resets":0,"accesses":0,
+//                "empty_accesses":0,"throws":0},...]}
+inline void write_json(std::ostream &out) {
+  out << "{\"optionals\":[";
+  const char *separator = "";
+  for (const record &r : snapshot()) {
+    out << separator << "{\"type\":";
+    detail::write_string(out, r.type);
+    out << ",\"engagements\":" << r.counts.engagements
+        << ",\"resets\":" << r.counts.resets
+        << ",\"accesses\":" << r.counts.accesses
+        << ",\"empty_accesses\":" << r.counts.empty_accesses
+        << ",\"throws\":" << r.counts.throws << '}';
+    separator = ",";
+  }
+  out << "]}";
+}
+
+// Sets every count to 0
+inline void reset() noexcept {
+  detail::registry &r = detail::registry::get();
+  const std::lock_guard<std::mutex> guard{r.lock};
+  for (detail::site *s = r.first; s != nullptr; s = s->next) {
+    s->clear();
+  }
+}
+} // namespace instrumentation
+
+namespace detail {
+// Applies the policies of L on top of B
+template <class B, class L> struct stack;
+template <class B> struct stack<B, type_list<>> {
+  using type = B;
+};
+template <class B, class P, class... Ps>
+struct stack<B, type_list<P, Ps...>> {
+  using type = layer<P, typename stack<B, type_list<Ps...>>::type>;
+};
+
+// Right above the control: counts the values built and reset
+template <class B> class counting_layer : public B {
+  using event = instrumentation::detail::event;
+
+public:
+  using B::B;
+  constexpr counting_layer() = default;
+
+  template <class... Args>
+  constexpr explicit counting_layer(bool initial_value, Args &&... args)
+      : B(initial_value, std::forward<Args>(args)...) {
+    if (initial_value) {
+      _record(event::engagement);
+    }
+  }
+
+protected:
+  template <class... Args>
+  void build(Args &&... args) noexcept(
+      noexcept(B::build(std::forward<Args>(args)...))) {
+    B::build(std::forward<Args>(args)...);
+    _record(event::engagement);
+  }
+
+  void reset() noexcept {
+    B::reset();
+    _record(event::reset);
+  }
+
+  template <class O> void steal(O &other) noexcept {
+    const bool engaged = other.has_value();
+    B::steal(other);
+    if (engaged) {
+      _record(event::engagement);
+    }
+  }
+
+  // Counters are those of the optional type
+  static void _record(event e) noexcept {
+    using owner = std::remove_cv_t<std::remove_pointer_t<decltype(
+        std::declval<counting_layer &>().self())>>;
+    instrumentation::detail::record<owner>(e);
+  }
+};
+
+// On top of the access policies: counts their uses
+template <class S> class observing_access : public S {
+  using event = instrumentation::detail::event;
+
+  template <class F> decltype(auto) _observe(F &&f) const {
+    S::_record(event::access);
+    if (S::has_value()) {
+      return f();
+    }
+    S::_record(event::empty_access);
+    try {
+      return f();
+    } catch (const bad_optional_access &) {
+      S::_record(event::thrown);
+      throw;
+    }
+  }
+
+protected:
+  // See generalized_optional::value_or
+  void _on_access(bool engaged) const noexcept {
+    S::_record(event::access);
+    if (!engaged) {
+      S::_record(event::empty_access);
+    }
+  }
+
+public:
+  constexpr static inline bool observes_access = true;
+
+  using S::S;
+
+  template <class S_ = S>
+  auto value() & -> decltype(std::declval<S_ &>().value()) {
+    return _observe([this]() -> decltype(auto) { return S::value(); });
+  }
+  template <class S_ = S>
+  auto value() const & -> decltype(std::declval<const S_ &>().value()) {
+    return _observe([this]() -> decltype(auto) { return S::value(); });
+  }
+  template <class S_ = S>
+  auto value() && -> decltype(std::declval<S_ &&>().value()) {
+    return _observe([this]() -> decltype(auto) {
+      return static_cast<S &&>(*this).value();
+    });
+  }
+  template <class S_ = S>
+  auto value() const && -> decltype(std::declval<const S_ &&>().value()) {
+    return _observe([this]() -> decltype(auto) {
+      return static_cast<const S &&>(*this).value();
+    });
+  }
+
+  template <class S_ = S>
+  auto operator*() & -> decltype(*std::declval<S_ &>()) {
+    return _observe([this]() -> decltype(auto) { return S::operator*(); });
+  }
+  template <class S_ = S>
+  auto operator*() const & -> decltype(*std::declval<const S_ &>()) {
+    return _observe([this]() -> decltype(auto) { return S::operator*(); });
+  }
+  template <class S_ = S>
+  auto operator*() && -> decltype(*std::declval<S_ &&>()) {
+    return _observe([this]() -> decltype(auto) {
+      return *static_cast<S &&>(*this);
+    });
+  }
+  template <class S_ = S>
+  auto operator*() const && -> decltype(*std::declval<const S_ &&>()) {
+    return _observe([this]() -> decltype(auto) {
+      return *static_cast<const S &&>(*this);
+    });
+  }
+
+  template <class S_ = S>
+  auto operator->() -> decltype(std::declval<S_ &>().operator->()) {
+    return _observe([this] { return S::operator->(); });
+  }
+  template <class S_ = S>
+  auto operator->() const
+      -> decltype(std::declval<const S_ &>().operator->()) {
+    return _observe([this] { return S::operator->(); });
+  }
+
+  template <class S_ = S, class... Args>
+  auto with_value(Args &&... args) const & -> decltype(
+      std::declval<const S_ &>().with_value(std::forward<Args>(args)...)) {
+    return _observe([&]() -> decltype(auto) {
+      return S::with_value(std::forward<Args>(args)...);
+    });
+  }
+  template <class S_ = S, class... Args>
+  auto with_value(Args &&... args) && -> decltype(
+      std::declval<S_ &&>().with_value(std::forward<Args>(args)...)) {
+    return _observe([&]() -> decltype(auto) {
+      return static_cast<S &&>(*this).with_value(std::forward<Args>(args)...);
+    });
+  }
+};
+} // namespace detail
+
+namespace access {
+// Inner, counting the uses of the optional in instrumentation::counters.
+// Members added by other access policies (e.g. monadic) are not observed, nor
+// are the copies of trivially copyable optionals, which stay trivial.
+template <class Inner> struct counted {
+  template <class B>
+  using type = detail::observing_access<typename detail::stack<
+      detail::counting_layer<B>,
+      typename detail::flatten<detail::type_list<>, Inner>::type>::type>;
+};
+
+// counted<Inner> when DPSG_OPTIONAL_INSTRUMENTATION is defined, Inner itself
+// otherwise. Every translation unit of a program must agree on it.
+#if defined(DPSG_OPTIONAL_INSTRUMENTATION)
+template <class Inner> using instrumented = counted<Inner>;
+#else
+template <class Inner> using instrumented = Inner;
+#endif
+} // namespace access
+
+} // namespace dpsg
+
+#endif // GUARD_INSTRUMENTATION_HEADER
@@ -0,0 +1,290 @@
+#ifndef GUARD_MONADIC_OPTIONAL_HEADER
+#define GUARD_MONADIC_OPTIONAL_HEADER
+
+#include "generalized_optional.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+namespace detail {
+// Steps of a lazy pipeline. Each of them receives either a value or nothing,
+// and hands its own result over to the next step (K), so that evaluating the
+// whole pipeline is a chain of inlined calls without intermediate optionals.
+// next<X> is the type the following step receives when this one receives X.
+
+template <class F> struct transform_step {
+  F func;
+
+  template <class X> using next = std::invoke_result_t<const F &, X> &&;
+
+  template <class X, class K>
+  constexpr decltype(auto) on_value(X &&value, K next_step) const {
+    return next_step.on_value(std::invoke(func, std::forward<X>(value)));
+  }
+  template <class K> constexpr decltype(auto) on_empty(K next_step) const {
+    return next_step.on_empty();
+  }
+};
+
+template <class F> struct and_then_step {
+  F func;
+
+  template <class X>
+  using next = decltype(*std::declval<std::invoke_result_t<const F &, X>>());
+
+  template <class X, class K>
+  constexpr decltype(auto) on_value(X &&value, K next_step) const {
+    auto result = std::invoke(func, std::forward<X>(value));
+    if (result.has_value()) {
+      return next_step.on_value(*std::move(result));
+    }
+    return next_step.on_empty();
+  }
+  template <class K> constexpr decltype(auto) on_empty(K next_step) const {
+    return next_step.on_empty();
+  }
+};
+
+template <class F> struct filter_step {
+  F func;
+
+  template <class X> using next = X;
+
+  template <class X, class K>
+  constexpr decltype(auto) on_value(X &&value, K next_step) const {
+    if (std::invoke(func, std::as_const(value))) {
+      return next_step.on_value(std::forward<X>(value));
+    }
+    return next_step.on_empty();
+  }
+  template <class K> constexpr decltype(auto) on_empty(K next_step) const {
+    return next_step.on_empty();
+  }
+};
+
+template <class F> struct or_else_step {
+  F func;
+
+  template <class X> using next = X;
+
+  template <class X, class K>
+  constexpr decltype(auto) on_value(X &&value, K next_step) const {
+    return next_step.on_value(std::forward<X>(value));
+  }
+  template <class K> constexpr decltype(auto) on_empty(K next_step) const {
+    auto result = std::invoke(func);
+    if (result.has_value()) {
+      return next_step.on_value(*std::move(result));
+    }
+    return next_step.on_empty();
+  }
+};
+
+template <class X, class... Steps> struct lazy_result { using type = X; };
+template <class X, class S, class... Steps>
+struct lazy_result<X, S, Steps...>
+    : lazy_result<typename S::template next<X>, Steps...> {};
+
+// Step I of a pipeline, as seen by step I - 1
+template <std::size_t I, class Tuple, class Sink> struct continuation {
+  const Tuple &steps;
+  const Sink &sink;
+
+  template <class X> constexpr decltype(auto) on_value(X &&value) const {
+    if constexpr (I == std::tuple_size_v<Tuple>) {
+      return sink.on_value(std::forward<X>(value));
+    } else {
+      return std::get<I>(steps).on_value(
+          std::forward<X>(value),
+          continuation<I + 1, Tuple, Sink>{steps, sink});
+    }
+  }
+
+  constexpr decltype(auto) on_empty() const {
+    if constexpr (I == std::tuple_size_v<Tuple>) {
+      return sink.on_empty();
+    } else {
+      return std::get<I>(steps).on_empty(
+          continuation<I + 1, Tuple, Sink>{steps, sink});
+    }
+  }
+};
+
+template <class O> struct into_optional {
+  template <class X> constexpr O on_value(X &&value) const {
+    return O(std::forward<X>(value));
+  }
+  constexpr O on_empty() const { return O{}; }
+};
+
+template <class T, class U> struct or_default {
+  U &&default_value;
+  template <class X> constexpr T on_value(X &&value) const {
+    return static_cast<T>(std::forward<X>(value));
+  }
+  constexpr T on_empty() const {
+    return static_cast<T>(std::forward<U>(default_value));
+  }
+};
+
+// Pipeline built by access::monadic. Source is the reference type the first
+// step receives (const T & or T &&). Nothing is evaluated before one of
+// evaluate(), value_or() or a conversion to generalized_optional, and like a
+// reference to the source optional, the pipeline must not outlive it.
+//
+// Steps are stored by value and only called on evaluation: compilers inline
+// lambdas, but not always function pointers.
+template <class Source, class... Steps> class lazy {
+private:
+  template <class S, class... Ss> friend class lazy;
+  using tuple = std::tuple<Steps...>;
+  std::remove_reference_t<Source> *_source;
+  tuple _steps;
+
+  template <class S>
+  constexpr lazy<Source, Steps..., S> _then(tuple steps, S step) const {
+    return {_source, std::tuple_cat(std::move(steps),
+                                    std::tuple<S>{std::move(step)})};
+  }
+
+  template <class Sink> constexpr decltype(auto) _run(const Sink &sink) const {
+    const continuation<0, tuple, Sink> first{_steps, sink};
+    if (_source != nullptr) {
+      return first.on_value(static_cast<Source>(*_source));
+    }
+    return first.on_empty();
+  }
+
+public:
+  using value_type =
+      remove_cvref_t<typename lazy_result<Source, Steps...>::type>;
+
+  // Null when the source is empty
+  constexpr lazy(std::remove_reference_t<Source> *source, tuple steps)
+      : _source{source}, _steps{std::move(steps)} {}
+
+  template <class F> constexpr auto transform(F &&func) const & {
+    return _then(_steps,
+                 transform_step<std::decay_t<F>>{std::forward<F>(func)});
+  }
+  template <class F> constexpr auto transform(F &&func) && {
+    return _then(std::move(_steps),
+                 transform_step<std::decay_t<F>>{std::forward<F>(func)});
+  }
+
+  template <class F> constexpr auto and_then(F &&func) const & {
+    return _then(_steps,
+                 and_then_step<std::decay_t<F>>{std::forward<F>(func)});
+  }
+  template <class F> constexpr auto and_then(F &&func) && {
+    return _then(std::move(_steps),
+                 and_then_step<std::decay_t<F>>{std::forward<F>(func)});
+  }
+
+  template <class F> constexpr auto filter(F &&func) const & {
+    return _then(_steps,
+                 filter_step<std::decay_t<F>>{std::forward<F>(func)});
+  }
+  template <class F> constexpr auto filter(F &&func) && {
+    return _then(std::move(_steps),
+                 filter_step<std::decay_t<F>>{std::forward<F>(func)});
+  }
+
+  template <class F> constexpr auto or_else(F &&func) const & {
+    return _then(_steps,
+                 or_else_step<std::decay_t<F>>{std::forward<F>(func)});
+  }
+  template <class F> constexpr auto or_else(F &&func) && {
+    return _then(std::move(_steps),
+                 or_else_step<std::decay_t<F>>{std::forward<F>(func)});
+  }
+
+  // The final value is built directly in the returned optional
+  template <class O = optional<value_type>> constexpr O evaluate() const {
+    return _run(into_optional<O>{});
+  }
+
+  template <class U> constexpr value_type value_or(U &&default_value) const {
+    return _run(or_default<value_type, U>{std::forward<U>(default_value)});
+  }
+
+  template <class P>
+  // NOLINTNEXTLINE
+  constexpr operator generalized_optional<value_type, P>() const {
+    return evaluate<generalized_optional<value_type, P>>();
+  }
+};
+} // namespace detail
+
+namespace access {
+// transform, and_then, or_else and filter, as in std::optional, except that
+// they return a lazy pipeline: the optional is checked once, every step runs
+// as a plain call, and the result is only built at the end, in place.
+//
+//   dpsg::optional<int> port = request.transform(&request::port)
+//                                     .filter(is_valid_port)
+//                                     .or_else(default_port);
+struct monadic {
+  template <class B> struct type : B {
+  private:
+    using T = typename B::type;
+
+    constexpr const T *_source() const noexcept {
+      return B::has_value() ? B::get_ptr() : nullptr;
+    }
+    constexpr T *_source() noexcept {
+      return B::has_value() ? B::get_ptr() : nullptr;
+    }
+
+    constexpr detail::lazy<const T &> _lazy() const & {
+      return {_source(), {}};
+    }
+    constexpr detail::lazy<T &&> _lazy() && { return {_source(), {}}; }
+
+  public:
+    using B::B;
+
+    template <class F> constexpr auto transform(F &&func) const & {
+      return _lazy().transform(std::forward<F>(func));
+    }
+    template <class F> constexpr auto transform(F &&func) && {
+      return std::move(*this)._lazy().transform(std::forward<F>(func));
+    }
+
+    template <class F> constexpr auto and_then(F &&func) const & {
+      return _lazy().and_then(std::forward<F>(func));
+    }
+    template <class F> constexpr auto and_then(F &&func) && {
+      return std::move(*this)._lazy().and_then(std::forward<F>(func));
+    }
+
+    template <class F> constexpr auto filter(F &&func) const & {
+      return _lazy().filter(std::forward<F>(func));
+    }
+    template <class F> constexpr auto filter(F &&func) && {
+      return std::move(*this)._lazy().filter(std::forward<F>(func));
+    }
+
+    template <class F> constexpr auto or_else(F &&func) const & {
+      return _lazy().or_else(std::forward<F>(func));
+    }
+    template <class F> constexpr auto or_else(F &&func) && {
+      return std::move(*this)._lazy().or_else(std::forward<F>(func));
+    }
+  };
+};
+} // namespace access
+
+template <class T>
+using optional_monadic = generalized_optional<
+    T, policy<access::monadic, access::extended, control::dependent_bool,
+              storage::aligned>>;
+
+} // namespace dpsg
+
+#endif // GUARD_MONADIC_OPTIONAL_HEADER
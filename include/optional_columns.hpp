@@ -0,0 +1,528 @@
+#ifndef GUARD_OPTIONAL_COLUMNS_HEADER
+#define GUARD_OPTIONAL_COLUMNS_HEADER
+
+#include "generalized_optional.hpp"
+#include "tombstone_scan.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DPSG_COLUMNS_INLINE inline __attribute__((always_inline))
+#else
+#define DPSG_COLUMNS_INLINE inline
+#endif
+
+#if DPSG_SCAN_X86
+#define DPSG_COLUMNS_TARGET_AVX512                                             \
+  __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+#endif
+
+// Element-wise arithmetic and comparisons over columns of optionals, with SQL
+// semantics: an element of the output is empty when one of its operands is.
+//
+// Columns are given as a pointer and a size, and the output must hold at
+// least as many (constructed) elements. It may be one of the inputs.
+//
+// Tombstone columns (optional_tombstone) and flag columns (dpsg::optional and
+// other dependent_bool optionals over inline storage of trivial types) are
+// processed without a branch per element: every operation is applied to every
+// element, presence is computed as a mask alongside, and both are combined
+// when the output is written. The loops are compiled once per instruction set
+// and vectorized by the compiler (GCC needs -O3). Other optionals use a plain
+// loop.
+//
+// A tombstone column cannot hold its sentinel: results equal to it are empty.
+
+namespace dpsg {
+namespace columns {
+
+// Integer overflow either wraps around (as unsigned arithmetic does), or
+// makes the result empty. Divisions by zero are always empty.
+enum class overflow { wrap, to_null };
+
+namespace detail {
+enum class kind { generic, tombstone, flag };
+
+template <class O>
+using has_tombstone = std::disjunction<dpsg::detail::has_tombstone_value<O>,
+                                       dpsg::detail::has_tombstone_bits<O>>;
+
+template <class P> struct is_flag_policy : std::false_type {};
+template <class... Args>
+struct is_flag_policy<policy<Args...>>
+    : std::conjunction<
+          std::disjunction<std::is_same<Args, control::dependent_bool>...>,
+          std::disjunction<std::is_same<Args, storage::aligned>...,
+                           std::is_same<Args, storage::constexpr_union>...>> {};
+
+template <class O> struct flag_policy : std::false_type {};
+template <class T, class P>
+struct flag_policy<generalized_optional<T, P>> : is_flag_policy<P> {};
+
+template <class O> constexpr kind kind_of() noexcept {
+  using T = typename O::value_type;
+  if constexpr (!std::is_arithmetic_v<T> ||
+                !std::is_trivially_copyable_v<O>) {
+    return kind::generic;
+  } else if constexpr (has_tombstone<O>::value && sizeof(O) == sizeof(T) &&
+                       std::is_standard_layout_v<O>) {
+    return kind::tombstone;
+  } else if constexpr (flag_policy<O>::value &&
+                       sizeof(O) == sizeof(T) + alignof(T)) {
+    // dependent_bool over inline storage: the payload, then the flag
+    return kind::flag;
+  } else {
+    return kind::generic;
+  }
+}
+
+template <class O, kind = kind_of<O>()> struct column;
+
+template <class O> struct column<O, kind::tombstone> {
+  using T = typename O::value_type;
+  using layout = scan::detail::tombstone_layout<O>;
+  using word = typename layout::word;
+
+  DPSG_COLUMNS_INLINE static bool present(const O &o) noexcept {
+    word w;
+    std::memcpy(&w, &o, sizeof(word));
+    return w != layout::sentinel();
+  }
+  DPSG_COLUMNS_INLINE static T value(const O &o) noexcept {
+    T t;
+    std::memcpy(&t, &o, sizeof(T));
+    return t;
+  }
+  DPSG_COLUMNS_INLINE static void write(O &o, T t, bool valid) noexcept {
+    const word w = valid ? layout::raw(t) : layout::sentinel();
+    std::memcpy(scan::detail::bytes(&o), &w, sizeof(word));
+  }
+};
+
+// The flag is read and written along with the padding that follows it, as
+// one word: byte-sized accesses mixed with the payload ones would keep the
+// compiler from vectorizing the loops.
+template <class O> struct column<O, kind::flag> {
+  using T = typename O::value_type;
+  using word = typename scan::detail::raw_word<alignof(T)>::type;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  constexpr static inline unsigned shift = 8 * (sizeof(word) - 1);
+#else
+  constexpr static inline unsigned shift = 0;
+#endif
+
+  DPSG_COLUMNS_INLINE static bool present(const O &o) noexcept {
+    word flag;
+    std::memcpy(&flag, scan::detail::bytes(&o) + sizeof(T), sizeof(word));
+    return ((flag >> shift) & 1U) != 0;
+  }
+  DPSG_COLUMNS_INLINE static T value(const O &o) noexcept {
+    T t;
+    std::memcpy(&t, &o, sizeof(T));
+    return t;
+  }
+  DPSG_COLUMNS_INLINE static void write(O &o, T t, bool valid) noexcept {
+    const auto flag = static_cast<word>(static_cast<word>(valid) << shift);
+    std::memcpy(scan::detail::bytes(&o), &t, sizeof(T));
+    std::memcpy(scan::detail::bytes(&o) + sizeof(T), &flag, sizeof(word));
+  }
+};
+
+template <class T>
+constexpr bool is_int_v = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+// Integers are computed as unsigned to wrap around without undefined
+// behaviour, and at least as wide as unsigned int: narrower types would be
+// promoted to int, whose products may overflow (65535 * 65535)
+template <class T> struct wide_unsigned {
+  using type = std::common_type_t<std::make_unsigned_t<T>, unsigned>;
+};
+
+template <class T>
+using wide_t = std::conditional_t<is_int_v<T>, wide_unsigned<T>, std::decay<T>>;
+
+// Operations compute a result for any pair of values, including the garbage
+// held by empty elements, and report through `overflowed` (only when Checked)
+// and `undefined` the results that may or must be discarded.
+
+struct plus {
+  template <bool Checked, class T>
+  DPSG_COLUMNS_INLINE static T compute(T lhv, T rhv, bool &overflowed,
+                                       [[maybe_unused]] bool &undefined) {
+    if constexpr (is_int_v<T>) {
+      using U = typename wide_t<T>::type;
+      const auto result =
+          static_cast<T>(static_cast<U>(lhv) + static_cast<U>(rhv));
+      if constexpr (Checked && std::is_signed_v<T>) {
+        overflowed = ((lhv ^ result) & (rhv ^ result)) < 0;
+      } else if constexpr (Checked) {
+        overflowed = result < lhv;
+      }
+      return result;
+    } else {
+      return lhv + rhv;
+    }
+  }
+};
+
+struct minus {
+  template <bool Checked, class T>
+  DPSG_COLUMNS_INLINE static T compute(T lhv, T rhv, bool &overflowed,
+                                       [[maybe_unused]] bool &undefined) {
+    if constexpr (is_int_v<T>) {
+      using U = typename wide_t<T>::type;
+      const auto result =
+          static_cast<T>(static_cast<U>(lhv) - static_cast<U>(rhv));
+      if constexpr (Checked && std::is_signed_v<T>) {
+        overflowed = ((lhv ^ rhv) & (lhv ^ result)) < 0;
+      } else if constexpr (Checked) {
+        overflowed = lhv < rhv;
+      }
+      return result;
+    } else {
+      return lhv - rhv;
+    }
+  }
+};
+
+struct multiplies {
+  template <bool Checked, class T>
+  DPSG_COLUMNS_INLINE static T compute(T lhv, T rhv, bool &overflowed,
+                                       [[maybe_unused]] bool &undefined) {
+    if constexpr (is_int_v<T>) {
+      using U = typename wide_t<T>::type;
+      if constexpr (!Checked) {
+        return static_cast<T>(static_cast<U>(lhv) * static_cast<U>(rhv));
+      } else {
+        T result;
+#if defined(__GNUC__) || defined(__clang__)
+        overflowed = __builtin_mul_overflow(lhv, rhv, &result);
+#else
+        result = static_cast<T>(static_cast<U>(lhv) * static_cast<U>(rhv));
+        overflowed = lhv != 0 && (result / lhv != rhv ||
+                                  (std::is_signed_v<T> && lhv == T(-1) &&
+                                   rhv == std::numeric_limits<T>::min()));
+#endif
+        return result;
+      }
+    } else {
+      return lhv * rhv;
+    }
+  }
+};
+
+struct divides {
+  template <bool Checked, class T>
+  DPSG_COLUMNS_INLINE static T compute(T lhv, T rhv, bool &overflowed,
+                                       bool &undefined) {
+    if constexpr (is_int_v<T>) {
+      undefined = rhv == 0;
+      bool wraps = false;
+      if constexpr (std::is_signed_v<T>) {
+        wraps = lhv == std::numeric_limits<T>::min() && rhv == T(-1);
+        overflowed = Checked && wraps;
+      }
+      // min / -1 wraps around to min
+      const T divisor = (undefined || wraps) ? T{1} : rhv;
+      return static_cast<T>(lhv / divisor);
+    } else {
+      return lhv / rhv;
+    }
+  }
+};
+
+template <class Compare> struct comparison {
+  template <bool Checked, class T>
+  DPSG_COLUMNS_INLINE static bool
+  compute(T lhv, T rhv, [[maybe_unused]] bool &overflowed,
+          [[maybe_unused]] bool &undefined) {
+    return Compare{}(lhv, rhv);
+  }
+};
+
+struct equal_to {
+  template <class T> constexpr bool operator()(T lhv, T rhv) const noexcept {
+    return lhv == rhv;
+  }
+};
+struct not_equal_to {
+  template <class T> constexpr bool operator()(T lhv, T rhv) const noexcept {
+    return lhv != rhv;
+  }
+};
+struct less {
+  template <class T> constexpr bool operator()(T lhv, T rhv) const noexcept {
+    return lhv < rhv;
+  }
+};
+struct less_equal {
+  template <class T> constexpr bool operator()(T lhv, T rhv) const noexcept {
+    return lhv <= rhv;
+  }
+};
+struct greater {
+  template <class T> constexpr bool operator()(T lhv, T rhv) const noexcept {
+    return lhv > rhv;
+  }
+};
+struct greater_equal {
+  template <class T> constexpr bool operator()(T lhv, T rhv) const noexcept {
+    return lhv >= rhv;
+  }
+};
+
+template <class Op, bool ToNull, class L, class R, class Out>
+DPSG_COLUMNS_INLINE void element(const L &lhv, const R &rhv, Out &out) {
+  using lcol = column<L>;
+  using rcol = column<R>;
+  using result_t = typename Out::value_type;
+  bool overflowed = false;
+  bool undefined = false;
+  const auto result = Op::template compute<ToNull>(
+      lcol::value(lhv), rcol::value(rhv), overflowed, undefined);
+  const bool valid =
+      lcol::present(lhv) & rcol::present(rhv) & !undefined & !overflowed;
+  column<Out>::write(out, static_cast<result_t>(result), valid);
+}
+
+template <class Op, bool ToNull, class L, class R, class Out>
+DPSG_COLUMNS_INLINE void branchless(const L *lhv, const R *rhv, Out *out,
+                                    std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    element<Op, ToNull>(lhv[i], rhv[i], out[i]);
+  }
+}
+
+template <class Op, bool ToNull, class L, class R, class Out>
+void branching(const L *lhv, const R *rhv, Out *out, std::size_t size) {
+  using T = typename L::value_type;
+  using result_t = typename Out::value_type;
+  for (std::size_t i = 0; i < size; ++i) {
+    if (!lhv[i].has_value() || !rhv[i].has_value()) {
+      out[i].reset();
+      continue;
+    }
+    bool overflowed = false;
+    bool undefined = false;
+    const auto result = Op::template compute<ToNull>(T(*lhv[i]), T(*rhv[i]),
+                                                     overflowed, undefined);
+    if (undefined || overflowed) {
+      out[i].reset();
+    } else {
+      out[i].emplace(static_cast<result_t>(result));
+    }
+  }
+}
+
+// Entry points of the branchless loops, one per instruction set
+struct baseline {
+  template <class Op, bool ToNull, class L, class R, class Out>
+  static void apply(const L *lhv, const R *rhv, Out *out, std::size_t size) {
+    branchless<Op, ToNull>(lhv, rhv, out, size);
+  }
+};
+
+#if DPSG_SCAN_X86
+struct avx2 {
+  template <class Op, bool ToNull, class L, class R, class Out>
+  DPSG_SCAN_TARGET_AVX2 static void apply(const L *lhv, const R *rhv,
+                                          Out *out, std::size_t size) {
+    branchless<Op, ToNull>(lhv, rhv, out, size);
+  }
+};
+
+// Also uses DQ (64 bit multiplications) and VL, which scan::isa::avx512 does
+// not imply: hypervisors may hide them while exposing BW
+inline bool supports_avx512_kernels() noexcept {
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512dq") != 0 &&
+           __builtin_cpu_supports("avx512vl") != 0;
+  }();
+  return supported;
+}
+
+struct avx512 {
+  template <class Op, bool ToNull, class L, class R, class Out>
+  DPSG_COLUMNS_TARGET_AVX512 static void apply(const L *lhv, const R *rhv,
+                                               Out *out, std::size_t size) {
+    branchless<Op, ToNull>(lhv, rhv, out, size);
+  }
+};
+#endif
+
+template <class Op, bool ToNull, class L, class R, class Out>
+void apply(scan::isa target, const L *lhv, const R *rhv, Out *out,
+           std::size_t size) {
+  if constexpr (kind_of<L>() == kind::generic ||
+                kind_of<R>() == kind::generic ||
+                kind_of<Out>() == kind::generic) {
+    branching<Op, ToNull>(lhv, rhv, out, size);
+  } else {
+    switch (target) {
+#if DPSG_SCAN_X86
+    case scan::isa::avx512:
+      if (supports_avx512_kernels()) {
+        avx512::apply<Op, ToNull>(lhv, rhv, out, size);
+        break;
+      }
+      [[fallthrough]];
+    case scan::isa::avx2:
+      avx2::apply<Op, ToNull>(lhv, rhv, out, size);
+      break;
+#endif
+    default:
+      baseline::apply<Op, ToNull>(lhv, rhv, out, size);
+    }
+  }
+}
+
+template <class Op, class L, class R, class Out>
+void apply(scan::isa target, const L *lhv, const R *rhv, Out *out,
+           std::size_t size, overflow mode) {
+  static_assert(std::is_same_v<typename L::value_type,
+                               typename R::value_type>,
+                "operands of different types");
+  if (mode == overflow::to_null) {
+    apply<Op, true>(target, lhv, rhv, out, size);
+  } else {
+    apply<Op, false>(target, lhv, rhv, out, size);
+  }
+}
+} // namespace detail
+
+// The overloads taking an isa force a specific code path, which must be
+// supported by the running CPU. The others use scan::best_isa().
+
+template <class L, class R, class Out>
+void add(scan::isa target, const L *lhv, const R *rhv, Out *out,
+         std::size_t size, overflow mode = overflow::wrap) {
+  detail::apply<detail::plus>(target, lhv, rhv, out, size, mode);
+}
+
+template <class L, class R, class Out>
+void subtract(scan::isa target, const L *lhv, const R *rhv, Out *out,
+              std::size_t size, overflow mode = overflow::wrap) {
+  detail::apply<detail::minus>(target, lhv, rhv, out, size, mode);
+}
+
+template <class L, class R, class Out>
+void multiply(scan::isa target, const L *lhv, const R *rhv, Out *out,
+              std::size_t size, overflow mode = overflow::wrap) {
+  detail::apply<detail::multiplies>(target, lhv, rhv, out, size, mode);
+}
+
+template <class L, class R, class Out>
+void divide(scan::isa target, const L *lhv, const R *rhv, Out *out,
+            std::size_t size, overflow mode = overflow::wrap) {
+  detail::apply<detail::divides>(target, lhv, rhv, out, size, mode);
+}
+
+// Comparisons write optionals of bool, or of any type built from a bool
+
+template <class L, class R, class Out>
+void equal(scan::isa target, const L *lhv, const R *rhv, Out *out,
+           std::size_t size) {
+  detail::apply<detail::comparison<detail::equal_to>>(target, lhv, rhv, out,
+                                                      size, overflow::wrap);
+}
+
+template <class L, class R, class Out>
+void not_equal(scan::isa target, const L *lhv, const R *rhv, Out *out,
+               std::size_t size) {
+  detail::apply<detail::comparison<detail::not_equal_to>>(
+      target, lhv, rhv, out, size, overflow::wrap);
+}
+
+template <class L, class R, class Out>
+void less(scan::isa target, const L *lhv, const R *rhv, Out *out,
+          std::size_t size) {
+  detail::apply<detail::comparison<detail::less>>(target, lhv, rhv, out, size,
+                                                  overflow::wrap);
+}
+
+template <class L, class R, class Out>
+void less_equal(scan::isa target, const L *lhv, const R *rhv, Out *out,
+                std::size_t size) {
+  detail::apply<detail::comparison<detail::less_equal>>(target, lhv, rhv, out,
+                                                        size, overflow::wrap);
+}
+
+template <class L, class R, class Out>
+void greater(scan::isa target, const L *lhv, const R *rhv, Out *out,
+             std::size_t size) {
+  detail::apply<detail::comparison<detail::greater>>(target, lhv, rhv, out,
+                                                     size, overflow::wrap);
+}
+
+template <class L, class R, class Out>
+void greater_equal(scan::isa target, const L *lhv, const R *rhv, Out *out,
+                   std::size_t size) {
+  detail::apply<detail::comparison<detail::greater_equal>>(
+      target, lhv, rhv, out, size, overflow::wrap);
+}
+
+template <class L, class R, class Out>
+void add(const L *lhv, const R *rhv, Out *out, std::size_t size,
+         overflow mode = overflow::wrap) {
+  add(scan::best_isa(), lhv, rhv, out, size, mode);
+}
+
+template <class L, class R, class Out>
+void subtract(const L *lhv, const R *rhv, Out *out, std::size_t size,
+              overflow mode = overflow::wrap) {
+  subtract(scan::best_isa(), lhv, rhv, out, size, mode);
+}
+
+template <class L, class R, class Out>
+void multiply(const L *lhv, const R *rhv, Out *out, std::size_t size,
+              overflow mode = overflow::wrap) {
+  multiply(scan::best_isa(), lhv, rhv, out, size, mode);
+}
+
+template <class L, class R, class Out>
+void divide(const L *lhv, const R *rhv, Out *out, std::size_t size,
+            overflow mode = overflow::wrap) {
+  divide(scan::best_isa(), lhv, rhv, out, size, mode);
+}
+
+template <class L, class R, class Out>
+void equal(const L *lhv, const R *rhv, Out *out, std::size_t size) {
+  equal(scan::best_isa(), lhv, rhv, out, size);
+}
+
+template <class L, class R, class Out>
+void not_equal(const L *lhv, const R *rhv, Out *out, std::size_t size) {
+  not_equal(scan::best_isa(), lhv, rhv, out, size);
+}
+
+template <class L, class R, class Out>
+void less(const L *lhv, const R *rhv, Out *out, std::size_t size) {
+  less(scan::best_isa(), lhv, rhv, out, size);
+}
+
+template <class L, class R, class Out>
+void less_equal(const L *lhv, const R *rhv, Out *out, std::size_t size) {
+  less_equal(scan::best_isa(), lhv, rhv, out, size);
+}
+
+template <class L, class R, class Out>
+void greater(const L *lhv, const R *rhv, Out *out, std::size_t size) {
+  greater(scan::best_isa(), lhv, rhv, out, size);
+}
+
+template <class L, class R, class Out>
+void greater_equal(const L *lhv, const R *rhv, Out *out, std::size_t size) {
+  greater_equal(scan::best_isa(), lhv, rhv, out, size);
+}
+
+} // namespace columns
+} // namespace dpsg
+
+#undef DPSG_COLUMNS_INLINE
+#undef DPSG_COLUMNS_TARGET_AVX512
+
+#endif // GUARD_OPTIONAL_COLUMNS_HEADER
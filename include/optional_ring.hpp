@@ -0,0 +1,384 @@
+#ifndef GUARD_OPTIONAL_RING_HEADER
+#define GUARD_OPTIONAL_RING_HEADER
+
+#include "atomic_optional.hpp"
+#include "generalized_optional.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+namespace detail {
+// Fixed rather than std::hardware_destructive_interference_size, which may
+// differ between compilers and would then change the shared memory layout.
+constexpr static inline std::size_t cache_line_size = 64;
+
+constexpr bool is_power_of_two(std::size_t n) noexcept {
+  return n != 0 && (n & (n - 1)) == 0;
+}
+
+constexpr std::uint64_t fnv1a(std::uint64_t hash,
+                              std::uint64_t value) noexcept {
+  for (unsigned i = 0; i < sizeof(value); ++i) {
+    hash ^= (value >> (8U * i)) & 0xFFU;
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+// Identifies the type of a ring stored in shared memory
+constexpr std::uint64_t ring_layout(std::uint64_t kind, std::size_t capacity,
+                                    std::size_t size,
+                                    std::size_t alignment) noexcept {
+  return fnv1a(fnv1a(fnv1a(fnv1a(0xCBF29CE484222325ULL, kind), capacity),
+                     size),
+               alignment);
+}
+
+template <class T>
+constexpr static inline bool is_shareable_v =
+    std::is_trivially_copyable_v<T> &&
+    std::atomic<std::size_t>::is_always_lock_free;
+} // namespace detail
+
+namespace control {
+// Presence is the low bit of a counter of the builds and resets of the value.
+// Used by mpmc_ring, in which the counter also tells which lap of the ring the
+// cell is in.
+struct sequenced {
+  template <class B> struct type : B {
+  private:
+    std::atomic<std::size_t> _sequence;
+
+    // Only the thread that owns the cell writes to the counter
+    void _advance() noexcept {
+      _sequence.store(_sequence.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+    }
+
+  protected:
+    type() noexcept : _sequence(0) {}
+
+    template <class... Args>
+    explicit type(bool initial_value, Args &&... args)
+        : B(std::forward<Args>(args)...), _sequence(initial_value ? 1 : 0) {}
+
+    void reset() noexcept {
+      B::destroy();
+      _advance();
+    }
+
+    template <class... Args>
+    void build(Args &&... args) noexcept(
+        noexcept(B::build(std::forward<Args>(args)...))) {
+      B::build(std::forward<Args>(args)...);
+      _advance();
+    }
+
+  public:
+    [[nodiscard]] bool has_value(
+        std::memory_order order = std::memory_order_acquire) const noexcept {
+      return (_sequence.load(order) & 1U) != 0;
+    }
+
+    [[nodiscard]] std::size_t sequence_number(
+        std::memory_order order = std::memory_order_acquire) const noexcept {
+      return _sequence.load(order);
+    }
+  };
+};
+} // namespace control
+
+// Single producer, single consumer ring of word sized values. The tombstone
+// of each cell is the only synchronization: the producer fills the empty cells
+// and the consumer empties the filled ones, in order, so neither of their
+// indices is shared.
+//
+// The layout is fixed: a ring can be placed in shared memory with create_at
+// and used from another process with attach.
+template <class T, std::size_t Capacity,
+          T Sentinel = detail::deduce_tombstone_value<T>::value>
+class spsc_ring {
+  static_assert(detail::is_power_of_two(Capacity),
+                "ring capacities must be powers of two");
+
+public:
+  using value_type = T;
+  using cell_type = atomic_optional_tombstone<T, Sentinel>;
+  using snapshot = typename cell_type::snapshot;
+  constexpr static inline std::uint64_t layout_id =
+      detail::ring_layout(1, Capacity, sizeof(T), alignof(T));
+
+private:
+  constexpr static inline std::size_t mask = Capacity - 1;
+
+  alignas(detail::cache_line_size) std::uint64_t _layout = layout_id;
+  // Only used by the producer
+  alignas(detail::cache_line_size) std::size_t _tail = 0;
+  // Only used by the consumer
+  alignas(detail::cache_line_size) std::size_t _head = 0;
+  alignas(detail::cache_line_size) cell_type _cells[Capacity];
+
+public:
+  spsc_ring() = default;
+  spsc_ring(const spsc_ring &) = delete;
+  spsc_ring(spsc_ring &&) = delete;
+  spsc_ring &operator=(const spsc_ring &) = delete;
+  spsc_ring &operator=(spsc_ring &&) = delete;
+  ~spsc_ring() = default;
+
+  // Builds an empty ring in memory (e.g. a memfd or shm_open mapping) of at
+  // least sizeof(spsc_ring) bytes, aligned on alignof(spsc_ring)
+  static spsc_ring *create_at(void *memory) noexcept {
+    static_assert(detail::is_shareable_v<T>,
+                  "rings shared between processes must hold trivially "
+                  "copyable values");
+    assert(reinterpret_cast<std::uintptr_t>(memory) % alignof(spsc_ring) ==
+           0);
+    return ::new (memory) spsc_ring;
+  }
+
+  // Ring previously built by create_at, possibly by another process. nullptr
+  // if memory holds a ring of another type.
+  static spsc_ring *attach(void *memory) noexcept {
+    auto *ring = std::launder(static_cast<spsc_ring *>(memory));
+    return ring->_layout == layout_id ? ring : nullptr;
+  }
+
+  [[nodiscard]] constexpr static std::size_t capacity() noexcept {
+    return Capacity;
+  }
+
+  // Producer side
+  bool try_push(T value) noexcept {
+    assert(value != Sentinel && "pushing the tombstone value");
+    cell_type &cell = _cells[_tail & mask];
+    if (cell.has_value()) {
+      return false;
+    }
+    cell.store(value);
+    ++_tail;
+    return true;
+  }
+
+  // Pushes up to count values from first, returns how many were pushed
+  template <class It> std::size_t try_push_n(It first, std::size_t count) {
+    count = std::min(count, Capacity);
+    // Cells are emptied in order: when the last one is empty, so are the
+    // others
+    if (count > 0 && !_cells[(_tail + count - 1) & mask].has_value()) {
+      for (std::size_t i = 0; i < count; ++i, ++first) {
+        assert(*first != Sentinel && "pushing the tombstone value");
+        _cells[(_tail + i) & mask].store(*first);
+      }
+      _tail += count;
+      return count;
+    }
+    std::size_t pushed = 0;
+    for (; pushed < count && try_push(*first); ++pushed, ++first) {
+    }
+    return pushed;
+  }
+
+  // Consumer side
+  snapshot try_pop() noexcept {
+    cell_type &cell = _cells[_head & mask];
+    snapshot result = cell.load();
+    if (result.has_value()) {
+      cell.store(nullopt);
+      ++_head;
+    }
+    return result;
+  }
+
+  // Pops up to count values into out, returns how many were popped
+  template <class Out> std::size_t try_pop_n(Out out, std::size_t count) {
+    count = std::min(count, Capacity);
+    // Cells are filled in order: when the last one is filled, so are the
+    // others
+    if (count > 0 && _cells[(_head + count - 1) & mask].has_value()) {
+      for (std::size_t i = 0; i < count; ++i, ++out) {
+        cell_type &cell = _cells[(_head + i) & mask];
+        *out = *cell.load(std::memory_order_relaxed);
+        cell.store(nullopt);
+      }
+      _head += count;
+      return count;
+    }
+    std::size_t popped = 0;
+    for (; popped < count; ++popped, ++out) {
+      auto value = try_pop();
+      if (!value.has_value()) {
+        break;
+      }
+      *out = *value;
+    }
+    return popped;
+  }
+};
+
+// Multiple producers, multiple consumers ring (Vyukov's bounded queue). Each
+// cell is a generalized_optional whose presence bit is the low bit of its
+// sequence number, there is no separate empty flag. A cell of position p is
+// free when its sequence is 2 * lap(p) and filled at 2 * lap(p) + 1.
+//
+// Values are built before a cell is claimed and moved in and out of it, so T
+// must be nothrow move constructible. The layout is fixed, as for spsc_ring.
+//
+// Tombstone cells, as in spsc_ring, are SPSC only. An empty tombstone does not
+// tell which lap the cell is free for: with several producers, the one that
+// claimed position p + Capacity could find the cell empty before the one that
+// claimed p wrote to it, and both would fill it. The sequence number carries
+// the lap, hence its extra word per cell.
+template <class T, std::size_t Capacity> class mpmc_ring {
+  static_assert(detail::is_power_of_two(Capacity),
+                "ring capacities must be powers of two");
+  static_assert(std::is_nothrow_move_constructible_v<T>,
+                "ring values must be nothrow move constructible");
+
+public:
+  using value_type = T;
+  using cell_type = generalized_optional<
+      T, policy<access::extended, control::sequenced, storage::aligned>>;
+  constexpr static inline std::uint64_t layout_id =
+      detail::ring_layout(2, Capacity, sizeof(T), alignof(T));
+
+private:
+  constexpr static inline std::size_t mask = Capacity - 1;
+  constexpr static inline unsigned lap_shift = detail::log2(Capacity);
+
+  alignas(detail::cache_line_size) std::uint64_t _layout = layout_id;
+  alignas(detail::cache_line_size) std::atomic<std::size_t> _tail{0};
+  alignas(detail::cache_line_size) std::atomic<std::size_t> _head{0};
+  alignas(detail::cache_line_size) cell_type _cells[Capacity];
+
+  constexpr static std::size_t _free_sequence(std::size_t position) noexcept {
+    return (position >> lap_shift) * 2;
+  }
+
+  // Number of cells from position, up to count, whose sequence is the free
+  // one plus filled
+  std::size_t _ready(std::size_t position, std::size_t count,
+                     std::size_t filled) const noexcept {
+    std::size_t ready = 0;
+    for (; ready < count; ++ready) {
+      const std::size_t p = position + ready;
+      if (_cells[p & mask].sequence_number() != _free_sequence(p) + filled) {
+        break;
+      }
+    }
+    return ready;
+  }
+
+  // Claims up to count consecutive ready cells from index. Returns the first
+  // position and the number of cells claimed, 0 if the ring is full (when
+  // claiming free cells) or empty (when claiming filled ones).
+  std::pair<std::size_t, std::size_t> _claim(std::atomic<std::size_t> &index,
+                                             std::size_t count,
+                                             std::size_t filled) noexcept {
+    std::size_t position = index.load(std::memory_order_relaxed);
+    for (;;) {
+      const std::size_t ready = _ready(position, count, filled);
+      if (ready == 0) {
+        // Either another thread claimed position meanwhile, or the cell is
+        // still in use by the previous lap
+        const std::size_t current = index.load(std::memory_order_relaxed);
+        if (current == position) {
+          return {position, 0};
+        }
+        position = current;
+      } else if (index.compare_exchange_weak(position, position + ready,
+                                             std::memory_order_relaxed)) {
+        return {position, ready};
+      }
+    }
+  }
+
+public:
+  mpmc_ring() = default;
+  mpmc_ring(const mpmc_ring &) = delete;
+  mpmc_ring(mpmc_ring &&) = delete;
+  mpmc_ring &operator=(const mpmc_ring &) = delete;
+  mpmc_ring &operator=(mpmc_ring &&) = delete;
+  ~mpmc_ring() = default;
+
+  // See spsc_ring::create_at
+  static mpmc_ring *create_at(void *memory) noexcept {
+    static_assert(detail::is_shareable_v<T>,
+                  "rings shared between processes must hold trivially "
+                  "copyable values");
+    assert(reinterpret_cast<std::uintptr_t>(memory) % alignof(mpmc_ring) ==
+           0);
+    return ::new (memory) mpmc_ring;
+  }
+
+  // See spsc_ring::attach
+  static mpmc_ring *attach(void *memory) noexcept {
+    auto *ring = std::launder(static_cast<mpmc_ring *>(memory));
+    return ring->_layout == layout_id ? ring : nullptr;
+  }
+
+  [[nodiscard]] constexpr static std::size_t capacity() noexcept {
+    return Capacity;
+  }
+
+  // Only exact when no other thread uses the ring
+  [[nodiscard]] std::size_t size_approx() const noexcept {
+    const std::size_t head = _head.load(std::memory_order_relaxed);
+    const std::size_t tail = _tail.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool try_push(T value) noexcept {
+    const auto [position, claimed] = _claim(_tail, 1, 0);
+    if (claimed == 0) {
+      return false;
+    }
+    _cells[position & mask].emplace(std::move(value));
+    return true;
+  }
+
+  // Moves up to count values out of first, returns how many were pushed. The
+  // cells are claimed at once, the values are therefore contiguous in the
+  // ring.
+  template <class It> std::size_t try_push_n(It first, std::size_t count) {
+    const auto [position, claimed] = _claim(_tail, count, 0);
+    for (std::size_t i = 0; i < claimed; ++i, ++first) {
+      _cells[(position + i) & mask].emplace(std::move(*first));
+    }
+    return claimed;
+  }
+
+  optional<T> try_pop() noexcept {
+    const auto [position, claimed] = _claim(_head, 1, 1);
+    if (claimed == 0) {
+      return nullopt;
+    }
+    cell_type &cell = _cells[position & mask];
+    optional<T> result{std::move(*cell)};
+    cell.reset();
+    return result;
+  }
+
+  // Pops up to count values into out, returns how many were popped
+  template <class Out> std::size_t try_pop_n(Out out, std::size_t count) {
+    const auto [position, claimed] = _claim(_head, count, 1);
+    for (std::size_t i = 0; i < claimed; ++i, ++out) {
+      cell_type &cell = _cells[(position + i) & mask];
+      *out = std::move(*cell);
+      cell.reset();
+    }
+    return claimed;
+  }
+};
+
+} // namespace dpsg
+
+#endif // GUARD_OPTIONAL_RING_HEADER
@@ -0,0 +1,235 @@
+#ifndef GUARD_OPTIONAL_SPAN_HEADER
+#define GUARD_OPTIONAL_SPAN_HEADER
+
+#include "bitmap_reference.hpp"
+#include "generalized_optional.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+namespace dpsg {
+
+namespace detail {
+// Tombstone optionals are nothing but their payload, an array of them is
+// usable as it is. Other optionals are viewed as an array of payloads and a
+// validity bitmap.
+template <class T, class Policy>
+constexpr static inline bool is_tombstone_layout_v =
+    std::disjunction_v<has_tombstone_value<generalized_optional<T, Policy>>,
+                       has_tombstone_bits<generalized_optional<T, Policy>>> &&
+    sizeof(generalized_optional<T, Policy>) == sizeof(T) &&
+    std::is_trivially_copyable_v<generalized_optional<T, Policy>>;
+} // namespace detail
+
+// Read-only, non-owning view of a sequence of optionals laid out in memory
+// owned by someone else, e.g. a mapped file (see column_file.hpp).
+//
+// Tombstone optionals are viewed directly as an array of
+// generalized_optional<T, Policy>. For any other policy, the view is made of
+// an array of T and a bitmap of 64 bit words, bit i % 64 of word i / 64 being
+// set when element i is engaged, and elements are bitmap_reference proxies.
+template <class T, class Policy> class optional_span {
+public:
+  using value_type = T;
+  using optional_type = generalized_optional<T, Policy>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using word_type = std::uint64_t;
+
+  constexpr static inline bool tombstone_layout =
+      detail::is_tombstone_layout_v<T, Policy>;
+  static_assert(tombstone_layout || std::is_trivially_copyable_v<T>,
+                "optional_span payloads must be trivially copyable");
+
+  using reference = std::conditional_t<
+      tombstone_layout, const optional_type &,
+      bitmap_reference<const T, access::extended, const word_type>>;
+  using const_reference = reference;
+  using data_type =
+      std::conditional_t<tombstone_layout, const optional_type, const T>;
+
+  constexpr static inline size_type bits_per_word =
+      std::numeric_limits<word_type>::digits;
+
+  class iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = typename optional_span::reference;
+    using pointer = void;
+
+    constexpr iterator() noexcept = default;
+    constexpr iterator(data_type *data, const word_type *bitmap,
+                       size_type idx) noexcept
+        : _data(data), _bitmap(bitmap), _index(idx) {}
+
+    constexpr reference operator*() const {
+      return optional_span::_at(_data, _bitmap, _index);
+    }
+    constexpr reference operator[](difference_type n) const {
+      return optional_span::_at(_data, _bitmap, _index + n);
+    }
+
+    constexpr iterator &operator++() noexcept {
+      ++_index;
+      return *this;
+    }
+    constexpr iterator operator++(int) noexcept {
+      auto cpy = *this;
+      ++_index;
+      return cpy;
+    }
+    constexpr iterator &operator--() noexcept {
+      --_index;
+      return *this;
+    }
+    constexpr iterator operator--(int) noexcept {
+      auto cpy = *this;
+      --_index;
+      return cpy;
+    }
+    constexpr iterator &operator+=(difference_type n) noexcept {
+      _index += n;
+      return *this;
+    }
+    constexpr iterator &operator-=(difference_type n) noexcept {
+      _index -= n;
+      return *this;
+    }
+    friend constexpr iterator operator+(iterator it,
+                                        difference_type n) noexcept {
+      return it += n;
+    }
+    friend constexpr iterator operator+(difference_type n,
+                                        iterator it) noexcept {
+      return it += n;
+    }
+    friend constexpr iterator operator-(iterator it,
+                                        difference_type n) noexcept {
+      return it -= n;
+    }
+    friend constexpr difference_type operator-(const iterator &lhv,
+                                               const iterator &rhv) noexcept {
+      return static_cast<difference_type>(lhv._index) -
+             static_cast<difference_type>(rhv._index);
+    }
+    friend constexpr bool operator==(const iterator &lhv,
+                                     const iterator &rhv) noexcept {
+      return lhv._index == rhv._index;
+    }
+    friend constexpr bool operator!=(const iterator &lhv,
+                                     const iterator &rhv) noexcept {
+      return lhv._index != rhv._index;
+    }
+    friend constexpr bool operator<(const iterator &lhv,
+                                    const iterator &rhv) noexcept {
+      return lhv._index < rhv._index;
+    }
+    friend constexpr bool operator>(const iterator &lhv,
+                                    const iterator &rhv) noexcept {
+      return lhv._index > rhv._index;
+    }
+    friend constexpr bool operator<=(const iterator &lhv,
+                                     const iterator &rhv) noexcept {
+      return lhv._index <= rhv._index;
+    }
+    friend constexpr bool operator>=(const iterator &lhv,
+                                     const iterator &rhv) noexcept {
+      return lhv._index >= rhv._index;
+    }
+
+  private:
+    data_type *_data = nullptr;
+    const word_type *_bitmap = nullptr;
+    size_type _index = 0;
+  };
+  using const_iterator = iterator;
+
+  constexpr optional_span() noexcept = default;
+
+  // Array of tombstone optionals
+  template <bool B = tombstone_layout, std::enable_if_t<B, int> = 0>
+  constexpr optional_span(const optional_type *data, size_type size) noexcept
+      : _data(data), _size(size) {}
+
+  // Payloads and validity bitmap, of at least (size + 63) / 64 words
+  template <bool B = tombstone_layout, std::enable_if_t<!B, int> = 0>
+  constexpr optional_span(const T *values, const word_type *bitmap,
+                          size_type size) noexcept
+      : _data(values), _bitmap(bitmap), _size(size) {}
+
+  [[nodiscard]] constexpr size_type size() const noexcept { return _size; }
+  [[nodiscard]] constexpr bool empty() const noexcept { return _size == 0; }
+
+  [[nodiscard]] constexpr data_type *data() const noexcept { return _data; }
+  // Only for views that are not tombstone arrays
+  [[nodiscard]] constexpr const word_type *bitmap() const noexcept {
+    return _bitmap;
+  }
+
+  [[nodiscard]] constexpr bool has_value(size_type idx) const noexcept {
+    if constexpr (tombstone_layout) {
+      return _data[idx].has_value();
+    } else {
+      return (_bitmap[idx / bits_per_word] & _mask(idx)) != 0;
+    }
+  }
+
+  [[nodiscard]] constexpr reference operator[](size_type idx) const noexcept {
+    return _at(_data, _bitmap, idx);
+  }
+
+  [[nodiscard]] constexpr reference front() const noexcept {
+    return (*this)[0];
+  }
+  [[nodiscard]] constexpr reference back() const noexcept {
+    return (*this)[_size - 1];
+  }
+
+  [[nodiscard]] constexpr iterator begin() const noexcept {
+    return iterator{_data, _bitmap, 0};
+  }
+  [[nodiscard]] constexpr iterator end() const noexcept {
+    return iterator{_data, _bitmap, _size};
+  }
+  [[nodiscard]] constexpr iterator cbegin() const noexcept { return begin(); }
+  [[nodiscard]] constexpr iterator cend() const noexcept { return end(); }
+
+private:
+  data_type *_data = nullptr;
+  const word_type *_bitmap = nullptr;
+  size_type _size = 0;
+
+  constexpr static word_type _mask(size_type idx) noexcept {
+    return word_type{1} << (idx % bits_per_word);
+  }
+
+  constexpr static reference _at(data_type *data, const word_type *bitmap,
+                                 size_type idx) noexcept {
+    if constexpr (tombstone_layout) {
+      return data[idx];
+    } else {
+      return reference{data + idx, bitmap + idx / bits_per_word, _mask(idx)};
+    }
+  }
+};
+
+namespace detail {
+template <class O> struct optional_span_of;
+template <class T, class P>
+struct optional_span_of<generalized_optional<T, P>> {
+  using type = optional_span<T, P>;
+};
+} // namespace detail
+
+// View of optionals of type O, e.g. optional_span_of<optional_tombstone<int>>
+template <class O>
+using optional_span_of = typename detail::optional_span_of<O>::type;
+
+} // namespace dpsg
+
+#endif // GUARD_OPTIONAL_SPAN_HEADER
@@ -0,0 +1,362 @@
+#ifndef GUARD_OPTIONAL_TUPLE_HEADER
+#define GUARD_OPTIONAL_TUPLE_HEADER
+
+#include "bitmap_reference.hpp"
+#include "generalized_optional.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+// Element of an optional_tuple named by Tag, which get<Tag>() then finds.
+// Unnamed elements are found by their type, as with std::get.
+template <class Tag, class T> struct field {};
+
+namespace detail {
+template <class E> struct tuple_field {
+  using tag = E;
+  using type = E;
+};
+template <class Tag, class T> struct tuple_field<field<Tag, T>> {
+  using tag = Tag;
+  using type = T;
+};
+
+template <class Tag, class E>
+constexpr static inline bool has_tag =
+    std::is_same_v<Tag, typename tuple_field<E>::tag>;
+
+// Index of the only element tagged Tag
+template <class Tag, class... Es> constexpr std::size_t tuple_index() noexcept {
+  static_assert((std::size_t{0} + ... + has_tag<Tag, Es>) == 1,
+                "exactly one element must have this tag or type");
+  constexpr bool matches[] = {has_tag<Tag, Es>...};
+  std::size_t result = 0;
+  while (!matches[result]) {
+    ++result;
+  }
+  return result;
+}
+
+// Offsets of the payloads in a single buffer. They are placed by decreasing
+// alignment, which leaves no padding between them since every size is a
+// multiple of the matching alignment.
+template <class... Ts>
+constexpr std::array<std::size_t, sizeof...(Ts)> tuple_offsets() noexcept {
+  constexpr std::size_t sizes[] = {sizeof(Ts)...};
+  constexpr std::size_t alignments[] = {alignof(Ts)...};
+  std::array<std::size_t, sizeof...(Ts)> result{};
+  std::size_t offset = 0;
+  for (std::size_t align = std::max({alignof(Ts)...}); align != 0;
+       align /= 2) {
+    for (std::size_t i = 0; i < sizeof...(Ts); ++i) {
+      if (alignments[i] == align) {
+        result[i] = offset;
+        offset += sizes[i];
+      }
+    }
+  }
+  return result;
+}
+
+template <std::size_t N>
+using tuple_mask_t = typename unsigned_of_size<N <= 8    ? 1
+                                               : N <= 16 ? 2
+                                               : N <= 32 ? 4
+                                                         : 8>::type;
+
+// Payloads and presence mask of an optional_tuple. Bit I of the mask is set
+// when element I is engaged, the payload of an empty element is raw memory.
+template <class... Ts> struct tuple_data {
+  using mask_type = tuple_mask_t<sizeof...(Ts)>;
+  template <std::size_t I>
+  using type_at = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+  constexpr static inline std::array<std::size_t, sizeof...(Ts)> offsets =
+      tuple_offsets<Ts...>();
+  template <std::size_t I>
+  constexpr static inline mask_type bit =
+      static_cast<mask_type>(mask_type{1} << I);
+
+  constexpr static inline bool nothrow_move_construct =
+      (std::is_nothrow_move_constructible_v<Ts> && ...);
+  constexpr static inline bool nothrow_move_assign =
+      nothrow_move_construct && (std::is_nothrow_move_assignable_v<Ts> && ...);
+
+  alignas(Ts...) unsigned char cells[(sizeof(Ts) + ...)];
+  mask_type mask = 0;
+
+  template <std::size_t I> type_at<I> *cell() noexcept {
+    return reinterpret_cast<type_at<I> *>(cells + offsets[I]); // NOLINT
+  }
+  template <std::size_t I> const type_at<I> *cell() const noexcept {
+    return reinterpret_cast<const type_at<I> *>(cells + offsets[I]); // NOLINT
+  }
+  template <std::size_t I> [[nodiscard]] bool holds() const noexcept {
+    return (mask & bit<I>) != 0;
+  }
+
+  template <class F> static void for_each_index(F &&f) {
+    _for_each(f, std::index_sequence_for<Ts...>{});
+  }
+
+  template <std::size_t I, class... Args> void build(Args &&... args) {
+    construct_at<type_at<I>>(cell<I>(), std::forward<Args>(args)...);
+    mask |= bit<I>;
+  }
+  template <std::size_t I> void destroy() noexcept {
+    using T = type_at<I>;
+    cell<I>()->~T();
+    mask &= static_cast<mask_type>(~bit<I>);
+  }
+
+  void destroy_all() noexcept {
+    for_each_index([this](auto i) {
+      constexpr std::size_t I = decltype(i)::value;
+      if constexpr (!std::is_trivially_destructible_v<type_at<I>>) {
+        if (holds<I>()) {
+          destroy<I>();
+        }
+      }
+    });
+    mask = 0;
+  }
+
+  // this must be empty. The elements built so far are destroyed if one of
+  // them throws.
+  template <class D> void build_from(D &&other) {
+    try {
+      for_each_index([&](auto i) {
+        constexpr std::size_t I = decltype(i)::value;
+        if (other.template holds<I>()) {
+          build<I>(_value_of<I>(std::forward<D>(other)));
+        }
+      });
+    } catch (...) {
+      destroy_all();
+      throw;
+    }
+  }
+
+  template <class D> void assign_from(D &&other) {
+    for_each_index([&](auto i) {
+      constexpr std::size_t I = decltype(i)::value;
+      if (other.template holds<I>()) {
+        if (holds<I>()) {
+          *cell<I>() = _value_of<I>(std::forward<D>(other));
+        } else {
+          build<I>(_value_of<I>(std::forward<D>(other)));
+        }
+      } else if (holds<I>()) {
+        destroy<I>();
+      }
+    });
+  }
+
+private:
+  template <class F, std::size_t... Is>
+  static void _for_each(F &f, [[maybe_unused]] std::index_sequence<Is...> is) {
+    (f(std::integral_constant<std::size_t, Is>{}), ...);
+  }
+
+  // Moved from when other is an rvalue
+  template <std::size_t I, class D>
+  static decltype(auto) _value_of(D &&other) noexcept {
+    if constexpr (std::is_lvalue_reference_v<D>) {
+      return *other.template cell<I>();
+    } else {
+      return std::move(*other.template cell<I>());
+    }
+  }
+};
+
+// Special members of optional_tuple, only user-provided when one of the
+// payloads is not trivial.
+template <class D, bool Trivial, bool Copyable> struct tuple_storage : D {};
+
+template <class D> struct tuple_storage<D, false, true> : D {
+  tuple_storage() = default;
+  // NOLINTNEXTLINE(bugprone-copy-constructor-init)
+  tuple_storage(const tuple_storage &other) { D::build_from(other); }
+  tuple_storage(tuple_storage &&other) noexcept(D::nothrow_move_construct) {
+    D::build_from(std::move(other));
+  }
+  tuple_storage &operator=(const tuple_storage &other) {
+    if (std::addressof(other) != this) {
+      D::assign_from(other);
+    }
+    return *this;
+  }
+  tuple_storage &
+  operator=(tuple_storage &&other) noexcept(D::nothrow_move_assign) {
+    if (std::addressof(other) != this) {
+      D::assign_from(std::move(other));
+    }
+    return *this;
+  }
+  ~tuple_storage() { D::destroy_all(); }
+};
+
+template <class D> struct tuple_storage<D, false, false> : D {
+  tuple_storage() = default;
+  tuple_storage(const tuple_storage &other) = delete;
+  tuple_storage(tuple_storage &&other) noexcept(D::nothrow_move_construct) {
+    D::build_from(std::move(other));
+  }
+  tuple_storage &operator=(const tuple_storage &other) = delete;
+  tuple_storage &
+  operator=(tuple_storage &&other) noexcept(D::nothrow_move_assign) {
+    if (std::addressof(other) != this) {
+      D::assign_from(std::move(other));
+    }
+    return *this;
+  }
+  ~tuple_storage() { D::destroy_all(); }
+};
+
+template <class T, class U>
+using initializes_element =
+    std::disjunction<std::is_same<remove_cvref_t<U>, nullopt_t>,
+                     std::is_constructible<T, U>>;
+} // namespace detail
+
+// Fixed set of optional values, e.g. the optional fields of a record, sharing
+// a single presence mask rather than carrying a (padded) flag each. Payloads
+// are laid out by decreasing alignment in one buffer, followed by the mask,
+// the smallest unsigned integer holding a bit per element.
+//
+// Elements are accessed by index or tag through bitmap_reference proxies
+// exposing the interface selected by the Access policy, including emplace,
+// reset and value. Whole-tuple checks read the mask alone.
+//
+// Trivially copyable when every payload is.
+template <class Access, class... Es> class basic_optional_tuple {
+  static_assert(sizeof...(Es) > 0 && sizeof...(Es) <= 64,
+                "optional_tuple holds between 1 and 64 elements");
+  template <class E> using type_of = typename detail::tuple_field<E>::type;
+  static_assert(std::conjunction_v<std::is_object<type_of<Es>>...>,
+                "optional_tuple cannot contain a reference type");
+
+  using data = detail::tuple_data<type_of<Es>...>;
+  template <std::size_t I> using type_at = typename data::template type_at<I>;
+
+public:
+  using mask_type = typename data::mask_type;
+  template <std::size_t I> using element_type = type_at<I>;
+  template <std::size_t I>
+  using reference = bitmap_reference<type_at<I>, Access, mask_type>;
+  template <std::size_t I>
+  using const_reference =
+      bitmap_reference<const type_at<I>, Access, const mask_type>;
+
+  constexpr static inline std::size_t size = sizeof...(Es);
+  // Bits of every element, set when the tuple is fully engaged
+  constexpr static inline mask_type full_mask = static_cast<mask_type>(
+      std::numeric_limits<mask_type>::max() >>
+      (std::numeric_limits<mask_type>::digits - size));
+
+  basic_optional_tuple() = default;
+
+  // One value, or nullopt, per element
+  template <class... Us,
+            std::enable_if_t<sizeof...(Us) == sizeof...(Es) &&
+                                 std::conjunction_v<detail::initializes_element<
+                                     type_of<Es>, Us>...>,
+                             int> = 0>
+  // NOLINTNEXTLINE
+  basic_optional_tuple(Us &&... values) {
+    try {
+      _init(std::index_sequence_for<Es...>{}, std::forward<Us>(values)...);
+    } catch (...) {
+      _data.destroy_all();
+      throw;
+    }
+  }
+
+  // Element access
+
+  template <std::size_t I> [[nodiscard]] reference<I> get() noexcept {
+    return reference<I>{_data.template cell<I>(), &_data.mask,
+                        data::template bit<I>};
+  }
+  template <std::size_t I>
+  [[nodiscard]] const_reference<I> get() const noexcept {
+    return const_reference<I>{_data.template cell<I>(), &_data.mask,
+                              data::template bit<I>};
+  }
+  template <class Tag>
+  [[nodiscard]] reference<detail::tuple_index<Tag, Es...>()> get() noexcept {
+    return get<detail::tuple_index<Tag, Es...>()>();
+  }
+  template <class Tag>
+  [[nodiscard]] const_reference<detail::tuple_index<Tag, Es...>()>
+  get() const noexcept {
+    return get<detail::tuple_index<Tag, Es...>()>();
+  }
+
+  // Presence
+
+  template <std::size_t I> [[nodiscard]] bool has_value() const noexcept {
+    return _data.template holds<I>();
+  }
+  template <class Tag> [[nodiscard]] bool has_value() const noexcept {
+    return has_value<detail::tuple_index<Tag, Es...>()>();
+  }
+
+  [[nodiscard]] bool all_engaged() const noexcept {
+    return _data.mask == full_mask;
+  }
+  [[nodiscard]] bool any_engaged() const noexcept { return _data.mask != 0; }
+
+  // Number of engaged elements
+  [[nodiscard]] std::size_t count() const noexcept {
+    std::size_t result = 0;
+    for (mask_type m = _data.mask; m != 0;
+         m = static_cast<mask_type>(m & (m - 1))) {
+      ++result;
+    }
+    return result;
+  }
+
+  // Bit I is set when element I is engaged
+  [[nodiscard]] mask_type mask() const noexcept { return _data.mask; }
+
+  // Empties every element
+  void reset() noexcept { _data.destroy_all(); }
+
+private:
+  detail::tuple_storage<
+      data, std::conjunction_v<std::is_trivially_copyable<type_of<Es>>...>,
+      std::conjunction_v<std::is_copy_constructible<type_of<Es>>...,
+                         std::is_copy_assignable<type_of<Es>>...>>
+      _data;
+
+  template <std::size_t... Is, class... Us>
+  void _init([[maybe_unused]] std::index_sequence<Is...> is, Us &&... values) {
+    (_init_one<Is>(std::forward<Us>(values)), ...);
+  }
+  template <std::size_t I, class U> void _init_one(U &&value) {
+    if constexpr (!std::is_same_v<detail::remove_cvref_t<U>, nullopt_t>) {
+      _data.template build<I>(std::forward<U>(value));
+    }
+  }
+};
+
+template <class... Es>
+using optional_tuple = basic_optional_tuple<access::extended, Es...>;
+
+template <class Access, class... Es>
+struct is_trivially_relocatable<basic_optional_tuple<Access, Es...>>
+    : std::conjunction<
+          is_trivially_relocatable<typename detail::tuple_field<Es>::type>...> {
+};
+
+} // namespace dpsg
+
+#endif // GUARD_OPTIONAL_TUPLE_HEADER
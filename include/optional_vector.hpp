@@ -0,0 +1,617 @@
+#ifndef GUARD_OPTIONAL_VECTOR_HEADER
+#define GUARD_OPTIONAL_VECTOR_HEADER
+
+#include "bitmap_reference.hpp"
+#include "generalized_optional.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+// Contiguous sequence of optional values. Payloads are stored in one dense
+// array and presence in a separate bitmap, so that every element costs
+// sizeof(T) bytes plus a single bit.
+//
+// Elements are accessed through bitmap_reference proxies exposing the
+// interface selected by the Access policy.
+//
+// Empty slots of trivial types hold a value-initialized T, so that the whole
+// value array can be read (and copied) regardless of presence.
+template <class T, class Access = access::extended,
+          class Allocator = std::allocator<T>>
+class optional_vector {
+  static_assert(!std::is_reference_v<T>,
+                "optional_vector cannot contain a reference type");
+  static_assert(!std::is_const_v<T>, "optional_vector of const elements");
+
+public:
+  using value_type = T;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using word_type = std::uint64_t;
+  using reference = bitmap_reference<T, Access, word_type>;
+  using const_reference = bitmap_reference<const T, Access, const word_type>;
+
+  constexpr static inline size_type bits_per_word =
+      std::numeric_limits<word_type>::digits;
+
+private:
+  using value_traits = std::allocator_traits<Allocator>;
+  using word_allocator =
+      typename value_traits::template rebind_alloc<word_type>;
+  using word_traits = std::allocator_traits<word_allocator>;
+
+  constexpr static inline bool trivial_slots =
+      std::is_trivially_copyable_v<T> &&
+      std::is_trivially_default_constructible_v<T>;
+  // Values that can be moved around with memcpy, empty slots included
+  constexpr static inline bool relocatable_slots =
+      trivial_slots || is_trivially_relocatable_v<T>;
+  // Move assignments can take the buffers whatever the allocators
+  constexpr static inline bool moves_buffers =
+      value_traits::propagate_on_container_move_assignment::value ||
+      value_traits::is_always_equal::value;
+
+  template <bool Const> class basic_iterator {
+    using container =
+        std::conditional_t<Const, const optional_vector, optional_vector>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, const_reference,
+                                         typename optional_vector::reference>;
+    using pointer = void;
+
+    constexpr basic_iterator() noexcept = default;
+    constexpr basic_iterator(container *c, size_type idx) noexcept
+        : _container(c), _index(idx) {}
+    // NOLINTNEXTLINE
+    constexpr basic_iterator(const basic_iterator<false> &other) noexcept
+        : _container(other._container), _index(other._index) {}
+
+    constexpr reference operator*() const { return (*_container)[_index]; }
+    constexpr reference operator[](difference_type n) const {
+      return (*_container)[_index + n];
+    }
+
+    constexpr basic_iterator &operator++() noexcept {
+      ++_index;
+      return *this;
+    }
+    constexpr basic_iterator operator++(int) noexcept {
+      auto cpy = *this;
+      ++_index;
+      return cpy;
+    }
+    constexpr basic_iterator &operator--() noexcept {
+      --_index;
+      return *this;
+    }
+    constexpr basic_iterator operator--(int) noexcept {
+      auto cpy = *this;
+      --_index;
+      return cpy;
+    }
+    constexpr basic_iterator &operator+=(difference_type n) noexcept {
+      _index += n;
+      return *this;
+    }
+    constexpr basic_iterator &operator-=(difference_type n) noexcept {
+      _index -= n;
+      return *this;
+    }
+    friend constexpr basic_iterator operator+(basic_iterator it,
+                                              difference_type n) noexcept {
+      return it += n;
+    }
+    friend constexpr basic_iterator operator+(difference_type n,
+                                              basic_iterator it) noexcept {
+      return it += n;
+    }
+    friend constexpr basic_iterator operator-(basic_iterator it,
+                                              difference_type n) noexcept {
+      return it -= n;
+    }
+    friend constexpr difference_type
+    operator-(const basic_iterator &lhv, const basic_iterator &rhv) noexcept {
+      return static_cast<difference_type>(lhv._index) -
+             static_cast<difference_type>(rhv._index);
+    }
+    friend constexpr bool operator==(const basic_iterator &lhv,
+                                     const basic_iterator &rhv) noexcept {
+      return lhv._index == rhv._index;
+    }
+    friend constexpr bool operator!=(const basic_iterator &lhv,
+                                     const basic_iterator &rhv) noexcept {
+      return lhv._index != rhv._index;
+    }
+    friend constexpr bool operator<(const basic_iterator &lhv,
+                                    const basic_iterator &rhv) noexcept {
+      return lhv._index < rhv._index;
+    }
+    friend constexpr bool operator>(const basic_iterator &lhv,
+                                    const basic_iterator &rhv) noexcept {
+      return lhv._index > rhv._index;
+    }
+    friend constexpr bool operator<=(const basic_iterator &lhv,
+                                     const basic_iterator &rhv) noexcept {
+      return lhv._index <= rhv._index;
+    }
+    friend constexpr bool operator>=(const basic_iterator &lhv,
+                                     const basic_iterator &rhv) noexcept {
+      return lhv._index >= rhv._index;
+    }
+
+  private:
+    friend optional_vector;
+    friend basic_iterator<!Const>;
+    container *_container = nullptr;
+    size_type _index = 0;
+  };
+
+public:
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  optional_vector() noexcept(noexcept(Allocator())) = default;
+  explicit optional_vector(const Allocator &alloc) noexcept : _alloc(alloc) {}
+  explicit optional_vector(size_type count,
+                           const Allocator &alloc = Allocator())
+      : _alloc(alloc) {
+    resize(count);
+  }
+  optional_vector(size_type count, const T &value,
+                  const Allocator &alloc = Allocator())
+      : _alloc(alloc) {
+    resize(count, value);
+  }
+  optional_vector(std::initializer_list<T> ilist,
+                  const Allocator &alloc = Allocator())
+      : _alloc(alloc) {
+    reserve(ilist.size());
+    for (const auto &v : ilist) {
+      push_back(v);
+    }
+  }
+
+  optional_vector(const optional_vector &other)
+      : optional_vector(other,
+                        value_traits::select_on_container_copy_construction(
+                            other._alloc)) {}
+
+  optional_vector(const optional_vector &other, const Allocator &alloc)
+      : _alloc(alloc) {
+    reserve(other._size);
+    for (size_type i = 0; i < other._size; ++i) {
+      if (other.has_value(i)) {
+        push_back(other._values[i]);
+      } else {
+        push_back(nullopt);
+      }
+    }
+  }
+
+  optional_vector(optional_vector &&other) noexcept
+      : _alloc(std::move(other._alloc)),
+        _values(std::exchange(other._values, nullptr)),
+        _words(std::exchange(other._words, nullptr)),
+        _size(std::exchange(other._size, 0)),
+        _capacity(std::exchange(other._capacity, 0)) {}
+
+  optional_vector &operator=(const optional_vector &other) {
+    if (std::addressof(other) != this) {
+      constexpr bool propagate =
+          value_traits::propagate_on_container_copy_assignment::value;
+      optional_vector cpy{other, propagate ? other._alloc : _alloc};
+      _take<propagate>(cpy);
+    }
+    return *this;
+  }
+
+  optional_vector &
+  operator=(optional_vector &&other) noexcept(moves_buffers) {
+    if constexpr (!moves_buffers) {
+      if (_alloc != other._alloc) {
+        // The buffers of other cannot be freed with this allocator
+        optional_vector cpy{_alloc};
+        cpy.reserve(other._size);
+        for (size_type i = 0; i < other._size; ++i) {
+          if (other.has_value(i)) {
+            cpy.push_back(std::move(other._values[i]));
+          } else {
+            cpy.push_back(nullopt);
+          }
+        }
+        _take<false>(cpy);
+        return *this;
+      }
+    }
+    if (std::addressof(other) != this) {
+      _take<value_traits::propagate_on_container_move_assignment::value>(
+          other);
+    }
+    return *this;
+  }
+
+  ~optional_vector() {
+    clear();
+    _deallocate(_values, _words, _capacity);
+  }
+
+  // As for std::vector, the allocators must be equal unless they propagate
+  void swap(optional_vector &other) noexcept {
+    using std::swap;
+    if constexpr (value_traits::propagate_on_container_swap::value) {
+      swap(_alloc, other._alloc);
+    }
+    swap(_values, other._values);
+    swap(_words, other._words);
+    swap(_size, other._size);
+    swap(_capacity, other._capacity);
+  }
+
+  friend void swap(optional_vector &lhv, optional_vector &rhv) noexcept {
+    lhv.swap(rhv);
+  }
+
+  [[nodiscard]] allocator_type get_allocator() const { return _alloc; }
+
+  // Capacity
+
+  [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+  [[nodiscard]] size_type size() const noexcept { return _size; }
+  [[nodiscard]] size_type capacity() const noexcept { return _capacity; }
+  [[nodiscard]] size_type max_size() const noexcept {
+    return value_traits::max_size(_alloc);
+  }
+
+  void reserve(size_type new_capacity) {
+    if (new_capacity <= _capacity) {
+      return;
+    }
+    if (new_capacity > max_size()) {
+      throw std::length_error("optional_vector::reserve");
+    }
+    _reallocate(new_capacity);
+  }
+
+  // Presence
+
+  [[nodiscard]] bool has_value(size_type idx) const noexcept {
+    return (_words[idx / bits_per_word] & _mask(idx)) != 0;
+  }
+
+  // Number of engaged elements
+  [[nodiscard]] size_type count() const noexcept {
+    size_type result = 0;
+    for (size_type w = 0; w < _word_count(_size); ++w) {
+      result += static_cast<size_type>(_popcount(_words[w]));
+    }
+    return result;
+  }
+
+  // Raw access to the underlying arrays. Bits past size() are always 0.
+  [[nodiscard]] T *data() noexcept { return _values; }
+  [[nodiscard]] const T *data() const noexcept { return _values; }
+  [[nodiscard]] word_type *bitmap() noexcept { return _words; }
+  [[nodiscard]] const word_type *bitmap() const noexcept { return _words; }
+
+  // Element access
+
+  [[nodiscard]] reference operator[](size_type idx) noexcept {
+    return reference{_values + idx, _words + idx / bits_per_word, _mask(idx)};
+  }
+  [[nodiscard]] const_reference operator[](size_type idx) const noexcept {
+    return const_reference{_values + idx, _words + idx / bits_per_word,
+                           _mask(idx)};
+  }
+  [[nodiscard]] reference at(size_type idx) {
+    _check_range(idx);
+    return (*this)[idx];
+  }
+  [[nodiscard]] const_reference at(size_type idx) const {
+    _check_range(idx);
+    return (*this)[idx];
+  }
+  [[nodiscard]] reference front() noexcept { return (*this)[0]; }
+  [[nodiscard]] const_reference front() const noexcept { return (*this)[0]; }
+  [[nodiscard]] reference back() noexcept { return (*this)[_size - 1]; }
+  [[nodiscard]] const_reference back() const noexcept {
+    return (*this)[_size - 1];
+  }
+
+  // Iterators
+
+  [[nodiscard]] iterator begin() noexcept { return iterator{this, 0}; }
+  [[nodiscard]] iterator end() noexcept { return iterator{this, _size}; }
+  [[nodiscard]] const_iterator begin() const noexcept {
+    return const_iterator{this, 0};
+  }
+  [[nodiscard]] const_iterator end() const noexcept {
+    return const_iterator{this, _size};
+  }
+  [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+  [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+  // Modifiers
+
+  void clear() noexcept {
+    _destroy_range(0, _size);
+    _size = 0;
+  }
+
+  void push_back(const T &value) { emplace_back(value); }
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+  void push_back([[maybe_unused]] nullopt_t empty) {
+    _grow_for_one();
+    _build_empty(_size);
+    ++_size;
+  }
+
+  template <class... Args> reference emplace_back(Args &&... args) {
+    if (_size == _capacity) {
+      // args may refer to an element: the new one is built before the old
+      // ones are moved
+      _reallocate<true>(_grown_capacity(), std::forward<Args>(args)...);
+      _set(_size);
+    } else {
+      _build(_size, std::forward<Args>(args)...);
+    }
+    return (*this)[_size++];
+  }
+
+  void pop_back() noexcept {
+    --_size;
+    _destroy_range(_size, _size + 1);
+  }
+
+  // New elements are empty
+  void resize(size_type count) {
+    if (count < _size) {
+      _destroy_range(count, _size);
+      _size = count;
+      return;
+    }
+    reserve(count);
+    for (; _size < count; ++_size) {
+      _build_empty(_size);
+    }
+  }
+
+  // New elements hold a copy of value
+  void resize(size_type count, const T &value) {
+    if (count < _size) {
+      resize(count);
+      return;
+    }
+    if (count > _capacity) {
+      // value may refer to an element, which reserve moves
+      const T copy = value;
+      reserve(count);
+      resize(count, copy);
+      return;
+    }
+    for (; _size < count; ++_size) {
+      _build(_size, value);
+    }
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, std::next(pos)); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    const size_type from = first._index;
+    const size_type to = last._index;
+    if (from == to) {
+      return iterator{this, from};
+    }
+    const size_type removed = to - from;
+    _destroy_range(from, to);
+    if constexpr (relocatable_slots) {
+      std::memmove(static_cast<void *>(_values + from), _values + to,
+                   (_size - to) * sizeof(T));
+      for (size_type src = to; src < _size; ++src) {
+        if (has_value(src)) {
+          _set(src - removed);
+          _clear(src);
+        }
+      }
+    } else {
+      for (size_type src = to; src < _size; ++src) {
+        if (has_value(src)) {
+          _construct(src - removed, std::move(_values[src]));
+          _set(src - removed);
+          _values[src].~T();
+          _clear(src);
+        }
+      }
+    }
+    _size -= removed;
+    return iterator{this, from};
+  }
+
+private:
+  Allocator _alloc{};
+  T *_values = nullptr;
+  word_type *_words = nullptr;
+  size_type _size = 0;
+  size_type _capacity = 0;
+
+  constexpr static word_type _mask(size_type idx) noexcept {
+    return word_type{1} << (idx % bits_per_word);
+  }
+  constexpr static size_type _word_count(size_type count) noexcept {
+    return (count + bits_per_word - 1) / bits_per_word;
+  }
+  constexpr static int _popcount(word_type w) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(w);
+#else
+    int result = 0;
+    for (; w != 0; w &= w - 1) {
+      ++result;
+    }
+    return result;
+#endif
+  }
+
+  void _set(size_type idx) noexcept {
+    _words[idx / bits_per_word] |= _mask(idx);
+  }
+  void _clear(size_type idx) noexcept {
+    _words[idx / bits_per_word] &= ~_mask(idx);
+  }
+
+  void _check_range(size_type idx) const {
+    if (idx >= _size) {
+      throw std::out_of_range("optional_vector::at");
+    }
+  }
+
+  template <class... Args> void _construct(size_type idx, Args &&... args) {
+    value_traits::construct(_alloc, _values + idx,
+                            std::forward<Args>(args)...);
+  }
+
+  template <class... Args> void _build(size_type idx, Args &&... args) {
+    _construct(idx, std::forward<Args>(args)...);
+    _set(idx);
+  }
+
+  void _build_empty(size_type idx) noexcept {
+    if constexpr (trivial_slots) {
+      ::new (static_cast<void *>(_values + idx)) T();
+    }
+  }
+
+  void _destroy_range(size_type first, size_type last) noexcept {
+    for (size_type i = first; i < last; ++i) {
+      if (has_value(i)) {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+          value_traits::destroy(_alloc, _values + i);
+        }
+        _clear(i);
+      }
+    }
+  }
+
+  [[nodiscard]] size_type _grown_capacity() const {
+    const size_type grown = _capacity == 0 ? bits_per_word : _capacity * 2;
+    if (grown > max_size()) {
+      throw std::length_error("optional_vector::reserve");
+    }
+    return grown;
+  }
+
+  void _grow_for_one() {
+    if (_size == _capacity) {
+      _reallocate(_grown_capacity());
+    }
+  }
+
+  // Moves the elements to buffers of new_capacity. With Insert, element
+  // _size is first built from args in the new buffer, its presence bit is
+  // left to the caller.
+  template <bool Insert = false, class... Args>
+  void _reallocate(size_type new_capacity, Args &&... args) {
+    word_allocator walloc{_alloc};
+    T *values = value_traits::allocate(_alloc, new_capacity);
+    word_type *words = nullptr;
+    try {
+      words = word_traits::allocate(walloc, _word_count(new_capacity));
+    } catch (...) {
+      value_traits::deallocate(_alloc, values, new_capacity);
+      throw;
+    }
+    const size_type used_words = _word_count(_size);
+    std::fill(std::copy(_words, _words + used_words, words),
+              words + _word_count(new_capacity), word_type{0});
+
+    if constexpr (Insert) {
+      try {
+        value_traits::construct(_alloc, values + _size,
+                                std::forward<Args>(args)...);
+      } catch (...) {
+        _deallocate(values, words, new_capacity);
+        throw;
+      }
+    }
+
+    if constexpr (relocatable_slots) {
+      if (_size > 0) {
+        std::memcpy(static_cast<void *>(values), _values, _size * sizeof(T));
+      }
+    } else {
+      // The old elements stay untouched until every new one is built
+      size_type built = 0;
+      try {
+        for (; built < _size; ++built) {
+          if (has_value(built)) {
+            value_traits::construct(_alloc, values + built,
+                                    std::move_if_noexcept(_values[built]));
+          }
+        }
+      } catch (...) {
+        for (size_type i = 0; i < built; ++i) {
+          if (has_value(i)) {
+            value_traits::destroy(_alloc, values + i);
+          }
+        }
+        if constexpr (Insert) {
+          value_traits::destroy(_alloc, values + _size);
+        }
+        _deallocate(values, words, new_capacity);
+        throw;
+      }
+      for (size_type i = 0; i < _size; ++i) {
+        if (has_value(i)) {
+          value_traits::destroy(_alloc, _values + i);
+        }
+      }
+    }
+
+    _deallocate(_values, _words, _capacity);
+    _values = values;
+    _words = words;
+    _capacity = new_capacity;
+  }
+
+  // Frees the elements and buffers, then takes those of other, which must
+  // have been allocated by an allocator equal to the one this ends up with
+  template <bool TakeAllocator> void _take(optional_vector &other) noexcept {
+    clear();
+    _deallocate(_values, _words, _capacity);
+    if constexpr (TakeAllocator) {
+      _alloc = std::move(other._alloc);
+    }
+    _values = std::exchange(other._values, nullptr);
+    _words = std::exchange(other._words, nullptr);
+    _size = std::exchange(other._size, 0);
+    _capacity = std::exchange(other._capacity, 0);
+  }
+
+  void _deallocate(T *values, word_type *words, size_type capacity) noexcept {
+    if (values != nullptr) {
+      word_allocator walloc{_alloc};
+      value_traits::deallocate(_alloc, values, capacity);
+      word_traits::deallocate(walloc, words, _word_count(capacity));
+    }
+  }
+};
+
+} // namespace dpsg
+
+#endif // GUARD_OPTIONAL_VECTOR_HEADER
@@ -0,0 +1,205 @@
+#ifndef GUARD_POOLED_STORAGE_HEADER
+#define GUARD_POOLED_STORAGE_HEADER
+
+#include "generalized_optional.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+namespace detail {
+// Blocks able to hold a T, or a freelist link
+template <class T>
+constexpr static inline std::size_t block_size =
+    std::max(sizeof(T), sizeof(void *));
+template <class T>
+constexpr static inline std::size_t block_alignment =
+    std::max(alignof(T), alignof(void *));
+
+template <class T> void *allocate_block() {
+  return ::operator new(block_size<T>, std::align_val_t{block_alignment<T>});
+}
+
+template <class T> void deallocate_block(void *block) noexcept {
+  ::operator delete(block, std::align_val_t{block_alignment<T>});
+}
+
+inline std::pmr::memory_resource *new_delete_resource() noexcept {
+  return std::pmr::new_delete_resource();
+}
+} // namespace detail
+
+// Pools used by storage::pooled. A pool provides
+//   template <class T> static void *allocate();
+//   template <class T> static void deallocate(void *) noexcept;
+// returning blocks suitable for a T. Pools are stateless, so that a pooled
+// optional only holds a pointer.
+namespace pool {
+// Per thread and per type list of free blocks, refilled from operator new.
+// A block freed by another thread joins that thread's list. Free blocks are
+// returned to the system when their thread exits.
+struct freelist {
+private:
+  struct node {
+    node *next;
+  };
+
+  // Trivially destructible, so that it is still usable by the destructors of
+  // other thread_local objects
+  template <class T> struct state {
+    node *head;
+    bool exited;
+  };
+
+  template <class T> struct drain {
+    drain() = default;
+    drain(const drain &) = delete;
+    drain(drain &&) = delete;
+    drain &operator=(const drain &) = delete;
+    drain &operator=(drain &&) = delete;
+    ~drain() {
+      state<T> &s = _state<T>();
+      while (s.head != nullptr) {
+        node *block = s.head;
+        s.head = block->next;
+        detail::deallocate_block<T>(block);
+      }
+      s.exited = true;
+    }
+  };
+
+  template <class T> static state<T> &_state() noexcept {
+    thread_local state<T> s{nullptr, false};
+    return s;
+  }
+
+  // Must not be called once the thread's drain has run
+  template <class T> static void _register_drain() noexcept {
+    thread_local drain<T> guard;
+  }
+
+public:
+  template <class T> static void *allocate() {
+    state<T> &s = _state<T>();
+    if (s.head == nullptr) {
+      return detail::allocate_block<T>();
+    }
+    node *block = s.head;
+    s.head = block->next;
+    return block;
+  }
+
+  template <class T> static void deallocate(void *block) noexcept {
+    state<T> &s = _state<T>();
+    if (s.exited) {
+      detail::deallocate_block<T>(block);
+      return;
+    }
+    _register_drain<T>();
+    s.head = ::new (block) node{s.head};
+  }
+};
+
+// Allocates from the std::pmr::memory_resource returned by Resource, which
+// must be the same on every call
+template <std::pmr::memory_resource *(*Resource)() =
+              &detail::new_delete_resource>
+struct memory_resource {
+  template <class T> static void *allocate() {
+    return Resource()->allocate(sizeof(T), alignof(T));
+  }
+
+  template <class T> static void deallocate(void *block) noexcept {
+    Resource()->deallocate(block, sizeof(T), alignof(T));
+  }
+};
+} // namespace pool
+
+namespace storage {
+// Keeps only a pointer inline, the value lives in a block of Pool allocated
+// when the optional becomes engaged. The pointer is null when empty, use
+// control::from_storage to make it the presence marker.
+//
+// Copies and destruction are done by generalized_optional, which rebuilds the
+// value in a new block. The special members below are only declared so that
+// it does not copy the pointer.
+template <class Pool = pool::freelist> struct pooled {
+  template <class B> class type : public B {
+  private:
+    using T = typename B::type;
+    T *_value = nullptr;
+
+  public:
+    constexpr static inline bool stealable = true;
+    constexpr static inline bool relocatable = true;
+
+  protected:
+    constexpr type() = default;
+
+    constexpr explicit type([[maybe_unused]] std::nullopt_t marker) noexcept {}
+
+    template <class... Args>
+    explicit type([[maybe_unused]] in_place_t marker, Args &&... args) {
+      build(std::forward<Args>(args)...);
+    }
+
+    // NOLINTNEXTLINE(bugprone-copy-constructor-init)
+    constexpr type([[maybe_unused]] const type &other) noexcept {}
+    // NOLINTNEXTLINE(cert-oop54-cpp)
+    constexpr type &operator=([[maybe_unused]] const type &other) noexcept {
+      return *this;
+    }
+    // The value is destroyed by generalized_optional
+    ~type() {} // NOLINT(modernize-use-equals-default)
+
+    [[nodiscard]] constexpr bool holds_value() const noexcept {
+      return _value != nullptr;
+    }
+
+    constexpr T *get_ptr() noexcept { return _value; }
+    constexpr const T *get_ptr() const noexcept { return _value; }
+    constexpr T &&get_ref() &&noexcept { return std::move(*_value); }
+    constexpr const T &&get_ref() const &&noexcept {
+      return std::move(*_value);
+    }
+    constexpr T &get_ref() &noexcept { return *_value; }
+    constexpr const T &get_ref() const &noexcept { return *_value; }
+
+    template <class... Args> void build(Args &&... args) {
+      void *block = Pool::template allocate<T>();
+      try {
+        _value =
+            dpsg::detail::construct_at<T>(block, std::forward<Args>(args)...);
+      } catch (...) {
+        Pool::template deallocate<T>(block);
+        throw;
+      }
+    }
+
+    void destroy() noexcept {
+      _value->~T();
+      Pool::template deallocate<T>(_value);
+      _value = nullptr;
+    }
+
+    // Takes the value of other, this must be empty
+    constexpr void steal(type &other) noexcept {
+      _value = std::exchange(other._value, nullptr);
+    }
+  };
+};
+} // namespace storage
+
+// Pointer sized optional, for large and mostly empty values
+template <class T, class Pool = pool::freelist>
+using optional_pooled = generalized_optional<
+    T, policy<access::extended, control::from_storage, storage::pooled<Pool>>>;
+
+} // namespace dpsg
+
+#endif // GUARD_POOLED_STORAGE_HEADER
@@ -0,0 +1,158 @@
+#ifndef GUARD_SMALL_BUFFER_STORAGE_HEADER
+#define GUARD_SMALL_BUFFER_STORAGE_HEADER
+
+#include "generalized_optional.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace dpsg {
+
+namespace storage {
+namespace detail {
+// Value type of a policy chain, which only derived policies can name
+template <class B> struct chain_value_type : B {
+  using type = typename B::type;
+};
+
+template <class B, std::size_t N, std::size_t Align>
+class small_buffer_inline : public B {
+private:
+  using T = typename B::type;
+
+public:
+  constexpr static inline bool relocatable = is_trivially_relocatable_v<T>;
+  constexpr static inline bool inline_value = true;
+
+protected:
+  alignas(Align) unsigned char _buffer[N];
+
+  constexpr small_buffer_inline() = default;
+
+  constexpr explicit small_buffer_inline(
+      [[maybe_unused]] std::nullopt_t marker) {}
+
+  template <class... Args>
+  constexpr explicit small_buffer_inline(
+      [[maybe_unused]] in_place_t marker,
+      Args &&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+    build(std::forward<Args>(args)...);
+  }
+
+  T *get_ptr() noexcept {
+    return std::launder(reinterpret_cast<T *>(_buffer)); // NOLINT
+  }
+  const T *get_ptr() const noexcept {
+    return std::launder(reinterpret_cast<const T *>(_buffer)); // NOLINT
+  }
+  T &&get_ref() &&noexcept { return std::move(*get_ptr()); }
+  const T &&get_ref() const &&noexcept { return std::move(*get_ptr()); }
+  T &get_ref() &noexcept { return *get_ptr(); }
+  const T &get_ref() const &noexcept { return *get_ptr(); }
+  template <class... Args> void build(Args &&... args) {
+    dpsg::detail::construct_at<T>(_buffer, std::forward<Args>(args)...);
+  }
+  void destroy() noexcept { get_ptr()->~T(); }
+};
+
+// Same footprint as small_buffer_inline, holds a pointer to a heap block. As
+// for storage::pooled, copies and destruction are left to
+// generalized_optional.
+template <class B, std::size_t N, std::size_t Align>
+class small_buffer_heap : public B {
+private:
+  using T = typename B::type;
+  union alignas(Align) slot {
+    T *value;
+    unsigned char bytes[N];
+  } _slot{nullptr};
+
+public:
+  constexpr static inline bool stealable = true;
+  constexpr static inline bool relocatable = true;
+
+protected:
+  constexpr small_buffer_heap() = default;
+
+  constexpr explicit small_buffer_heap(
+      [[maybe_unused]] std::nullopt_t marker) noexcept {}
+
+  template <class... Args>
+  explicit small_buffer_heap([[maybe_unused]] in_place_t marker,
+                             Args &&... args) {
+    build(std::forward<Args>(args)...);
+  }
+
+  // NOLINTNEXTLINE(bugprone-copy-constructor-init)
+  constexpr small_buffer_heap(
+      [[maybe_unused]] const small_buffer_heap &other) noexcept {}
+  // NOLINTNEXTLINE(cert-oop54-cpp)
+  constexpr small_buffer_heap &
+  operator=([[maybe_unused]] const small_buffer_heap &other) noexcept {
+    return *this;
+  }
+  ~small_buffer_heap() {} // NOLINT(modernize-use-equals-default)
+
+  [[nodiscard]] constexpr bool holds_value() const noexcept {
+    return _slot.value != nullptr;
+  }
+
+  constexpr T *get_ptr() noexcept { return _slot.value; }
+  constexpr const T *get_ptr() const noexcept { return _slot.value; }
+  constexpr T &&get_ref() &&noexcept { return std::move(*_slot.value); }
+  constexpr const T &&get_ref() const &&noexcept {
+    return std::move(*_slot.value);
+  }
+  constexpr T &get_ref() &noexcept { return *_slot.value; }
+  constexpr const T &get_ref() const &noexcept { return *_slot.value; }
+  template <class... Args> void build(Args &&... args) {
+    _slot.value = dpsg::detail::allocate<T>(std::forward<Args>(args)...);
+  }
+  void destroy() noexcept {
+    delete _slot.value;
+    _slot.value = nullptr;
+  }
+
+  // Takes the value of other, this must be empty
+  constexpr void steal(small_buffer_heap &other) noexcept {
+    _slot.value = std::exchange(other._slot.value, nullptr);
+  }
+};
+} // namespace detail
+
+// N bytes of inline storage. Types that fit, and that can be moved without
+// throwing, are built in place, others in a heap block whose pointer takes
+// their place. The choice is made per type, so that the optional has the same
+// footprint whatever T is.
+template <std::size_t N, std::size_t Align = alignof(std::max_align_t)>
+struct small_buffer {
+  static_assert(N >= sizeof(void *),
+                "the buffer must be able to hold a pointer");
+
+  template <class T>
+  constexpr static inline bool stores_inline =
+      sizeof(T) <= N && alignof(T) <= Align &&
+      std::is_nothrow_move_constructible_v<T>;
+
+  template <class B>
+  using type = std::conditional_t<
+      stores_inline<typename detail::chain_value_type<B>::type>,
+      detail::small_buffer_inline<B, N, Align>,
+      detail::small_buffer_heap<B, N, Align>>;
+};
+} // namespace storage
+
+// Optional of N bytes whatever T is. Moving from one that holds T in a heap
+// block steals the block, the moved-from optional is then empty. When T is
+// stored inline it is moved instead, and the moved-from optional stays engaged
+// with a moved-from T, as std::optional does.
+template <class T, std::size_t N = 4 * sizeof(void *)>
+using optional_small = generalized_optional<
+    T, policy<access::extended, control::dependent_bool,
+              storage::small_buffer<N>>>;
+
+} // namespace dpsg
+
+#endif // GUARD_SMALL_BUFFER_STORAGE_HEADER
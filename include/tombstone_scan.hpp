@@ -0,0 +1,742 @@
+#ifndef GUARD_TOMBSTONE_SCAN_HEADER
+#define GUARD_TOMBSTONE_SCAN_HEADER
+
+#include "generalized_optional.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define DPSG_SCAN_X86 1
+#include <immintrin.h>
+#define DPSG_SCAN_TARGET_SSE2 __attribute__((target("sse2")))
+#define DPSG_SCAN_TARGET_AVX2 __attribute__((target("avx2,popcnt,bmi")))
+#define DPSG_SCAN_TARGET_AVX512                                                \
+  __attribute__((target("avx512f,avx512bw,popcnt,bmi")))
+#else
+#define DPSG_SCAN_X86 0
+#endif
+
+// Bulk kernels over contiguous arrays of tombstone optionals.
+//
+// A tombstone optional is nothing but its payload, so testing presence is a
+// comparison of the raw representation against the sentinel (floating point
+// columns included, their NaN sentinel is compared as an integer). The kernels
+// below compare whole vectors of elements at once, using the widest
+// instruction set available at runtime.
+//
+// Functions looking for an element return its index, or the size of the
+// range when there is none.
+
+namespace dpsg {
+namespace scan {
+
+enum class isa { scalar, sse2, avx2, avx512 };
+
+namespace detail {
+template <std::size_t N> struct raw_word;
+template <> struct raw_word<1> { using type = std::uint8_t; };
+template <> struct raw_word<2> { using type = std::uint16_t; };
+template <> struct raw_word<4> { using type = std::uint32_t; };
+template <> struct raw_word<8> { using type = std::uint64_t; };
+template <class T> using raw_word_t = typename raw_word<sizeof(T)>::type;
+
+template <class O> struct tombstone_layout {
+  using value_type = typename O::value_type;
+  using word = raw_word_t<value_type>;
+  static_assert(sizeof(O) == sizeof(value_type) &&
+                    std::is_standard_layout_v<O>,
+                "scan kernels require optionals made of their payload only");
+
+  template <class U, class = void> struct has_bits : std::false_type {};
+  template <class U>
+  struct has_bits<U, std::void_t<decltype(U::tombstone_bits)>>
+      : std::true_type {};
+
+  static word sentinel() noexcept {
+    if constexpr (has_bits<O>::value) {
+      return O::tombstone_bits;
+    } else {
+      const auto value = O::tombstone_value;
+      word result;
+      std::memcpy(&result, &value, sizeof(word));
+      return result;
+    }
+  }
+  static word raw(const value_type &value) noexcept {
+    word result;
+    std::memcpy(&result, &value, sizeof(word));
+    return result;
+  }
+};
+
+template <class W> inline W load(const unsigned char *ptr) noexcept {
+  W result;
+  std::memcpy(&result, ptr, sizeof(W));
+  return result;
+}
+
+template <class W> inline void store(unsigned char *ptr, W value) noexcept {
+  std::memcpy(ptr, &value, sizeof(W));
+}
+
+struct scalar {
+  template <class W>
+  static std::size_t count_empty(const unsigned char *ptr, std::size_t size,
+                                 W sentinel) noexcept {
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      result += static_cast<std::size_t>(load<W>(ptr + i * sizeof(W)) ==
+                                         sentinel);
+    }
+    return result;
+  }
+
+  template <bool Empty, class W>
+  static std::size_t find_first(const unsigned char *ptr, std::size_t size,
+                                W sentinel) noexcept {
+    for (std::size_t i = 0; i < size; ++i) {
+      if ((load<W>(ptr + i * sizeof(W)) == sentinel) == Empty) {
+        return i;
+      }
+    }
+    return size;
+  }
+
+  template <bool Empty, class W>
+  static std::size_t find_last(const unsigned char *ptr, std::size_t size,
+                               W sentinel) noexcept {
+    for (std::size_t i = size; i-- > 0;) {
+      if ((load<W>(ptr + i * sizeof(W)) == sentinel) == Empty) {
+        return i;
+      }
+    }
+    return size;
+  }
+
+  template <class W>
+  static void fill(const unsigned char *src, unsigned char *dst,
+                   std::size_t size, W sentinel, W replacement) noexcept {
+    for (std::size_t i = 0; i < size; ++i) {
+      const W w = load<W>(src + i * sizeof(W));
+      store<W>(dst + i * sizeof(W), w == sentinel ? replacement : w);
+    }
+  }
+};
+
+#if DPSG_SCAN_X86
+
+inline int popcount(std::uint64_t mask) noexcept {
+  return __builtin_popcountll(mask);
+}
+inline int lowest_bit(std::uint64_t mask) noexcept {
+  return __builtin_ctzll(mask);
+}
+inline int highest_bit(std::uint64_t mask) noexcept {
+  return 63 - __builtin_clzll(mask);
+}
+
+// SSE2 and AVX2 masks come from movemask_epi8 and have sizeof(W) bits per
+// lane. AVX-512 comparisons produce one bit per lane.
+
+struct sse2 {
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static __m128i broadcast(W w) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return _mm_set1_epi8(static_cast<char>(w));
+    } else if constexpr (sizeof(W) == 2) {
+      return _mm_set1_epi16(static_cast<short>(w));
+    } else if constexpr (sizeof(W) == 4) {
+      return _mm_set1_epi32(static_cast<int>(w));
+    } else {
+      return _mm_set1_epi64x(static_cast<long long>(w));
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static __m128i equal(__m128i lhv,
+                                             __m128i rhv) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return _mm_cmpeq_epi8(lhv, rhv);
+    } else if constexpr (sizeof(W) == 2) {
+      return _mm_cmpeq_epi16(lhv, rhv);
+    } else if constexpr (sizeof(W) == 4) {
+      return _mm_cmpeq_epi32(lhv, rhv);
+    } else {
+      // No 64 bit comparison before SSE4.1: both halves must match
+      const __m128i halves = _mm_cmpeq_epi32(lhv, rhv);
+      return _mm_and_si128(halves,
+                           _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+  }
+
+  DPSG_SCAN_TARGET_SSE2 static __m128i load(const unsigned char *ptr) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr)); // NOLINT
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static std::uint64_t
+  empty_mask(const unsigned char *ptr, __m128i sentinel) noexcept {
+    return static_cast<std::uint16_t>(
+        _mm_movemask_epi8(equal<W>(load(ptr), sentinel)));
+  }
+
+  constexpr static inline std::size_t width = 16;
+  constexpr static inline std::uint64_t full_mask = 0xFFFF;
+
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static std::size_t
+  count_empty(const unsigned char *ptr, std::size_t size,
+              W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m128i s = broadcast(sentinel);
+    std::size_t bits = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      bits += popcount(empty_mask<W>(ptr + i * sizeof(W), s));
+    }
+    return bits / sizeof(W) +
+           scalar::count_empty(ptr + i * sizeof(W), size - i, sentinel);
+  }
+
+  template <bool Empty, class W>
+  DPSG_SCAN_TARGET_SSE2 static std::size_t
+  find_first(const unsigned char *ptr, std::size_t size, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m128i s = broadcast(sentinel);
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      std::uint64_t mask = empty_mask<W>(ptr + i * sizeof(W), s);
+      if constexpr (!Empty) {
+        mask = ~mask & full_mask;
+      }
+      if (mask != 0) {
+        return i + lowest_bit(mask) / sizeof(W);
+      }
+    }
+    return i + scalar::find_first<Empty>(ptr + i * sizeof(W), size - i,
+                                         sentinel);
+  }
+
+  template <bool Empty, class W>
+  DPSG_SCAN_TARGET_SSE2 static std::size_t
+  find_last(const unsigned char *ptr, std::size_t size, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m128i s = broadcast(sentinel);
+    std::size_t i = size - size % lanes;
+    const std::size_t tail =
+        scalar::find_last<Empty>(ptr + i * sizeof(W), size - i, sentinel);
+    if (tail != size - i) {
+      return i + tail;
+    }
+    while (i > 0) {
+      i -= lanes;
+      std::uint64_t mask = empty_mask<W>(ptr + i * sizeof(W), s);
+      if constexpr (!Empty) {
+        mask = ~mask & full_mask;
+      }
+      if (mask != 0) {
+        return i + highest_bit(mask) / sizeof(W);
+      }
+    }
+    return size;
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_SSE2 static void
+  fill(const unsigned char *src, unsigned char *dst, std::size_t size,
+       W sentinel, W replacement) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m128i s = broadcast(sentinel);
+    const __m128i r = broadcast(replacement);
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      const __m128i v = load(src + i * sizeof(W));
+      const __m128i m = equal<W>(v, s);
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i *>(dst + i * sizeof(W)), // NOLINT
+          _mm_or_si128(_mm_and_si128(m, r), _mm_andnot_si128(m, v)));
+    }
+    scalar::fill(src + i * sizeof(W), dst + i * sizeof(W), size - i,
+                 sentinel, replacement);
+  }
+};
+
+struct avx2 {
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static __m256i broadcast(W w) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return _mm256_set1_epi8(static_cast<char>(w));
+    } else if constexpr (sizeof(W) == 2) {
+      return _mm256_set1_epi16(static_cast<short>(w));
+    } else if constexpr (sizeof(W) == 4) {
+      return _mm256_set1_epi32(static_cast<int>(w));
+    } else {
+      return _mm256_set1_epi64x(static_cast<long long>(w));
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static __m256i equal(__m256i lhv,
+                                             __m256i rhv) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return _mm256_cmpeq_epi8(lhv, rhv);
+    } else if constexpr (sizeof(W) == 2) {
+      return _mm256_cmpeq_epi16(lhv, rhv);
+    } else if constexpr (sizeof(W) == 4) {
+      return _mm256_cmpeq_epi32(lhv, rhv);
+    } else {
+      return _mm256_cmpeq_epi64(lhv, rhv);
+    }
+  }
+
+  DPSG_SCAN_TARGET_AVX2 static __m256i load(const unsigned char *ptr) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr)); // NOLINT
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static std::uint64_t
+  empty_mask(const unsigned char *ptr, __m256i sentinel) noexcept {
+    return static_cast<std::uint32_t>(
+        _mm256_movemask_epi8(equal<W>(load(ptr), sentinel)));
+  }
+
+  constexpr static inline std::size_t width = 32;
+  constexpr static inline std::uint64_t full_mask = 0xFFFFFFFF;
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static std::size_t
+  count_empty(const unsigned char *ptr, std::size_t size,
+              W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m256i s = broadcast(sentinel);
+    std::size_t bits = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      bits += popcount(empty_mask<W>(ptr + i * sizeof(W), s));
+    }
+    return bits / sizeof(W) +
+           scalar::count_empty(ptr + i * sizeof(W), size - i, sentinel);
+  }
+
+  template <bool Empty, class W>
+  DPSG_SCAN_TARGET_AVX2 static std::size_t
+  find_first(const unsigned char *ptr, std::size_t size, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m256i s = broadcast(sentinel);
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      std::uint64_t mask = empty_mask<W>(ptr + i * sizeof(W), s);
+      if constexpr (!Empty) {
+        mask = ~mask & full_mask;
+      }
+      if (mask != 0) {
+        return i + lowest_bit(mask) / sizeof(W);
+      }
+    }
+    return i + scalar::find_first<Empty>(ptr + i * sizeof(W), size - i,
+                                         sentinel);
+  }
+
+  template <bool Empty, class W>
+  DPSG_SCAN_TARGET_AVX2 static std::size_t
+  find_last(const unsigned char *ptr, std::size_t size, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m256i s = broadcast(sentinel);
+    std::size_t i = size - size % lanes;
+    const std::size_t tail =
+        scalar::find_last<Empty>(ptr + i * sizeof(W), size - i, sentinel);
+    if (tail != size - i) {
+      return i + tail;
+    }
+    while (i > 0) {
+      i -= lanes;
+      std::uint64_t mask = empty_mask<W>(ptr + i * sizeof(W), s);
+      if constexpr (!Empty) {
+        mask = ~mask & full_mask;
+      }
+      if (mask != 0) {
+        return i + highest_bit(mask) / sizeof(W);
+      }
+    }
+    return size;
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX2 static void
+  fill(const unsigned char *src, unsigned char *dst, std::size_t size,
+       W sentinel, W replacement) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m256i s = broadcast(sentinel);
+    const __m256i r = broadcast(replacement);
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      const __m256i v = load(src + i * sizeof(W));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i *>(dst + i * sizeof(W)), // NOLINT
+          _mm256_blendv_epi8(v, r, equal<W>(v, s)));
+    }
+    scalar::fill(src + i * sizeof(W), dst + i * sizeof(W), size - i,
+                 sentinel, replacement);
+  }
+};
+
+struct avx512 {
+  template <class W>
+  DPSG_SCAN_TARGET_AVX512 static __m512i broadcast(W w) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return _mm512_set1_epi8(static_cast<char>(w));
+    } else if constexpr (sizeof(W) == 2) {
+      return _mm512_set1_epi16(static_cast<short>(w));
+    } else if constexpr (sizeof(W) == 4) {
+      return _mm512_set1_epi32(static_cast<int>(w));
+    } else {
+      return _mm512_set1_epi64(static_cast<long long>(w));
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX512 static std::uint64_t equal(__m512i lhv,
+                                                     __m512i rhv) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return _mm512_cmpeq_epi8_mask(lhv, rhv);
+    } else if constexpr (sizeof(W) == 2) {
+      return _mm512_cmpeq_epi16_mask(lhv, rhv);
+    } else if constexpr (sizeof(W) == 4) {
+      return _mm512_cmpeq_epi32_mask(lhv, rhv);
+    } else {
+      return _mm512_cmpeq_epi64_mask(lhv, rhv);
+    }
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX512 static __m512i
+  blend(std::uint64_t mask, __m512i lhv, __m512i rhv) noexcept {
+    if constexpr (sizeof(W) == 1) {
+      return _mm512_mask_mov_epi8(lhv, mask, rhv);
+    } else if constexpr (sizeof(W) == 2) {
+      return _mm512_mask_mov_epi16(lhv, static_cast<__mmask32>(mask), rhv);
+    } else if constexpr (sizeof(W) == 4) {
+      return _mm512_mask_mov_epi32(lhv, static_cast<__mmask16>(mask), rhv);
+    } else {
+      return _mm512_mask_mov_epi64(lhv, static_cast<__mmask8>(mask), rhv);
+    }
+  }
+
+  DPSG_SCAN_TARGET_AVX512 static __m512i load(const unsigned char *ptr) {
+    return _mm512_loadu_si512(ptr);
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX512 static std::uint64_t
+  empty_mask(const unsigned char *ptr, __m512i sentinel) noexcept {
+    return equal<W>(load(ptr), sentinel);
+  }
+
+  constexpr static inline std::size_t width = 64;
+
+  template <class W>
+  constexpr static std::uint64_t full_mask() noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    return lanes == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << lanes) - 1;
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX512 static std::size_t
+  count_empty(const unsigned char *ptr, std::size_t size,
+              W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m512i s = broadcast(sentinel);
+    std::size_t result = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      result += popcount(empty_mask<W>(ptr + i * sizeof(W), s));
+    }
+    return result +
+           scalar::count_empty(ptr + i * sizeof(W), size - i, sentinel);
+  }
+
+  template <bool Empty, class W>
+  DPSG_SCAN_TARGET_AVX512 static std::size_t
+  find_first(const unsigned char *ptr, std::size_t size, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m512i s = broadcast(sentinel);
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      std::uint64_t mask = empty_mask<W>(ptr + i * sizeof(W), s);
+      if constexpr (!Empty) {
+        mask = ~mask & full_mask<W>();
+      }
+      if (mask != 0) {
+        return i + lowest_bit(mask);
+      }
+    }
+    return i + scalar::find_first<Empty>(ptr + i * sizeof(W), size - i,
+                                         sentinel);
+  }
+
+  template <bool Empty, class W>
+  DPSG_SCAN_TARGET_AVX512 static std::size_t
+  find_last(const unsigned char *ptr, std::size_t size, W sentinel) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m512i s = broadcast(sentinel);
+    std::size_t i = size - size % lanes;
+    const std::size_t tail =
+        scalar::find_last<Empty>(ptr + i * sizeof(W), size - i, sentinel);
+    if (tail != size - i) {
+      return i + tail;
+    }
+    while (i > 0) {
+      i -= lanes;
+      std::uint64_t mask = empty_mask<W>(ptr + i * sizeof(W), s);
+      if constexpr (!Empty) {
+        mask = ~mask & full_mask<W>();
+      }
+      if (mask != 0) {
+        return i + highest_bit(mask);
+      }
+    }
+    return size;
+  }
+
+  template <class W>
+  DPSG_SCAN_TARGET_AVX512 static void
+  fill(const unsigned char *src, unsigned char *dst, std::size_t size,
+       W sentinel, W replacement) noexcept {
+    constexpr std::size_t lanes = width / sizeof(W);
+    const __m512i s = broadcast(sentinel);
+    const __m512i r = broadcast(replacement);
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+      const __m512i v = load(src + i * sizeof(W));
+      _mm512_storeu_si512(dst + i * sizeof(W),
+                          blend<W>(equal<W>(v, s), v, r));
+    }
+    scalar::fill(src + i * sizeof(W), dst + i * sizeof(W), size - i,
+                 sentinel, replacement);
+  }
+};
+
+#endif // DPSG_SCAN_X86
+
+inline isa detect_isa() noexcept {
+#if DPSG_SCAN_X86
+  __builtin_cpu_init();
+  const bool bit_ops = __builtin_cpu_supports("popcnt") != 0 &&
+                       __builtin_cpu_supports("bmi") != 0;
+  if (bit_ops && __builtin_cpu_supports("avx512f") != 0 &&
+      __builtin_cpu_supports("avx512bw") != 0) {
+    return isa::avx512;
+  }
+  if (bit_ops && __builtin_cpu_supports("avx2") != 0) {
+    return isa::avx2;
+  }
+  return isa::sse2;
+#else
+  return isa::scalar;
+#endif
+}
+
+// Calls f with the kernel set matching the requested instruction set
+template <class F> decltype(auto) dispatch(isa target, F &&f) {
+  switch (target) {
+#if DPSG_SCAN_X86
+  case isa::avx512:
+    return std::forward<F>(f)(avx512{});
+  case isa::avx2:
+    return std::forward<F>(f)(avx2{});
+  case isa::sse2:
+    return std::forward<F>(f)(sse2{});
+#endif
+  default:
+    return std::forward<F>(f)(scalar{});
+  }
+}
+
+template <class O> inline const unsigned char *bytes(const O *data) noexcept {
+  return reinterpret_cast<const unsigned char *>(data); // NOLINT
+}
+template <class O> inline unsigned char *bytes(O *data) noexcept {
+  return reinterpret_cast<unsigned char *>(data); // NOLINT
+}
+} // namespace detail
+
+// Widest instruction set supported by the running CPU
+[[nodiscard]] inline isa best_isa() noexcept {
+  static const isa detected = detail::detect_isa();
+  return detected;
+}
+
+[[nodiscard]] inline bool supports(isa target) noexcept {
+  return static_cast<int>(target) <= static_cast<int>(best_isa());
+}
+
+// The overloads taking an isa force a specific code path, which must be
+// supported by the running CPU. The others use best_isa().
+
+template <class O>
+[[nodiscard]] std::size_t count_empty(isa target, const O *data,
+                                      std::size_t size) noexcept {
+  using layout = detail::tombstone_layout<O>;
+  return detail::dispatch(target, [&](auto kernels) {
+    return decltype(kernels)::count_empty(detail::bytes(data), size,
+                                          layout::sentinel());
+  });
+}
+
+template <class O>
+[[nodiscard]] std::size_t count_engaged(isa target, const O *data,
+                                        std::size_t size) noexcept {
+  return size - count_empty(target, data, size);
+}
+
+template <class O>
+[[nodiscard]] std::size_t find_first_engaged(isa target, const O *data,
+                                             std::size_t size) noexcept {
+  using layout = detail::tombstone_layout<O>;
+  return detail::dispatch(target, [&](auto kernels) {
+    return decltype(kernels)::template find_first<false>(
+        detail::bytes(data), size, layout::sentinel());
+  });
+}
+
+template <class O>
+[[nodiscard]] std::size_t find_first_empty(isa target, const O *data,
+                                           std::size_t size) noexcept {
+  using layout = detail::tombstone_layout<O>;
+  return detail::dispatch(target, [&](auto kernels) {
+    return decltype(kernels)::template find_first<true>(
+        detail::bytes(data), size, layout::sentinel());
+  });
+}
+
+template <class O>
+[[nodiscard]] std::size_t find_last_engaged(isa target, const O *data,
+                                            std::size_t size) noexcept {
+  using layout = detail::tombstone_layout<O>;
+  return detail::dispatch(target, [&](auto kernels) {
+    return decltype(kernels)::template find_last<false>(
+        detail::bytes(data), size, layout::sentinel());
+  });
+}
+
+template <class O>
+[[nodiscard]] std::size_t find_last_empty(isa target, const O *data,
+                                          std::size_t size) noexcept {
+  using layout = detail::tombstone_layout<O>;
+  return detail::dispatch(target, [&](auto kernels) {
+    return decltype(kernels)::template find_last<true>(
+        detail::bytes(data), size, layout::sentinel());
+  });
+}
+
+template <class O>
+[[nodiscard]] bool all_engaged(isa target, const O *data,
+                               std::size_t size) noexcept {
+  return find_first_empty(target, data, size) == size;
+}
+
+template <class O>
+[[nodiscard]] bool any_engaged(isa target, const O *data,
+                               std::size_t size) noexcept {
+  return find_first_engaged(target, data, size) != size;
+}
+
+template <class O>
+[[nodiscard]] bool none_engaged(isa target, const O *data,
+                                std::size_t size) noexcept {
+  return !any_engaged(target, data, size);
+}
+
+// Writes the value of every element, or default_value for empty ones, to out
+template <class O>
+void value_or(isa target, const O *data, std::size_t size,
+              typename O::value_type *out,
+              typename O::value_type default_value) noexcept {
+  using layout = detail::tombstone_layout<O>;
+  detail::dispatch(target, [&](auto kernels) {
+    decltype(kernels)::fill(detail::bytes(data), detail::bytes(out), size,
+                            layout::sentinel(), layout::raw(default_value));
+  });
+}
+
+// Engages every empty element with replacement
+template <class O>
+void replace_sentinel(isa target, O *data, std::size_t size,
+                      typename O::value_type replacement) noexcept {
+  using layout = detail::tombstone_layout<O>;
+  detail::dispatch(target, [&](auto kernels) {
+    decltype(kernels)::fill(detail::bytes(data), detail::bytes(data), size,
+                            layout::sentinel(), layout::raw(replacement));
+  });
+}
+
+template <class O>
+[[nodiscard]] std::size_t count_empty(const O *data,
+                                      std::size_t size) noexcept {
+  return count_empty(best_isa(), data, size);
+}
+
+template <class O>
+[[nodiscard]] std::size_t count_engaged(const O *data,
+                                        std::size_t size) noexcept {
+  return count_engaged(best_isa(), data, size);
+}
+
+template <class O>
+[[nodiscard]] std::size_t find_first_engaged(const O *data,
+                                             std::size_t size) noexcept {
+  return find_first_engaged(best_isa(), data, size);
+}
+
+template <class O>
+[[nodiscard]] std::size_t find_first_empty(const O *data,
+                                           std::size_t size) noexcept {
+  return find_first_empty(best_isa(), data, size);
+}
+
+template <class O>
+[[nodiscard]] std::size_t find_last_engaged(const O *data,
+                                            std::size_t size) noexcept {
+  return find_last_engaged(best_isa(), data, size);
+}
+
+template <class O>
+[[nodiscard]] std::size_t find_last_empty(const O *data,
+                                          std::size_t size) noexcept {
+  return find_last_empty(best_isa(), data, size);
+}
+
+template <class O>
+[[nodiscard]] bool all_engaged(const O *data, std::size_t size) noexcept {
+  return all_engaged(best_isa(), data, size);
+}
+
+template <class O>
+[[nodiscard]] bool any_engaged(const O *data, std::size_t size) noexcept {
+  return any_engaged(best_isa(), data, size);
+}
+
+template <class O>
+[[nodiscard]] bool none_engaged(const O *data, std::size_t size) noexcept {
+  return none_engaged(best_isa(), data, size);
+}
+
+template <class O>
+void value_or(const O *data, std::size_t size, typename O::value_type *out,
+              typename O::value_type default_value) noexcept {
+  value_or(best_isa(), data, size, out, default_value);
+}
+
+template <class O>
+void replace_sentinel(O *data, std::size_t size,
+                      typename O::value_type replacement) noexcept {
+  replace_sentinel(best_isa(), data, size, replacement);
+}
+
+} // namespace scan
+} // namespace dpsg
+
+#endif // GUARD_TOMBSTONE_SCAN_HEADER
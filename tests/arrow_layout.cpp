@@ -0,0 +1,221 @@
+#include "arrow_layout.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+namespace arrow = dpsg::arrow;
+
+std::vector<dpsg::scan::isa> supported_isas() {
+  std::vector<dpsg::scan::isa> result;
+  for (auto target : {dpsg::scan::isa::scalar, dpsg::scan::isa::sse2,
+                      dpsg::scan::isa::avx2, dpsg::scan::isa::avx512}) {
+    if (dpsg::scan::supports(target)) {
+      result.push_back(target);
+    }
+  }
+  return result;
+}
+
+// Int32Array [1, null, 3, 4, null, null, 7, 8, 9, null] as laid out by Arrow:
+// buffers padded to 64 bytes, null slots holding garbage
+alignas(64) constexpr std::int32_t fixture_values[16] = {
+    1, -7, 3, 4, 123456, 0, 7, 8, 9, 42, 0, 0, 0, 0, 0, 0};
+alignas(64) constexpr std::uint8_t fixture_validity[64] = {0b11001101,
+                                                           0b00000001};
+constexpr std::size_t fixture_length = 10;
+const std::vector<std::optional<std::int32_t>> fixture_expected = {
+    1, std::nullopt, 3, 4, std::nullopt, std::nullopt, 7, 8, 9, std::nullopt};
+
+// Arrow buffers of length + offset elements, element i being null when
+// i % 3 == 1 or i % 7 == 0, with a bitmap aligned for views
+template <class T> struct arrow_array {
+  std::vector<T> values;
+  std::vector<std::uint64_t> words;
+  std::size_t offset;
+  std::size_t length;
+
+  arrow_array(std::size_t size, std::size_t off)
+      : values(size + off), words((size + off + 63) / 64), offset(off),
+        length(size) {
+    for (std::size_t i = 0; i < size + off; ++i) {
+      values[i] = static_cast<T>(i % 100);
+      if (i % 3 != 1 && i % 7 != 0) {
+        validity()[i / 8] |= static_cast<std::uint8_t>(1U << (i % 8));
+      }
+    }
+  }
+
+  std::uint8_t *validity() {
+    return reinterpret_cast<std::uint8_t *>(words.data()); // NOLINT
+  }
+
+  [[nodiscard]] bool valid(std::size_t i) const {
+    const std::size_t bit = offset + i;
+    const auto *bytes =
+        reinterpret_cast<const std::uint8_t *>(words.data()); // NOLINT
+    return ((bytes[bit / 8] >> (bit % 8)) & 1U) != 0;
+  }
+};
+
+template <class O> void check_round_trip(std::size_t size, std::size_t offset) {
+  using T = typename O::value_type;
+  arrow_array<T> input(size, offset);
+  for (auto target : supported_isas()) {
+    std::vector<O> column(size);
+    arrow::from_arrow(target, input.values.data(), input.validity(), size,
+                      column.data(), offset);
+    for (std::size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(column[i].has_value(), input.valid(i)) << i;
+      if (input.valid(i)) {
+        ASSERT_EQ(*column[i], input.values[offset + i]);
+      }
+    }
+
+    std::vector<std::uint8_t> validity(arrow::validity_size(size), 0xFF);
+    std::vector<T> values(size);
+    const std::size_t nulls = arrow::to_arrow(
+        target, column.data(), size, values.data(), validity.data());
+    std::size_t expected_nulls = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      const bool valid = ((validity[i / 8] >> (i % 8)) & 1U) != 0;
+      ASSERT_EQ(valid, input.valid(i)) << i;
+      ASSERT_EQ(values[i], valid ? input.values[offset + i] : T{}) << i;
+      expected_nulls += static_cast<std::size_t>(!valid);
+    }
+    ASSERT_EQ(nulls, expected_nulls);
+    if (size % 8 != 0) {
+      ASSERT_EQ(validity.back() >> (size % 8), 0) << "padding bits are set";
+    }
+  }
+}
+
+template <class O> void check_round_trips() {
+  for (std::size_t size : {0, 1, 7, 8, 63, 64, 65, 200, 1000}) {
+    for (std::size_t offset : {0, 3, 8, 61, 64}) {
+      check_round_trip<O>(size, offset);
+    }
+  }
+}
+} // namespace
+
+TEST(ArrowLayout, Fixture) {
+  std::vector<dpsg::optional_tombstone<std::int32_t>> tombstones(
+      fixture_length);
+  arrow::from_arrow(fixture_values, fixture_validity, fixture_length,
+                    tombstones.data());
+  std::vector<dpsg::optional<std::int32_t>> flags(fixture_length);
+  arrow::from_arrow(fixture_values, fixture_validity, fixture_length,
+                    flags.data());
+  const auto span =
+      arrow::view(fixture_values, fixture_validity, fixture_length);
+  for (std::size_t i = 0; i < fixture_length; ++i) {
+    const auto &expected = fixture_expected[i];
+    ASSERT_EQ(tombstones[i].has_value(), expected.has_value());
+    ASSERT_EQ(flags[i].has_value(), expected.has_value());
+    ASSERT_EQ(span[i].has_value(), expected.has_value());
+    if (expected.has_value()) {
+      ASSERT_EQ(*tombstones[i], *expected);
+      ASSERT_EQ(*flags[i], *expected);
+      ASSERT_EQ(*span[i], *expected);
+    }
+  }
+
+  std::uint8_t validity[2] = {};
+  ASSERT_EQ(arrow::to_validity(tombstones.data(), fixture_length, validity),
+            4U);
+  ASSERT_EQ(validity[0], fixture_validity[0]);
+  ASSERT_EQ(validity[1], fixture_validity[1]);
+  ASSERT_EQ(arrow::values(tombstones.data())[6], 7);
+}
+
+TEST(ArrowLayout, Slices) {
+  // Elements 3 to 8 of the fixture: [4, null, null, 7, 8, 9]
+  std::vector<dpsg::optional_tombstone<std::int32_t>> slice(6);
+  arrow::from_arrow(fixture_values, fixture_validity, 6, slice.data(), 3);
+  const std::vector<dpsg::optional_tombstone<std::int32_t>> expected = {
+      4, {}, {}, 7, 8, 9};
+  ASSERT_EQ(slice, expected);
+  ASSERT_FALSE(arrow::viewable(fixture_values, fixture_validity, 3));
+  ASSERT_THROW((void)arrow::view(fixture_values, fixture_validity, 6, 3),
+               std::invalid_argument);
+}
+
+TEST(ArrowLayout, NoValidityBitmap) {
+  std::vector<dpsg::optional_tombstone<std::int32_t>> tombstones(
+      fixture_length);
+  arrow::from_arrow(fixture_values, nullptr, fixture_length,
+                    tombstones.data());
+  std::vector<dpsg::optional<std::int32_t>> flags(fixture_length);
+  arrow::from_arrow(fixture_values, nullptr, fixture_length, flags.data());
+  for (std::size_t i = 0; i < fixture_length; ++i) {
+    ASSERT_EQ(tombstones[i], fixture_values[i]);
+    ASSERT_EQ(flags[i], fixture_values[i]);
+  }
+  ASSERT_FALSE(arrow::viewable(fixture_values, nullptr));
+
+  // Empty arrays may come without any buffer
+  arrow::from_arrow<dpsg::optional_tombstone<std::int32_t>>(nullptr, nullptr,
+                                                            0, nullptr);
+}
+
+TEST(ArrowLayout, RoundTrips) {
+  check_round_trips<dpsg::optional_tombstone<std::int8_t>>();
+  check_round_trips<dpsg::optional_tombstone<std::uint16_t>>();
+  check_round_trips<dpsg::optional_tombstone<std::int32_t>>();
+  check_round_trips<dpsg::optional_tombstone<std::int64_t>>();
+  check_round_trips<dpsg::optional_tombstone<float>>();
+  check_round_trips<dpsg::optional_tombstone<double>>();
+  check_round_trips<dpsg::optional<std::int32_t>>();
+  check_round_trips<dpsg::optional<double>>();
+}
+
+TEST(ArrowLayout, Views) {
+  arrow_array<std::int64_t> input(300, 64);
+  ASSERT_TRUE(arrow::viewable(input.values.data(), input.validity(), 64));
+  const auto span =
+      arrow::view(input.values.data(), input.validity(), 300, 64);
+  ASSERT_EQ(span.size(), 300U);
+  ASSERT_EQ(span.data(), input.values.data() + 64);
+  for (std::size_t i = 0; i < span.size(); ++i) {
+    ASSERT_EQ(span.has_value(i), input.valid(i));
+    if (input.valid(i)) {
+      ASSERT_EQ(*span[i], input.values[64 + i]);
+    }
+  }
+}
+
+TEST(ArrowLayout, OptionalVector) {
+  dpsg::optional_vector<std::int32_t> vec;
+  for (std::size_t i = 0; i < fixture_length; ++i) {
+    if (fixture_expected[i].has_value()) {
+      vec.push_back(*fixture_expected[i]);
+    } else {
+      vec.push_back(dpsg::nullopt);
+    }
+  }
+  const std::uint8_t *validity = arrow::validity(vec);
+  ASSERT_EQ(validity[0], fixture_validity[0]);
+  ASSERT_EQ(validity[1], fixture_validity[1]);
+
+  // And back, without copying
+  const auto span = arrow::view(vec.data(), validity, vec.size());
+  ASSERT_EQ(span.bitmap(), vec.bitmap());
+  for (std::size_t i = 0; i < vec.size(); ++i) {
+    ASSERT_EQ(span[i].has_value(), vec[i].has_value());
+  }
+}
+
+TEST(ArrowLayout, SentinelValues) {
+  const std::int32_t values[2] = {std::numeric_limits<std::int32_t>::min(), 1};
+  const std::uint8_t validity[1] = {0b11};
+  dpsg::optional_tombstone<std::int32_t> out[2];
+  arrow::from_arrow(values, validity, 2, out);
+  ASSERT_FALSE(out[0].has_value());
+  ASSERT_EQ(out[1], 1);
+}
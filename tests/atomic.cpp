@@ -0,0 +1,153 @@
+#include "atomic_optional.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using slot = dpsg::atomic_optional_tombstone<std::uint64_t>;
+using string_slot = dpsg::atomic_optional<std::string>;
+
+constexpr static inline std::uint64_t fourty_two = 42;
+constexpr static inline int thread_count = 8;
+
+static_assert(sizeof(slot) == sizeof(std::uint64_t));
+static_assert(!std::is_copy_constructible_v<slot>);
+static_assert(!std::is_move_assignable_v<slot>);
+static_assert(!std::is_copy_constructible_v<string_slot>);
+
+TEST(AtomicTombstone, SingleThread) {
+  slot s;
+  ASSERT_FALSE(s.has_value());
+  ASSERT_FALSE(s.load().has_value());
+  ASSERT_TRUE(s.try_emplace(fourty_two));
+  ASSERT_FALSE(s.try_emplace(fourty_two + 1));
+  ASSERT_TRUE(s.has_value());
+  ASSERT_EQ(*s.load(), fourty_two);
+  ASSERT_EQ(s.value_or(0U), fourty_two);
+  ASSERT_EQ(s.wait_for_value(), fourty_two);
+
+  auto previous = s.exchange(fourty_two + 1);
+  ASSERT_EQ(*previous, fourty_two);
+  previous = s.exchange(dpsg::nullopt);
+  ASSERT_EQ(*previous, fourty_two + 1);
+  ASSERT_FALSE(s.has_value());
+
+  slot::snapshot expected{fourty_two};
+  ASSERT_FALSE(s.compare_exchange(expected, fourty_two + 2));
+  ASSERT_FALSE(expected.has_value());
+  ASSERT_TRUE(s.compare_exchange(expected, fourty_two + 2));
+  ASSERT_EQ(*s.load(), fourty_two + 2);
+
+  s.reset();
+  ASSERT_FALSE(s.has_value());
+  slot filled{fourty_two};
+  ASSERT_TRUE(filled.has_value());
+  filled = dpsg::nullopt;
+  ASSERT_FALSE(filled.has_value());
+}
+
+TEST(AtomicTombstone, SingleWinner) {
+  slot s;
+  std::atomic<int> winners{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&s, &winners, i] {
+      if (s.try_emplace(static_cast<std::uint64_t>(i))) {
+        ++winners;
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(winners, 1);
+  ASSERT_TRUE(s.has_value());
+}
+
+TEST(AtomicTombstone, WaitForValue) {
+  slot s;
+  std::uint64_t received = 0;
+  std::thread consumer{[&s, &received] { received = s.wait_for_value(); }};
+  std::thread producer{[&s] { s.try_emplace(fourty_two); }};
+  producer.join();
+  consumer.join();
+  ASSERT_EQ(received, fourty_two);
+
+  std::thread waiter{[&s] { s.wait(fourty_two); }};
+  s.exchange(dpsg::nullopt);
+  waiter.join();
+  ASSERT_FALSE(s.has_value());
+}
+
+// Comparisons and std::hash read a snapshot, never the payload in place
+TEST(AtomicTombstone, CompareWhileStoring) {
+  slot s;
+  std::atomic<bool> started{false};
+  std::atomic<bool> done{false};
+  std::thread writer{[&s, &started, &done] {
+    while (!started) {
+    }
+    for (std::uint64_t i = 0; i < 100000; ++i) {
+      s.store(i % 2 == 0 ? slot::snapshot{i} : slot::snapshot{});
+    }
+    done = true;
+  }};
+  const slot::snapshot empty;
+  std::set<std::size_t> hashes;
+  started = true;
+  while (!done) {
+    // Each comparison reads the slot once, the slot may change in between
+    ASSERT_TRUE(s >= empty);
+    ASSERT_FALSE(s < empty);
+    ASSERT_TRUE(s != fourty_two + 1); // Only even values are stored
+    hashes.insert(std::hash<slot>{}(s));
+  }
+  writer.join();
+  ASSERT_TRUE(s == empty);
+  ASSERT_TRUE(s == s.load());
+  ASSERT_EQ(std::hash<slot>{}(s), std::hash<slot::snapshot>{}(empty));
+  ASSERT_FALSE(hashes.empty());
+}
+
+TEST(AtomicFlag, SingleThread) {
+  string_slot s;
+  ASSERT_FALSE(s.has_value());
+  ASSERT_TRUE(s.try_emplace("Hello World!"));
+  ASSERT_FALSE(s.try_emplace("Goodbye"));
+  ASSERT_EQ(*s, "Hello World!");
+  ASSERT_EQ(s.wait_for_value(), "Hello World!");
+  s.reset();
+  ASSERT_FALSE(s.has_value());
+  s = std::string{"Again"};
+  ASSERT_EQ(s.value(), "Again");
+  s.emplace("Emplaced");
+  ASSERT_EQ(*s, "Emplaced");
+}
+
+TEST(AtomicFlag, WaitForValue) {
+  string_slot s;
+  std::atomic<int> winners{0};
+  std::vector<std::thread> threads;
+  std::vector<std::string> received(thread_count);
+  for (int i = 0; i < thread_count; ++i) {
+    threads.emplace_back([&s, &received, i] {
+      received[static_cast<std::size_t>(i)] = s.wait_for_value();
+    });
+    threads.emplace_back([&s, &winners, i] {
+      if (s.try_emplace(std::to_string(i))) {
+        ++winners;
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(winners, 1);
+  for (const auto &r : received) {
+    ASSERT_EQ(r, *s);
+  }
+}
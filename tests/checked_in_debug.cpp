@@ -0,0 +1,114 @@
+#include "generalized_optional.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace {
+template <class T, class Control = dpsg::control::dependent_bool>
+using checked = dpsg::generalized_optional<
+    T, dpsg::policy<dpsg::access::extended_checked_in_debug, Control,
+                    dpsg::storage::aligned>>;
+
+template <class T, class Control = dpsg::control::dependent_bool>
+using unchecked = dpsg::generalized_optional<
+    T, dpsg::policy<dpsg::access::extended_unchecked, Control,
+                    dpsg::storage::aligned>>;
+
+using checked_tombstone =
+    checked<std::int32_t, dpsg::control::tombstone<std::int32_t, -1>>;
+
+struct point {
+  int x;
+  int y;
+};
+
+// Large enough for ASan to poison it whole
+struct wide {
+  std::int64_t values[4];
+};
+} // namespace
+
+#if defined(NDEBUG)
+// The very same policy, hence the same code
+static_assert(std::is_same_v<dpsg::access::checked_in_debug,
+                             dpsg::access::unchecked>);
+static_assert(std::is_same_v<checked<int>, unchecked<int>>);
+#endif
+#if !defined(DPSG_OPTIONAL_POISONING)
+static_assert(sizeof(checked<int>) == sizeof(unchecked<int>));
+static_assert(std::is_trivially_copyable_v<checked<int>>);
+static_assert(
+    dpsg::is_trivially_relocatable_v<checked<std::unique_ptr<int>>>);
+#endif
+
+TEST(CheckedInDebug, Engaged) {
+  checked<point> p{point{1, 2}};
+  ASSERT_EQ(p.value().x, 1);
+  ASSERT_EQ((*p).y, 2);
+  ASSERT_EQ(p->x + p->y, 3);
+  ASSERT_EQ(std::move(p).value().y, 2);
+  ASSERT_EQ(p.with_value([](const point &v) { return v.x; }, 0), 1);
+
+  checked<std::string> text{"text"};
+  checked<std::string> copy = text;
+  checked<std::string> empty;
+  ASSERT_EQ(*copy, "text");
+  copy = empty;
+  ASSERT_FALSE(copy.has_value());
+  swap(text, copy);
+  ASSERT_EQ(*copy, "text");
+  ASSERT_EQ(text.value_or("fallback"), "fallback");
+}
+
+// Tombstones read their storage to know whether they are engaged, it is
+// never poisoned
+TEST(CheckedInDebug, Tombstone) {
+  checked_tombstone value{4};
+  ASSERT_EQ(*value, 4);
+  value.reset();
+  ASSERT_FALSE(value.has_value());
+  ASSERT_EQ(value.value_or(3), 3);
+}
+
+#if !defined(NDEBUG)
+TEST(CheckedInDebugDeathTest, EmptyAccess) {
+  checked<point> empty;
+  EXPECT_DEATH((void)empty.value(), "has_value");
+  EXPECT_DEATH((void)*empty, "has_value");
+  EXPECT_DEATH((void)empty->x, "has_value");
+  EXPECT_DEATH((void)*std::as_const(empty), "has_value");
+}
+#endif
+
+#if defined(DPSG_OPTIONAL_POISONING)
+TEST(CheckedInDebugDeathTest, Poisoning) {
+  checked<wide> value{wide{{1, 2, 3, 4}}};
+  const wide &kept = *value;
+  value.reset();
+  ASSERT_TRUE(__asan_address_is_poisoned(&kept));
+  EXPECT_DEATH(
+      {
+        const volatile std::int64_t first = kept.values[0];
+        (void)first;
+      },
+      "use-after-poison");
+  value.emplace(wide{{5, 6, 7, 8}});
+  ASSERT_FALSE(__asan_address_is_poisoned(&kept));
+  ASSERT_EQ(kept.values[3], 8);
+
+  checked<std::string> text{"b"};
+  checked<std::string> empty;
+  checked<std::string> copy = empty;
+  ASSERT_TRUE(__asan_address_is_poisoned(&copy));
+  copy = text;
+  ASSERT_EQ(*copy, "b");
+  swap(copy, empty);
+  ASSERT_EQ(*empty, "b");
+  ASSERT_TRUE(__asan_address_is_poisoned(&copy));
+}
+#endif
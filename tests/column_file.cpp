@@ -0,0 +1,231 @@
+#include "column_file.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+namespace cf = dpsg::column_file;
+
+using tint = dpsg::optional_tombstone<std::int32_t>;
+using tdouble = dpsg::optional_tombstone<double>;
+using fint = dpsg::optional<std::int32_t>;
+using fbool = dpsg::optional<bool>;
+
+static_assert(dpsg::optional_span_of<tint>::tombstone_layout);
+static_assert(dpsg::optional_span_of<tdouble>::tombstone_layout);
+static_assert(!dpsg::optional_span_of<fint>::tombstone_layout);
+
+// File contents, in a buffer aligned like a mapping would be
+struct buffer {
+  std::vector<std::uint64_t> words;
+  std::size_t size = 0;
+
+  explicit buffer(const std::string &bytes)
+      : words((bytes.size() + 7) / 8), size(bytes.size()) {
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+  }
+
+  [[nodiscard]] const void *data() const { return words.data(); }
+  [[nodiscard]] cf::header &header() {
+    return *reinterpret_cast<cf::header *>(words.data()); // NOLINT
+  }
+};
+
+template <class O> std::vector<O> column(std::size_t size) {
+  std::vector<O> result(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    if (i % 3 != 1) {
+      result[i] = static_cast<typename O::value_type>(i % 7);
+    }
+  }
+  return result;
+}
+
+template <class O> std::string serialize(const std::vector<O> &values) {
+  std::ostringstream out;
+  cf::write(out, values.data(), values.size());
+  return out.str();
+}
+
+template <class O, class Span>
+void expect_same(const std::vector<O> &expected, const Span &span) {
+  ASSERT_EQ(span.size(), expected.size());
+  std::size_t i = 0;
+  for (auto &&element : span) {
+    ASSERT_EQ(span.has_value(i), expected[i].has_value());
+    ASSERT_EQ(element.has_value(), expected[i].has_value());
+    if (expected[i].has_value()) {
+      ASSERT_EQ(*element, *expected[i]);
+    }
+    ++i;
+  }
+}
+
+template <class O> void round_trip(std::size_t size) {
+  const auto expected = column<O>(size);
+  const buffer file{serialize(expected)};
+  const auto span = cf::view<typename O::value_type,
+                             typename cf::detail::column_policy<O>::type>(
+      file.data(), file.size);
+  expect_same(expected, span);
+}
+
+template <class O> cf::header header_of(std::size_t size) {
+  buffer file{serialize(column<O>(size))};
+  return file.header();
+}
+
+template <class Span> void expect_rejected(buffer &file) {
+  using T = typename Span::value_type;
+  using P = typename Span::optional_type;
+  ASSERT_THROW((cf::view<T, typename cf::detail::column_policy<P>::type>(
+                   file.data(), file.size)),
+               cf::format_error);
+}
+} // namespace
+
+TEST(ColumnFile, Header) {
+  const auto tombstone = header_of<tint>(10);
+  ASSERT_EQ(tombstone.layout, cf::encoding::tombstone);
+  ASSERT_EQ(tombstone.type, cf::element_type::i32);
+  ASSERT_EQ(tombstone.element_size, 4);
+  ASSERT_EQ(tombstone.count, 10U);
+  ASSERT_EQ(tombstone.sentinel,
+            static_cast<std::uint32_t>(tint::tombstone_value));
+  ASSERT_EQ(tombstone.values_offset, 64U);
+  ASSERT_EQ(tombstone.bitmap_offset, 0U);
+
+  const auto bitmap = header_of<fint>(10);
+  ASSERT_EQ(bitmap.layout, cf::encoding::bitmap);
+  ASSERT_EQ(bitmap.sentinel, 0U);
+  ASSERT_EQ(bitmap.bitmap_offset, 64U + 40U);
+  ASSERT_EQ(header_of<fint>(9).bitmap_offset, 64U + 40U);
+  ASSERT_EQ(header_of<fint>(11).bitmap_offset, 64U + 48U);
+  ASSERT_EQ(header_of<fbool>(3).type, cf::element_type::boolean);
+  ASSERT_EQ(header_of<tdouble>(3).type, cf::element_type::f64);
+}
+
+TEST(ColumnFile, TombstoneRoundTrip) {
+  for (std::size_t size : {0, 1, 63, 64, 65, 1000}) {
+    round_trip<tint>(size);
+    round_trip<tdouble>(size);
+  }
+}
+
+TEST(ColumnFile, BitmapRoundTrip) {
+  for (std::size_t size : {0, 1, 63, 64, 65, 1000}) {
+    round_trip<fint>(size);
+    round_trip<fbool>(size);
+  }
+}
+
+TEST(ColumnFile, ViewsInPlace) {
+  const auto expected = column<tint>(100);
+  const buffer file{serialize(expected)};
+  const auto span = cf::view<std::int32_t,
+                             cf::detail::column_policy<tint>::type>(
+      file.data(), file.size);
+  ASSERT_EQ(static_cast<const void *>(span.data()),
+            static_cast<const unsigned char *>(file.data()) + 64);
+}
+
+TEST(ColumnFile, OptionalVector) {
+  dpsg::optional_vector<std::int32_t> vec;
+  for (int i = 0; i < 130; ++i) {
+    if (i % 4 == 0) {
+      vec.push_back(dpsg::nullopt);
+    } else {
+      vec.push_back(i);
+    }
+  }
+  std::ostringstream out;
+  cf::write(out, vec);
+  const buffer file{out.str()};
+  const auto span =
+      cf::view<std::int32_t, cf::detail::column_policy<fint>::type>(
+          file.data(), file.size);
+  ASSERT_EQ(span.size(), vec.size());
+  for (std::size_t i = 0; i < vec.size(); ++i) {
+    ASSERT_EQ(span[i].has_value(), vec[i].has_value());
+    if (vec[i].has_value()) {
+      ASSERT_EQ(*span[i], *vec[i]);
+    }
+  }
+}
+
+TEST(ColumnFile, Rejections) {
+  using tspan = dpsg::optional_span_of<tint>;
+  const std::string bytes = serialize(column<tint>(20));
+
+  buffer magic{bytes};
+  magic.header().magic[0] = 'X';
+  expect_rejected<tspan>(magic);
+
+  buffer version{bytes};
+  version.header().version = 2;
+  expect_rejected<tspan>(version);
+
+  buffer order{bytes};
+  order.header().order = cf::detail::native_order() == cf::byte_order::little
+                             ? cf::byte_order::big
+                             : cf::byte_order::little;
+  expect_rejected<tspan>(order);
+
+  buffer truncated{bytes.substr(0, bytes.size() - 1)};
+  expect_rejected<tspan>(truncated);
+
+  buffer header_only{bytes.substr(0, 32)};
+  expect_rejected<tspan>(header_only);
+
+  buffer huge{bytes};
+  huge.header().count = std::numeric_limits<std::uint64_t>::max() / 2;
+  expect_rejected<tspan>(huge);
+
+  buffer other_type{bytes};
+  expect_rejected<dpsg::optional_span_of<dpsg::optional_tombstone<float>>>(
+      other_type);
+  expect_rejected<dpsg::optional_span_of<dpsg::optional_tombstone<
+      std::uint32_t>>>(other_type);
+  expect_rejected<dpsg::optional_span_of<dpsg::optional_tombstone<
+      std::int32_t, 0>>>(other_type);
+  expect_rejected<dpsg::optional_span_of<fint>>(other_type);
+
+  buffer bitmap{serialize(column<fint>(100))};
+  buffer bitmap_truncated{
+      serialize(column<fint>(100)).substr(0, 64 + 400 + 8)};
+  expect_rejected<tspan>(bitmap);
+  expect_rejected<dpsg::optional_span_of<fint>>(bitmap_truncated);
+}
+
+#if DPSG_COLUMN_FILE_MMAP
+TEST(ColumnFile, Mapping) {
+  const auto expected = column<tdouble>(5000);
+  const std::string path = testing::TempDir() + "dpsg_column_file_test.bin";
+  {
+    std::ofstream out(path, std::ios::binary);
+    cf::write(out, expected.data(), expected.size());
+  }
+  {
+    cf::mapping_of<tdouble> mapped{path};
+    expect_same(expected, mapped.span());
+
+    cf::mapping_of<tdouble> moved{std::move(mapped)};
+    ASSERT_TRUE(mapped.span().empty());
+    expect_same(expected, moved.span());
+
+    ASSERT_THROW(cf::mapping_of<tint>{path}, cf::format_error);
+  }
+  std::remove(path.c_str());
+  ASSERT_THROW(cf::mapping_of<tdouble>{path}, std::system_error);
+}
+#endif
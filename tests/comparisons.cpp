@@ -0,0 +1,161 @@
+#include "generalized_optional.hpp"
+#include "small_buffer_storage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+template <class O> using traits = dpsg::detail::compare_traits<O>;
+
+using tint = dpsg::optional_tombstone<int>;
+using tunsigned = dpsg::optional_tombstone<unsigned>;
+using tzero = dpsg::optional_tombstone<int, 0>;
+using tdouble = dpsg::optional_tombstone<double>;
+using fint = dpsg::optional<int>;
+using sstring = dpsg::optional_small<std::string>;
+
+struct not_hashable {};
+
+template <class O> O make(const std::optional<int> &value) {
+  if (value.has_value()) {
+    return O{static_cast<typename O::value_type>(*value)};
+  }
+  return O{};
+}
+
+// Every operator against std::optional, on every pair of values
+template <class L, class R>
+void same_as_std(std::vector<std::optional<int>> values) {
+  values.emplace_back(std::nullopt);
+  for (const auto &a : values) {
+    for (const auto &b : values) {
+      const L lhv = make<L>(a);
+      const R rhv = make<R>(b);
+      EXPECT_EQ(lhv == rhv, a == b);
+      EXPECT_EQ(lhv != rhv, a != b);
+      EXPECT_EQ(lhv < rhv, a < b);
+      EXPECT_EQ(lhv <= rhv, a <= b);
+      EXPECT_EQ(lhv > rhv, a > b);
+      EXPECT_EQ(lhv >= rhv, a >= b);
+      if (b.has_value()) {
+        const auto value = static_cast<typename R::value_type>(*b);
+        EXPECT_EQ(lhv == value, a == *b);
+        EXPECT_EQ(value != lhv, *b != a);
+        EXPECT_EQ(lhv < value, a < *b);
+        EXPECT_EQ(value < lhv, *b < a);
+        EXPECT_EQ(lhv <= value, a <= *b);
+        EXPECT_EQ(value >= lhv, *b >= a);
+        EXPECT_EQ(lhv > value, a > *b);
+        EXPECT_EQ(value > lhv, *b > a);
+      }
+      EXPECT_EQ(lhv == dpsg::nullopt, a == std::nullopt);
+      EXPECT_EQ(dpsg::nullopt != lhv, std::nullopt != a);
+      EXPECT_EQ(lhv < dpsg::nullopt, a < std::nullopt);
+      EXPECT_EQ(dpsg::nullopt < lhv, std::nullopt < a);
+      EXPECT_EQ(lhv <= dpsg::nullopt, a <= std::nullopt);
+      EXPECT_EQ(dpsg::nullopt >= lhv, std::nullopt >= a);
+      EXPECT_EQ(lhv > dpsg::nullopt, a > std::nullopt);
+      EXPECT_EQ(dpsg::nullopt > lhv, std::nullopt > a);
+    }
+  }
+}
+} // namespace
+
+static_assert(traits<tint>::ordered);
+static_assert(traits<tunsigned>::ordered);
+static_assert(!traits<tzero>::ordered && traits<tzero>::readable);
+static_assert(!traits<tdouble>::ordered && traits<tdouble>::readable);
+static_assert(!traits<fint>::readable);
+static_assert(dpsg::detail::raw_comparable<std::less<>, tint, tint>());
+static_assert(dpsg::detail::raw_comparable<std::equal_to<>, tzero, tzero>());
+static_assert(!dpsg::detail::raw_comparable<std::less<>, tzero, tzero>());
+static_assert(!dpsg::detail::raw_comparable<std::less<>, tint, tzero>());
+
+static_assert(std::is_default_constructible_v<std::hash<tint>>);
+static_assert(std::is_default_constructible_v<std::hash<sstring>>);
+static_assert(
+    !std::is_default_constructible_v<std::hash<dpsg::optional<not_hashable>>>);
+
+TEST(Comparisons, OrderedTombstones) {
+  same_as_std<tint, tint>({std::numeric_limits<int>::max(), -3, 0, 7,
+                           std::numeric_limits<int>::min() + 1});
+  same_as_std<tunsigned, tunsigned>(
+      {0, 1, 42, static_cast<int>(std::numeric_limits<int>::max())});
+}
+
+TEST(Comparisons, ReadableTombstones) {
+  same_as_std<tzero, tzero>({-5, 1, 9});
+  same_as_std<tdouble, tdouble>({-5, 0, 1, 9});
+  same_as_std<tint, tzero>({-5, 1, 9});
+}
+
+TEST(Comparisons, Generic) {
+  same_as_std<fint, fint>({-5, 0, 1, 9});
+  same_as_std<fint, tint>({-5, 0, 1, 9});
+  same_as_std<tdouble, fint>({-5, 0, 1, 9});
+}
+
+TEST(Comparisons, NonTrivialPayloads) {
+  const sstring a{std::string(40, 'a')};
+  const sstring b{std::string(40, 'b')};
+  const sstring empty{};
+  ASSERT_LT(a, b);
+  ASSERT_LT(empty, a);
+  ASSERT_EQ(a, std::string(40, 'a'));
+  ASSERT_NE(empty, std::string());
+  ASSERT_EQ(empty, dpsg::nullopt);
+  ASSERT_EQ(a, sstring{a});
+}
+
+TEST(Comparisons, FloatingPointValues) {
+  const tdouble zero{0.0};
+  const tdouble negative_zero{-0.0};
+  const tdouble nan{std::numeric_limits<double>::quiet_NaN()};
+  ASSERT_EQ(zero, negative_zero);
+  ASSERT_NE(nan, nan);
+  ASSERT_FALSE(nan < zero || nan > zero);
+  ASSERT_EQ(tdouble{}, tdouble{});
+  ASSERT_LT(tdouble{}, nan);
+}
+
+TEST(Comparisons, SortAndDedup) {
+  std::vector<tint> values{5, {}, 3, 5, {}, -1, 3};
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  const std::vector<tint> expected{{}, -1, 3, 5};
+  ASSERT_EQ(values, expected);
+}
+
+TEST(Comparisons, Hash) {
+  ASSERT_EQ(std::hash<tint>{}(tint{42}), std::hash<int>{}(42));
+  ASSERT_EQ(std::hash<fint>{}(fint{42}), std::hash<int>{}(42));
+  ASSERT_EQ(std::hash<tint>{}(tint{}), std::hash<tint>{}(tint{}));
+  ASSERT_EQ(std::hash<fint>{}(fint{}), std::hash<fint>{}(fint{}));
+  ASSERT_EQ(std::hash<tdouble>{}(tdouble{0.0}),
+            std::hash<tdouble>{}(tdouble{-0.0}));
+  ASSERT_EQ(std::hash<sstring>{}(sstring{"key"}),
+            std::hash<std::string>{}("key"));
+}
+
+#if defined(__cpp_lib_three_way_comparison)
+TEST(Comparisons, ThreeWay) {
+  static_assert(
+      std::is_same_v<decltype(tint{} <=> tint{}), std::strong_ordering>);
+  static_assert(
+      std::is_same_v<decltype(tdouble{} <=> tdouble{}), std::partial_ordering>);
+  ASSERT_TRUE((tint{} <=> tint{3}) < 0);
+  ASSERT_TRUE((tint{3} <=> tint{3}) == 0);
+  ASSERT_TRUE((fint{3} <=> tint{2}) > 0);
+  ASSERT_TRUE((fint{} <=> dpsg::nullopt) == 0);
+  ASSERT_TRUE((fint{1} <=> 2) < 0);
+  ASSERT_TRUE((2 <=> fint{1}) > 0);
+}
+#endif
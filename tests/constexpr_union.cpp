@@ -0,0 +1,132 @@
+#include "generalized_optional.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace {
+constexpr std::size_t table_size = 4096;
+
+// Square roots of the perfect squares, computed by the compiler
+constexpr auto make_roots() {
+  std::array<dpsg::optional_tombstone<std::uint16_t>, table_size> roots{};
+  for (std::size_t i = 0; i * i < table_size; ++i) {
+    roots[i * i] = static_cast<std::uint16_t>(i);
+  }
+  return roots;
+}
+constexpr auto roots = make_roots();
+
+struct point {
+  int x = 0;
+  int y = 0;
+  constexpr point() = default;
+  constexpr point(int px, int py) : x(px), y(py) {}
+};
+
+struct aggregate {
+  int a;
+  int b;
+};
+
+constexpr int sum_of_engaged() {
+  std::array<dpsg::optional<int>, 8> values{};
+  values[1] = 10;
+  values[3].emplace(20);
+  values[5] = values[3];
+  values[3].reset();
+  values[7] = dpsg::optional<int>{dpsg::in_place, 5};
+  values[7].emplace(6); // Assigns the engaged value
+  int sum = 0;
+  for (const auto &v : values) {
+    sum += v.value_or(0);
+  }
+  return sum;
+}
+
+constexpr int emplace_aggregate() {
+  dpsg::optional<aggregate> value;
+  value.emplace(1, 2);
+  value.emplace_with([] { return aggregate{3, 4}; });
+  return value->a * 10 + (*value).b;
+}
+} // namespace
+
+static_assert(roots[0] == 0U);
+static_assert(roots[49] == 7U);
+static_assert(!roots[50].has_value());
+static_assert(roots[4095].value_or(0) == 0);
+static_assert(roots[3969].value() == 63);
+
+static_assert(sum_of_engaged() == 36);
+static_assert(emplace_aggregate() == 34);
+
+// Literal types with a non-trivial constructor are built in place
+constexpr dpsg::optional<point> origin{dpsg::in_place};
+constexpr dpsg::optional<point> corner{dpsg::in_place, 3, 4};
+static_assert(origin.has_value() && origin->x == 0);
+static_assert(corner->x + corner.value().y == 7);
+static_assert(!dpsg::optional<point>{}.has_value());
+
+// Same layout and traits as storage::aligned
+template <class T>
+using aligned = dpsg::generalized_optional<
+    T, dpsg::policy<dpsg::access::extended, dpsg::control::dependent_bool,
+                    dpsg::storage::aligned>>;
+static_assert(sizeof(dpsg::optional_tombstone<std::uint16_t>) == 2);
+static_assert(sizeof(dpsg::optional<double>) == sizeof(aligned<double>));
+static_assert(sizeof(dpsg::optional<std::string>) ==
+              sizeof(aligned<std::string>));
+static_assert(std::is_trivially_copyable_v<dpsg::optional<point>>);
+static_assert(std::is_trivially_copyable_v<
+              dpsg::optional_tombstone<std::uint16_t>>);
+static_assert(!std::is_trivially_copyable_v<dpsg::optional<std::string>>);
+static_assert(std::is_copy_constructible_v<dpsg::optional<std::string>>);
+static_assert(
+    dpsg::is_trivially_relocatable_v<dpsg::optional<std::unique_ptr<int>>>);
+
+TEST(ConstexprUnion, Table) {
+  for (std::size_t i = 0; i < table_size; ++i) {
+    const auto root = static_cast<std::size_t>(std::sqrt(i));
+    ASSERT_EQ(roots[i].has_value(), root * root == i) << i;
+  }
+}
+
+TEST(ConstexprUnion, NonTrivialPayload) {
+  dpsg::optional<std::string> text{std::string(40, 'a')};
+  dpsg::optional<std::string> copy = text;
+  dpsg::optional<std::string> moved = std::move(copy);
+  ASSERT_EQ(*moved, std::string(40, 'a'));
+  text.emplace("b");
+  moved = text;
+  ASSERT_EQ(*moved, "b");
+  text.reset();
+  swap(text, moved);
+  ASSERT_EQ(*text, "b");
+  ASSERT_FALSE(moved.has_value());
+  moved = std::move(text);
+  ASSERT_EQ(*moved, "b");
+}
+
+TEST(ConstexprUnion, NonMovablePayload) {
+  struct pinned {
+    explicit pinned(int v) : value(v) {}
+    pinned(const pinned &) = delete;
+    pinned(pinned &&) = delete;
+    pinned &operator=(const pinned &) = delete;
+    pinned &operator=(pinned &&) = delete;
+    ~pinned() = default;
+    int value;
+  };
+  dpsg::optional<pinned> value{dpsg::from_invoke, [] { return pinned{1}; }};
+  ASSERT_EQ(value->value, 1);
+  value.emplace(2);
+  ASSERT_EQ(value->value, 2);
+}
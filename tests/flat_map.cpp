@@ -0,0 +1,238 @@
+#include "flat_map.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+namespace {
+// Every key in the same group, to exercise probing and erased slots
+struct collide {
+  std::size_t operator()([[maybe_unused]] int key) const noexcept { return 0; }
+};
+
+int live_counters = 0;
+struct counted {
+  counted() noexcept { ++live_counters; }
+  explicit counted(int v) noexcept : value(v) { ++live_counters; }
+  counted(const counted &other) noexcept : value(other.value) {
+    ++live_counters;
+  }
+  counted &operator=(const counted &) = default;
+  ~counted() { --live_counters; }
+  int value = 0;
+};
+
+// Not nothrow movable, so rehashing copies; copies throw on demand
+struct fragile {
+  static inline std::set<const fragile *> live;
+  static inline int copies_left = -1;
+  int value;
+
+  explicit fragile(int v) : value(v) { live.insert(this); }
+  fragile(const fragile &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+    live.insert(this);
+  }
+  fragile(fragile &&other) : value(other.value) { // NOLINT
+    live.insert(this);
+  }
+  fragile &operator=(const fragile &) = default;
+  ~fragile() { EXPECT_EQ(live.erase(this), 1U); }
+};
+} // namespace
+
+TEST(FlatMap, InsertFindErase) {
+  dpsg::flat_map<std::int64_t, std::string> map;
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(map.find(1), map.end());
+
+  auto [it, inserted] = map.try_emplace(1, "one");
+  ASSERT_TRUE(inserted);
+  ASSERT_EQ((*it).first, 1);
+  ASSERT_EQ((*it).second, "one");
+  ASSERT_FALSE(map.try_emplace(1, "uno").second);
+  ASSERT_EQ(map.at(1), "one");
+
+  map[2] = "two";
+  ASSERT_FALSE(map.insert_or_assign(2, "deux").second);
+  ASSERT_EQ(map.size(), 2);
+  ASSERT_EQ(map.at(2), "deux");
+  ASSERT_TRUE(map.contains(1));
+  ASSERT_EQ(map.count(3), 0);
+  ASSERT_THROW((void)map.at(3), std::out_of_range);
+
+  ASSERT_EQ(map.erase(1), 1);
+  ASSERT_EQ(map.erase(1), 0);
+  ASSERT_FALSE(map.contains(1));
+  ASSERT_EQ(map.size(), 1);
+}
+
+TEST(FlatMap, SentinelsAreNotKeys) {
+  dpsg::flat_map<int, int> map;
+  map[0] = 1;
+  ASSERT_FALSE(map.contains(std::numeric_limits<int>::min()));
+  ASSERT_FALSE(map.contains(std::numeric_limits<int>::min() + 1));
+
+  // With custom markers, the default ones are ordinary keys
+  dpsg::flat_map<int, int, std::hash<int>, dpsg::probing::linear, -1, -2>
+      custom;
+  custom[std::numeric_limits<int>::min()] = 3;
+  ASSERT_EQ(custom.at(std::numeric_limits<int>::min()), 3);
+  ASSERT_FALSE(custom.contains(-1));
+}
+
+TEST(FlatMap, ErasedSlotsKeepProbing) {
+  dpsg::flat_map<int, int, collide> map;
+  constexpr int count = 40;
+  for (int i = 0; i < count; ++i) {
+    map[i] = i * 10;
+  }
+  for (int i = 0; i < count; i += 2) {
+    ASSERT_EQ(map.erase(i), 1);
+  }
+  for (int i = 0; i < count; ++i) {
+    ASSERT_EQ(map.contains(i), i % 2 == 1) << i;
+  }
+  // Erased slots are reused
+  const auto buckets = map.bucket_count();
+  for (int i = 0; i < count; i += 2) {
+    map[i] = i * 10;
+  }
+  ASSERT_EQ(map.bucket_count(), buckets);
+  for (int i = 0; i < count; ++i) {
+    ASSERT_EQ(map.at(i), i * 10);
+  }
+}
+
+template <class Probing> void random_operations() {
+  dpsg::flat_map<std::uint32_t, std::uint32_t, std::hash<std::uint32_t>,
+                 Probing>
+      map;
+  std::map<std::uint32_t, std::uint32_t> expected;
+  std::mt19937 gen{42};
+  std::uniform_int_distribution<std::uint32_t> keys{0, 2000};
+  for (int i = 0; i < 20000; ++i) {
+    const auto key = keys(gen);
+    if (gen() % 3 == 0) {
+      ASSERT_EQ(map.erase(key), expected.erase(key));
+    } else {
+      map.insert_or_assign(key, static_cast<std::uint32_t>(i));
+      expected[key] = static_cast<std::uint32_t>(i);
+    }
+    ASSERT_LE(map.load_factor(), map.max_load_factor());
+  }
+  ASSERT_EQ(map.size(), expected.size());
+  std::size_t visited = 0;
+  for (auto [key, value] : map) {
+    ASSERT_EQ(expected.at(key), value);
+    ++visited;
+  }
+  ASSERT_EQ(visited, expected.size());
+}
+
+TEST(FlatMap, LinearProbing) { random_operations<dpsg::probing::linear>(); }
+
+TEST(FlatMap, QuadraticProbing) {
+  random_operations<dpsg::probing::quadratic>();
+}
+
+TEST(FlatMap, ValuesOfOccupiedSlotsOnly) {
+  {
+    dpsg::flat_map<short, counted> map;
+    map.reserve(100);
+    ASSERT_EQ(live_counters, 0);
+    for (short i = 0; i < 100; ++i) {
+      map.try_emplace(i, i);
+    }
+    ASSERT_EQ(live_counters, 100);
+    map.erase(3);
+    ASSERT_EQ(live_counters, 99);
+    auto copy = map;
+    ASSERT_EQ(live_counters, 198);
+    ASSERT_EQ(copy.at(50).value, 50);
+    ASSERT_FALSE(copy.contains(3));
+    copy.clear();
+    ASSERT_EQ(live_counters, 99);
+    for (short i = 100; i < 1000; ++i) {
+      map.try_emplace(i, i);
+    }
+    ASSERT_EQ(live_counters, 999);
+  }
+  ASSERT_EQ(live_counters, 0);
+}
+
+TEST(FlatMap, LoadFactor) {
+  dpsg::flat_map<std::int64_t, int> map;
+  map.max_load_factor(0.5F);
+  for (int i = 0; i < 100; ++i) {
+    map[i] = i;
+  }
+  ASSERT_LE(map.load_factor(), 0.5F);
+  ASSERT_EQ(map.bucket_count() % decltype(map)::group_size, 0);
+
+  map.reserve(1000);
+  const auto buckets = map.bucket_count();
+  ASSERT_GE(static_cast<float>(buckets) * 0.5F, 1000.F);
+  for (int i = 100; i < 1000; ++i) {
+    map[i] = i;
+  }
+  ASSERT_EQ(map.bucket_count(), buckets);
+}
+
+TEST(FlatMap, FloatingPointKeys) {
+  dpsg::flat_map<double, int> map;
+  map[0.0] = 1;
+  map[1.5] = 2;
+  ASSERT_EQ(map.at(-0.0), 1);
+  ASSERT_EQ(map.at(1.5), 2);
+  ASSERT_EQ(map.erase(1.5), 1);
+  ASSERT_FALSE(map.contains(1.5));
+  ASSERT_EQ(map.size(), 1);
+}
+
+TEST(FlatMap, MoveAndSwap) {
+  dpsg::flat_map<int, std::string> map;
+  map[1] = "one";
+  auto moved = std::move(map);
+  ASSERT_EQ(moved.at(1), "one");
+  dpsg::flat_map<int, std::string> other;
+  other[2] = "two";
+  swap(moved, other);
+  ASSERT_EQ(moved.at(2), "two");
+  ASSERT_EQ(other.at(1), "one");
+}
+
+TEST(FlatMap, ThrowingRehash) {
+  {
+    dpsg::flat_map<int, fragile> map;
+    for (int i = 0; i < 10; ++i) {
+      map.try_emplace(i, i);
+    }
+    const auto buckets = map.bucket_count();
+    ASSERT_EQ(fragile::live.size(), 10U);
+
+    fragile::copies_left = 5;
+    ASSERT_THROW(map.reserve(buckets * 4), std::runtime_error);
+    ASSERT_EQ(map.bucket_count(), buckets);
+    ASSERT_EQ(map.size(), 10U);
+    ASSERT_EQ(fragile::live.size(), 10U);
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_EQ(map.at(i).value, i);
+    }
+
+    fragile::copies_left = -1;
+    map.reserve(buckets * 4);
+    ASSERT_GT(map.bucket_count(), buckets);
+    ASSERT_EQ(fragile::live.size(), 10U);
+    ASSERT_EQ(map.at(9).value, 9);
+  }
+  ASSERT_EQ(fragile::live.size(), 0U);
+}
@@ -0,0 +1,164 @@
+// Only this translation unit uses access::instrumented
+#define DPSG_OPTIONAL_INSTRUMENTATION
+#include "instrumentation.hpp"
+#include "pooled_storage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+namespace instrumentation = dpsg::instrumentation;
+
+template <class T, class Control = dpsg::control::dependent_bool,
+          class Storage = dpsg::storage::aligned>
+using instrumented = dpsg::generalized_optional<
+    T, dpsg::policy<dpsg::access::instrumented<dpsg::access::extended>,
+                    Control, Storage>>;
+
+using counted_int = instrumented<int>;
+using counted_tombstone =
+    instrumented<std::int32_t,
+                 dpsg::control::tombstone<std::int32_t, INT32_MIN>>;
+using counted_string = instrumented<std::string>;
+using counted_pooled =
+    instrumented<std::string, dpsg::control::from_storage,
+                 dpsg::storage::pooled<dpsg::pool::freelist>>;
+} // namespace
+
+static_assert(std::is_same_v<dpsg::access::instrumented<dpsg::access::extended>,
+                             dpsg::access::counted<dpsg::access::extended>>);
+// Counters are not stored in the optional, and do not change its traits
+static_assert(sizeof(counted_int) == sizeof(dpsg::optional<int>));
+static_assert(std::is_trivially_copyable_v<counted_int>);
+static_assert(sizeof(counted_tombstone) == sizeof(std::int32_t));
+static_assert(dpsg::is_trivially_relocatable_v<counted_pooled>);
+
+TEST(Instrumentation, Engagements) {
+  instrumentation::reset();
+  {
+    counted_int a{1};
+    counted_int b;
+    b = 2;
+    b.emplace(3);
+    b.reset();
+    b.reset();
+    b.emplace(4);
+    a = dpsg::nullopt;
+  }
+  const auto counts = instrumentation::counts_of<counted_int>();
+  ASSERT_EQ(counts.engagements, 3U);
+  ASSERT_EQ(counts.resets, 2U);
+  ASSERT_EQ(counts.accesses, 0U);
+}
+
+TEST(Instrumentation, Accesses) {
+  instrumentation::reset();
+  counted_string text{"hello"};
+  counted_string empty;
+  ASSERT_EQ(text.value(), "hello");
+  ASSERT_EQ(text->size(), 5U);
+  ASSERT_EQ(*std::move(text), "hello");
+  ASSERT_EQ(empty.value_or("fallback"), "fallback");
+  ASSERT_EQ(text.value_or("fallback"), "hello");
+  ASSERT_THROW((void)empty.value(), dpsg::bad_optional_access);
+  ASSERT_THROW((void)counted_string{}.value(), dpsg::bad_optional_access);
+  ASSERT_EQ(empty.with_value([](const std::string &s) { return s.size(); },
+                             std::size_t{0}),
+            0U);
+  std::size_t seen = 0;
+  text.with_value([&](const std::string &s) { seen = s.size(); });
+  ASSERT_EQ(seen, 5U);
+
+  const auto counts = instrumentation::counts_of<counted_string>();
+  ASSERT_EQ(counts.engagements, 1U);
+  ASSERT_EQ(counts.accesses, 9U);
+  ASSERT_EQ(counts.empty_accesses, 4U);
+  ASSERT_EQ(counts.throws, 2U);
+}
+
+TEST(Instrumentation, Controls) {
+  instrumentation::reset();
+  counted_tombstone a{7};
+  counted_tombstone b = a;
+  ASSERT_EQ(*b, 7);
+  a.reset();
+  ASSERT_EQ(a.value_or(0), 0);
+
+  counted_pooled p{"text"};
+  counted_pooled q = std::move(p);
+  ASSERT_FALSE(p.has_value());
+  ASSERT_EQ(*q, "text");
+  p = q;
+
+  const auto tombstones = instrumentation::counts_of<counted_tombstone>();
+  // The copy of a trivially copyable optional is not seen
+  ASSERT_EQ(tombstones.engagements, 1U);
+  ASSERT_EQ(tombstones.resets, 1U);
+  ASSERT_EQ(tombstones.accesses, 2U);
+  ASSERT_EQ(tombstones.empty_accesses, 1U);
+
+  const auto pooled = instrumentation::counts_of<counted_pooled>();
+  ASSERT_EQ(pooled.engagements, 3U);
+  ASSERT_EQ(pooled.accesses, 1U);
+}
+
+TEST(Instrumentation, Threads) {
+  instrumentation::reset();
+  constexpr static int thread_count = 4;
+  constexpr static int per_thread = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_count; ++t) {
+    threads.emplace_back([] {
+      counted_int value{1};
+      counted_int empty;
+      int sum = 0;
+      for (int i = 0; i < per_thread; ++i) {
+        sum += *value + empty.value_or(0);
+      }
+      ASSERT_EQ(sum, per_thread);
+    });
+  }
+  // Running threads are included, exited ones as well
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const auto counts = instrumentation::counts_of<counted_int>();
+  ASSERT_EQ(counts.engagements, static_cast<std::uint64_t>(thread_count));
+  ASSERT_EQ(counts.accesses,
+            static_cast<std::uint64_t>(2 * thread_count * per_thread));
+  ASSERT_EQ(counts.empty_accesses,
+            static_cast<std::uint64_t>(thread_count * per_thread));
+}
+
+TEST(Instrumentation, Reports) {
+  instrumentation::reset();
+  counted_string empty;
+  ASSERT_THROW((void)std::as_const(empty).value(), dpsg::bad_optional_access);
+
+  int throwing = 0;
+  instrumentation::report([&](const instrumentation::record &r) {
+    if (r.counts.throws != 0) {
+      ++throwing;
+      ASSERT_EQ(r.counts.throws, 1U);
+      ASSERT_NE(r.type.find("basic_string"), std::string::npos) << r.type;
+      ASSERT_NE(r.type.find("aligned"), std::string::npos) << r.type;
+    }
+  });
+  ASSERT_EQ(throwing, 1);
+
+  std::ostringstream json;
+  instrumentation::write_json(json);
+  const std::string text = json.str();
+  ASSERT_EQ(text.rfind("{\"optionals\":[", 0), 0U);
+  ASSERT_NE(text.find("\"throws\":1}"), std::string::npos);
+  ASSERT_EQ(text.substr(text.size() - 2), "]}");
+}
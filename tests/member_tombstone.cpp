@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "generalized_optional.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+constexpr static inline int fourty_two = 42;
+constexpr static inline const char *hello_world = "Hello World!";
+
+struct record {
+  std::uint32_t id;
+  std::string name;
+};
+
+struct descriptor {
+  int fd;
+  int flags;
+};
+
+using orecord = dpsg::optional_member_tombstone<&record::id, 0>;
+using odescriptor = dpsg::optional_member_tombstone<&descriptor::fd, -1>;
+
+// Member tombstones need standard-layout classes
+static_assert(std::is_standard_layout_v<record>);
+static_assert(sizeof(orecord) == sizeof(record));
+static_assert(sizeof(odescriptor) == sizeof(descriptor));
+static_assert(std::is_trivially_copyable_v<odescriptor>);
+
+TEST(MemberTombstone, Ctor) {
+  orecord r;
+  ASSERT_FALSE(r.has_value());
+  orecord r2{record{fourty_two, hello_world}};
+  ASSERT_TRUE(r2.has_value());
+  ASSERT_EQ(r2->id, fourty_two);
+  ASSERT_EQ(r2->name, hello_world);
+  orecord r3{r2};
+  ASSERT_TRUE(r3.has_value());
+  ASSERT_EQ(r3->name, hello_world);
+  orecord r4{std::move(r3)};
+  ASSERT_TRUE(r4.has_value());
+  ASSERT_EQ(r4->name, hello_world);
+}
+
+TEST(MemberTombstone, Assignment) {
+  orecord r;
+  r = record{1, hello_world};
+  ASSERT_TRUE(r.has_value());
+  orecord r2;
+  r2 = r;
+  ASSERT_EQ(r2->name, hello_world);
+  r = dpsg::nullopt;
+  ASSERT_FALSE(r.has_value());
+  r2 = r;
+  ASSERT_FALSE(r2.has_value());
+  r2.emplace(record{2, hello_world});
+  ASSERT_EQ(r2->id, 2);
+  r2.reset();
+  ASSERT_FALSE(r2.has_value());
+}
+
+TEST(MemberTombstone, TrivialRecord) {
+  odescriptor d;
+  ASSERT_FALSE(d.has_value());
+  d = descriptor{0, fourty_two};
+  ASSERT_TRUE(d.has_value());
+  ASSERT_EQ(d->flags, fourty_two);
+  ASSERT_EQ(d.with_value([](const descriptor &v) { return v.fd; }, -2), 0);
+  d.reset();
+  ASSERT_EQ(d.with_value([](const descriptor &v) { return v.fd; }, -2), -2);
+}
+
+// Only the bytes of the member are touched while empty
+TEST(MemberTombstone, EmptyStorage) {
+  odescriptor d;
+  descriptor raw;
+  std::memcpy(&raw, &d, sizeof(descriptor));
+  ASSERT_EQ(raw.fd, -1);
+  d.emplace(descriptor{3, 0});
+  d.reset();
+  std::memcpy(&raw, &d, sizeof(descriptor));
+  ASSERT_EQ(raw.fd, -1);
+  ASSERT_FALSE(d.has_value());
+}
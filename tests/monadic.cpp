@@ -0,0 +1,130 @@
+#include "monadic_optional.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace {
+using oint = dpsg::optional_monadic<int>;
+
+struct request {
+  std::string user;
+  int port;
+};
+
+struct counted {
+  static inline int copies = 0;
+  static inline int moves = 0;
+  int value;
+
+  explicit counted(int v) noexcept : value{v} {}
+  counted(const counted &other) noexcept : value{other.value} { ++copies; }
+  counted(counted &&other) noexcept : value{other.value} { ++moves; }
+  counted &operator=(const counted &) = default;
+  counted &operator=(counted &&) = default;
+  ~counted() = default;
+};
+} // namespace
+
+TEST(Monadic, Transform) {
+  const oint o{20};
+  const dpsg::optional<int> r =
+      o.transform([](int i) { return i + 1; }).transform([](int i) {
+        return i * 2;
+      });
+  ASSERT_TRUE(r.has_value());
+  ASSERT_EQ(*r, 42);
+
+  const dpsg::optional<std::string> s =
+      oint{}.transform([](int i) { return std::to_string(i); });
+  ASSERT_FALSE(s.has_value());
+}
+
+TEST(Monadic, MemberPointers) {
+  dpsg::optional_monadic<request> o{request{"root", 22}};
+  ASSERT_EQ(o.transform(&request::port).value_or(0), 22);
+  ASSERT_EQ(o.transform(&request::user).evaluate()->size(), 4U);
+}
+
+TEST(Monadic, Filter) {
+  const oint o{3};
+  const auto odd = [](int i) { return i % 2 == 1; };
+  ASSERT_EQ(o.filter(odd).value_or(0), 3);
+  ASSERT_EQ(oint{4}.filter(odd).value_or(0), 0);
+  ASSERT_EQ(oint{}.filter(odd).value_or(-1), -1);
+}
+
+TEST(Monadic, AndThen) {
+  const auto half = [](int i) {
+    return i % 2 == 0 ? dpsg::optional<int>{i / 2} : dpsg::optional<int>{};
+  };
+  ASSERT_EQ(oint{8}.and_then(half).and_then(half).value_or(0), 2);
+  ASSERT_EQ(oint{6}.and_then(half).and_then(half).value_or(0), 0);
+  // Any optional-like type
+  const auto parse = [](int i) -> std::optional<std::string> {
+    if (i < 0) {
+      return std::nullopt;
+    }
+    return std::to_string(i);
+  };
+  ASSERT_EQ(oint{12}.and_then(parse).value_or(""), "12");
+  ASSERT_EQ(oint{-1}.and_then(parse).value_or("none"), "none");
+}
+
+TEST(Monadic, OrElse) {
+  int calls = 0;
+  const auto fallback = [&calls] {
+    ++calls;
+    return dpsg::optional<int>{7};
+  };
+  ASSERT_EQ(oint{1}.or_else(fallback).value_or(0), 1);
+  ASSERT_EQ(calls, 0);
+  ASSERT_EQ(oint{}.or_else(fallback).value_or(0), 7);
+  ASSERT_EQ(calls, 1);
+  // Recovers from an earlier filter
+  ASSERT_EQ(oint{2}
+                .filter([](int i) { return i > 5; })
+                .or_else(fallback)
+                .transform([](int i) { return i * 6; })
+                .value_or(0),
+            42);
+}
+
+TEST(Monadic, LazyAndReusable) {
+  oint o{1};
+  int calls = 0;
+  const auto pipeline = o.transform([&calls](int i) {
+    ++calls;
+    return i + 1;
+  });
+  ASSERT_EQ(calls, 0);
+  ASSERT_EQ(pipeline.value_or(0), 2);
+  ASSERT_EQ(calls, 1);
+  const auto longer = pipeline.filter([](int i) { return i > 1; });
+  ASSERT_EQ(longer.value_or(0), 2);
+  ASSERT_EQ(calls, 2);
+}
+
+TEST(Monadic, NoIntermediateCopies) {
+  counted::copies = 0;
+  counted::moves = 0;
+  const dpsg::optional_monadic<counted> o{counted{1}};
+  counted::moves = 0;
+  const auto r = o.filter([](const counted &c) { return c.value > 0; })
+                     .filter([](const counted &c) { return c.value < 10; })
+                     .evaluate();
+  ASSERT_EQ(r->value, 1);
+  ASSERT_EQ(counted::copies, 1);
+  ASSERT_EQ(counted::moves, 0);
+}
+
+TEST(Monadic, Rvalues) {
+  dpsg::optional_monadic<std::unique_ptr<int>> o{std::make_unique<int>(5)};
+  const dpsg::optional<std::unique_ptr<int>> moved =
+      std::move(o).filter([](const std::unique_ptr<int> &p) { return *p > 0; });
+  ASSERT_EQ(**moved, 5);
+  ASSERT_EQ(*o, nullptr); // NOLINT(bugprone-use-after-move)
+}
@@ -1,6 +1,8 @@
 #include "generalized_optional.hpp"
+#include "small_buffer_storage.hpp"
 #include <gtest/gtest.h>
 
+#include <exception>
 #include <initializer_list>
 #include <string>
 #include <utility>
@@ -200,6 +202,102 @@ TEST(Optional, Emplace) {
   ASSERT_EQ(o2->size(), 0);
 }
 
+// Neither copyable nor movable, as a parser state holding pointers into
+// itself would be
+struct pinned {
+  explicit pinned(int v) : value(v), self(this) {}
+  pinned(const pinned &) = delete;
+  pinned(pinned &&) = delete;
+  pinned &operator=(const pinned &) = delete;
+  pinned &operator=(pinned &&) = delete;
+  ~pinned() = default;
+
+  int value;
+  pinned *self;
+};
+
+pinned make_pinned(int v) { return pinned{v}; }
+
+template <class O> void check_emplace_with() {
+  O o{dpsg::from_invoke, [] { return make_pinned(fourtytwo); }};
+  ASSERT_TRUE(o.has_value());
+  ASSERT_EQ(o->value, fourtytwo);
+  ASSERT_EQ(o->self, &*o);
+  const pinned &p = o.emplace_with([] { return make_pinned(3); });
+  ASSERT_EQ(&p, &*o);
+  ASSERT_EQ(p.value, 3);
+  ASSERT_EQ(p.self, &p);
+}
+
+TEST(Optional, EmplaceWith) {
+  check_emplace_with<dpsg::optional<pinned>>();
+  check_emplace_with<dpsg::optional_small<pinned>>();
+  check_emplace_with<dpsg::optional_small<pinned, sizeof(void *)>>();
+
+  dpsg::optional<string> s;
+  s.emplace_with([] { return string{hello_world}; });
+  ASSERT_EQ(*s, hello_world);
+}
+
+TEST(Optional, EmplaceWithThrowing) {
+  dpsg::optional<string> s{hello_world};
+  ASSERT_THROW(s.emplace_with([]() -> string { throw std::exception{}; }),
+               std::exception);
+  ASSERT_FALSE(s.has_value());
+}
+
+TEST(Optional, BuildsWithParentheses) {
+  dpsg::optional<vector<int>> v{dpsg::in_place, 3U, 1};
+  ASSERT_EQ(v->size(), 3U);
+  v.emplace(2U, 7);
+  ASSERT_EQ(*v, (vector<int>{7, 7}));
+  v.emplace({2, 7});
+  ASSERT_EQ(*v, (vector<int>{2, 7}));
+
+  struct aggregate {
+    int i;
+    string s;
+  };
+  dpsg::optional<aggregate> a{dpsg::in_place, 1, hello_world};
+  ASSERT_EQ(a->s, hello_world);
+}
+
+struct operation_counter {
+  static inline int constructions = 0;
+  static inline int assignments = 0;
+
+  explicit operation_counter(int v) : value(v) { ++constructions; }
+  operation_counter(const operation_counter &other) : value(other.value) {
+    ++constructions;
+  }
+  operation_counter &operator=(const operation_counter &other) {
+    value = other.value;
+    ++assignments;
+    return *this;
+  }
+  ~operation_counter() = default;
+
+  int value;
+};
+
+TEST(Optional, EmplaceAssigns) {
+  dpsg::optional<operation_counter> o;
+  const operation_counter one{1};
+  operation_counter::constructions = 0;
+  o.emplace(one);
+  ASSERT_EQ(operation_counter::constructions, 1);
+  o.emplace(one);
+  ASSERT_EQ(operation_counter::constructions, 1);
+  ASSERT_EQ(operation_counter::assignments, 1);
+  o.emplace(2);
+  ASSERT_EQ(operation_counter::constructions, 2);
+  ASSERT_EQ(o->value, 2);
+
+  // Self emplacement
+  o.emplace(*o);
+  ASSERT_EQ(o->value, 2);
+}
+
 struct dtor_recorder {
   dtor_recorder() = delete;
   dtor_recorder(const dtor_recorder &) = delete;
@@ -253,3 +351,13 @@ TEST(Optional, WithValue) {
   ASSERT_EQ(make_ncs(something_else).with_value(g, -1), 0);
   ASSERT_EQ(dpsg::optional<noncopyable_string>{}.with_value(g, -1), -1);
 }
+
+// Copies of whole optionals, as made by std::vector from an initializer list.
+// GCC 12 drops the payload stores of std::aligned_storage_t there at -O2.
+TEST(Optional, InitializerListCopies) {
+  const vector<dpsg::optional<int>> values{5, {}, fourtytwo};
+  ASSERT_EQ(values.size(), 3U);
+  ASSERT_EQ(values[0].value_or(0), 5);
+  ASSERT_FALSE(values[1].has_value());
+  ASSERT_EQ(values[2].value_or(0), 42);
+}
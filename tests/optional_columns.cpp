@@ -0,0 +1,235 @@
+#include "optional_columns.hpp"
+#include "small_buffer_storage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace {
+using tint = dpsg::optional_tombstone<std::int64_t>;
+using tdouble = dpsg::optional_tombstone<double>;
+using fdouble = dpsg::optional<double>;
+using fint = dpsg::optional<std::int32_t>;
+using fbool = dpsg::optional<bool>;
+using boxed = dpsg::optional_small<std::int64_t>;
+
+constexpr std::int64_t max = std::numeric_limits<std::int64_t>::max();
+
+std::vector<dpsg::scan::isa> supported_isas() {
+  std::vector<dpsg::scan::isa> result;
+  for (auto target : {dpsg::scan::isa::scalar, dpsg::scan::isa::sse2,
+                      dpsg::scan::isa::avx2, dpsg::scan::isa::avx512}) {
+    if (dpsg::scan::supports(target)) {
+      result.push_back(target);
+    }
+  }
+  return result;
+}
+
+// Long enough to go through the vector loops and their tails
+template <class O> std::vector<O> column(std::size_t size, int seed) {
+  std::vector<O> result(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    if ((i * 7 + static_cast<std::size_t>(seed)) % 5 != 0) {
+      result[i] = static_cast<typename O::value_type>(
+          static_cast<int>(i % 23) - 11 + seed);
+    }
+  }
+  return result;
+}
+
+template <class O, class L, class R, class F>
+void expect_elementwise(const std::vector<L> &lhv, const std::vector<R> &rhv,
+                        const std::vector<O> &out, F expected) {
+  ASSERT_EQ(lhv.size(), out.size());
+  for (std::size_t i = 0; i < out.size(); ++i) {
+    if (lhv[i].has_value() && rhv[i].has_value()) {
+      ASSERT_TRUE(out[i].has_value()) << i;
+      ASSERT_EQ(*out[i], expected(*lhv[i], *rhv[i])) << i;
+    } else {
+      ASSERT_FALSE(out[i].has_value()) << i;
+    }
+  }
+}
+} // namespace
+
+static_assert(dpsg::columns::detail::kind_of<tint>() ==
+              dpsg::columns::detail::kind::tombstone);
+static_assert(dpsg::columns::detail::kind_of<tdouble>() ==
+              dpsg::columns::detail::kind::tombstone);
+static_assert(dpsg::columns::detail::kind_of<fdouble>() ==
+              dpsg::columns::detail::kind::flag);
+static_assert(dpsg::columns::detail::kind_of<fbool>() ==
+              dpsg::columns::detail::kind::flag);
+static_assert(dpsg::columns::detail::kind_of<boxed>() ==
+              dpsg::columns::detail::kind::generic);
+// Narrow integers must not be promoted to int, where products overflow
+static_assert(std::is_same_v<
+              dpsg::columns::detail::wide_t<std::int16_t>::type, unsigned>);
+static_assert(std::is_same_v<
+              dpsg::columns::detail::wide_t<std::uint64_t>::type,
+              std::uint64_t>);
+
+TEST(Columns, FlagLayout) {
+  // The flag kernels rely on dependent_bool storing the flag after the payload
+  fdouble engaged{1.5};
+  fdouble empty;
+  ASSERT_TRUE((dpsg::columns::detail::column<fdouble>::present(engaged)));
+  ASSERT_FALSE((dpsg::columns::detail::column<fdouble>::present(empty)));
+  dpsg::columns::detail::column<fdouble>::write(empty, 2.5, true);
+  ASSERT_TRUE(empty.has_value());
+  ASSERT_EQ(*empty, 2.5);
+  dpsg::columns::detail::column<fdouble>::write(engaged, 0.0, false);
+  ASSERT_FALSE(engaged.has_value());
+}
+
+TEST(Columns, TombstoneArithmetic) {
+  const auto a = column<tint>(301, 1);
+  const auto b = column<tint>(301, 3);
+  for (auto target : supported_isas()) {
+    std::vector<tint> out(a.size());
+    dpsg::columns::add(target, a.data(), b.data(), out.data(), out.size());
+    expect_elementwise(a, b, out, [](auto x, auto y) { return x + y; });
+    dpsg::columns::subtract(target, a.data(), b.data(), out.data(),
+                            out.size());
+    expect_elementwise(a, b, out, [](auto x, auto y) { return x - y; });
+    dpsg::columns::multiply(target, a.data(), b.data(), out.data(),
+                            out.size());
+    expect_elementwise(a, b, out, [](auto x, auto y) { return x * y; });
+  }
+}
+
+TEST(Columns, FlagArithmetic) {
+  const auto a = column<fdouble>(301, 2);
+  const auto b = column<fdouble>(301, 4);
+  for (auto target : supported_isas()) {
+    std::vector<fdouble> out(a.size());
+    dpsg::columns::add(target, a.data(), b.data(), out.data(), out.size());
+    expect_elementwise(a, b, out, [](auto x, auto y) { return x + y; });
+    dpsg::columns::multiply(target, a.data(), b.data(), out.data(),
+                            out.size());
+    expect_elementwise(a, b, out, [](auto x, auto y) { return x * y; });
+  }
+}
+
+TEST(Columns, MixedColumns) {
+  const auto a = column<tdouble>(130, 1);
+  const auto b = column<fdouble>(130, 2);
+  std::vector<fdouble> out(a.size());
+  dpsg::columns::subtract(a.data(), b.data(), out.data(), out.size());
+  expect_elementwise(a, b, out, [](auto x, auto y) { return x - y; });
+}
+
+TEST(Columns, Expression) {
+  // a + b * c, in place
+  auto a = column<tint>(97, 1);
+  const auto b = column<tint>(97, 2);
+  const auto c = column<tint>(97, 3);
+  std::vector<tint> result(a.size());
+  dpsg::columns::multiply(b.data(), c.data(), result.data(), result.size());
+  dpsg::columns::add(a.data(), result.data(), result.data(), result.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (a[i].has_value() && b[i].has_value() && c[i].has_value()) {
+      ASSERT_EQ(*result[i], *a[i] + *b[i] * *c[i]);
+    } else {
+      ASSERT_FALSE(result[i].has_value());
+    }
+  }
+}
+
+TEST(Columns, Overflow) {
+  const std::vector<tint> a{max, max, 1, -max, 3};
+  const std::vector<tint> b{1, 2, 2, 2, 0};
+  for (auto target : supported_isas()) {
+    std::vector<tint> out(a.size());
+    dpsg::columns::add(target, a.data(), b.data(), out.data(), out.size(),
+                       dpsg::columns::overflow::to_null);
+    ASSERT_FALSE(out[0].has_value());
+    ASSERT_EQ(*out[2], 3);
+    dpsg::columns::add(target, a.data(), b.data(), out.data(), out.size());
+    ASSERT_FALSE(out[0].has_value()) << "wraps around to the sentinel";
+    ASSERT_TRUE(out[1].has_value());
+    ASSERT_EQ(*out[1], std::numeric_limits<std::int64_t>::min() + 1);
+    dpsg::columns::multiply(target, a.data(), b.data(), out.data(),
+                            out.size(), dpsg::columns::overflow::to_null);
+    ASSERT_FALSE(out[1].has_value());
+    ASSERT_FALSE(out[3].has_value());
+    ASSERT_EQ(*out[2], 2);
+    dpsg::columns::subtract(target, b.data(), a.data(), out.data(),
+                            out.size(), dpsg::columns::overflow::to_null);
+    ASSERT_EQ(*out[0], 1 - max);
+    ASSERT_FALSE(out[3].has_value());
+  }
+}
+
+TEST(Columns, Divide) {
+  const std::vector<fint> a{7, -8, std::numeric_limits<std::int32_t>::min(),
+                            5, fint{}};
+  const std::vector<fint> b{2, 0, -1, fint{}, 1};
+  std::vector<fint> out(a.size());
+  dpsg::columns::divide(a.data(), b.data(), out.data(), out.size());
+  ASSERT_EQ(*out[0], 3);
+  ASSERT_FALSE(out[1].has_value());
+  ASSERT_EQ(*out[2], std::numeric_limits<std::int32_t>::min());
+  ASSERT_FALSE(out[3].has_value());
+  ASSERT_FALSE(out[4].has_value());
+  dpsg::columns::divide(a.data(), b.data(), out.data(), out.size(),
+                        dpsg::columns::overflow::to_null);
+  ASSERT_FALSE(out[2].has_value());
+}
+
+TEST(Columns, Comparisons) {
+  const auto a = column<tint>(200, 1);
+  const auto b = column<tint>(200, 2);
+  for (auto target : supported_isas()) {
+    std::vector<fbool> out(a.size());
+    dpsg::columns::less(target, a.data(), b.data(), out.data(), out.size());
+    expect_elementwise(a, b, out, [](auto x, auto y) { return x < y; });
+    dpsg::columns::equal(target, a.data(), b.data(), out.data(), out.size());
+    expect_elementwise(a, b, out, [](auto x, auto y) { return x == y; });
+    dpsg::columns::greater_equal(target, a.data(), b.data(), out.data(),
+                                 out.size());
+    expect_elementwise(a, b, out, [](auto x, auto y) { return x >= y; });
+  }
+}
+
+TEST(Columns, Generic) {
+  const auto a = column<boxed>(50, 1);
+  const auto b = column<tint>(50, 2);
+  std::vector<boxed> out(a.size());
+  dpsg::columns::add(a.data(), b.data(), out.data(), out.size());
+  expect_elementwise(a, b, out, [](auto x, auto y) { return x + y; });
+  std::vector<fbool> cmp(a.size());
+  dpsg::columns::not_equal(a.data(), b.data(), cmp.data(), cmp.size());
+  expect_elementwise(a, b, cmp, [](auto x, auto y) { return x != y; });
+}
+
+TEST(Columns, NarrowWrapAround) {
+  using fu16 = dpsg::optional<std::uint16_t>;
+  using ti16 = dpsg::optional_tombstone<std::int16_t>;
+  const std::vector<fu16> a{65535, 65535, 300};
+  const std::vector<fu16> b{65535, 2, 300};
+  const std::vector<ti16> c{-32767, 32767, 181};
+  const std::vector<ti16> d{-32767, 32767, 181};
+  for (auto target : supported_isas()) {
+    std::vector<fu16> out(a.size());
+    dpsg::columns::multiply(target, a.data(), b.data(), out.data(),
+                            out.size());
+    ASSERT_EQ(*out[0], 1);
+    ASSERT_EQ(*out[1], 65534);
+    ASSERT_EQ(*out[2], static_cast<std::uint16_t>(90000));
+    std::vector<ti16> sout(c.size());
+    dpsg::columns::multiply(target, c.data(), d.data(), sout.data(),
+                            sout.size());
+    ASSERT_EQ(*sout[0], 1);
+    ASSERT_EQ(*sout[1], 1);
+    ASSERT_EQ(*sout[2], static_cast<std::int16_t>(32761));
+    dpsg::columns::multiply(target, c.data(), d.data(), sout.data(),
+                            sout.size(), dpsg::columns::overflow::to_null);
+    ASSERT_FALSE(sout[0].has_value());
+    ASSERT_EQ(*sout[2], 32761);
+  }
+}
@@ -0,0 +1,192 @@
+#include "optional_ring.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using spsc = dpsg::spsc_ring<std::uint64_t, 16>;
+using mpmc = dpsg::mpmc_ring<std::uint64_t, 16>;
+using string_mpmc = dpsg::mpmc_ring<std::string, 8>;
+
+constexpr static inline std::uint64_t item_count = 20000;
+constexpr static inline int thread_count = 4;
+
+static_assert(sizeof(mpmc::cell_type) ==
+              sizeof(std::uint64_t) + sizeof(std::size_t));
+static_assert(sizeof(spsc::cell_type) == sizeof(std::uint64_t));
+
+template <class Ring> void check_single_thread(Ring &ring) {
+  for (std::uint64_t i = 0; i < Ring::capacity(); ++i) {
+    ASSERT_TRUE(ring.try_push(i));
+  }
+  ASSERT_FALSE(ring.try_push(0));
+  for (std::uint64_t i = 0; i < Ring::capacity(); ++i) {
+    auto value = ring.try_pop();
+    ASSERT_TRUE(value.has_value());
+    ASSERT_EQ(*value, i);
+  }
+  ASSERT_FALSE(ring.try_pop().has_value());
+
+  std::vector<std::uint64_t> in(Ring::capacity() + 4);
+  std::iota(in.begin(), in.end(), 1);
+  ASSERT_EQ(ring.try_push_n(in.begin(), 5), 5);
+  ASSERT_EQ(ring.try_push_n(in.begin() + 5, in.size() - 5),
+            Ring::capacity() - 5);
+  std::vector<std::uint64_t> out(in.size());
+  ASSERT_EQ(ring.try_pop_n(out.begin(), 3), 3);
+  ASSERT_EQ(ring.try_pop_n(out.begin() + 3, out.size()),
+            Ring::capacity() - 3);
+  for (std::size_t i = 0; i < Ring::capacity(); ++i) {
+    ASSERT_EQ(out[i], in[i]);
+  }
+  ASSERT_EQ(ring.try_pop_n(out.begin(), out.size()), 0);
+}
+
+TEST(SpscRing, SingleThread) {
+  auto ring = std::make_unique<spsc>();
+  check_single_thread(*ring);
+}
+
+TEST(MpmcRing, SingleThread) {
+  auto ring = std::make_unique<mpmc>();
+  check_single_thread(*ring);
+  ASSERT_EQ(ring->size_approx(), 0);
+}
+
+TEST(SpscRing, ProducerConsumer) {
+  auto ring = std::make_unique<spsc>();
+  std::thread producer{[&ring] {
+    std::uint64_t batch[3];
+    for (std::uint64_t i = 1; i <= item_count;) {
+      if (i % 2 == 0 && i + 3 <= item_count) {
+        std::iota(std::begin(batch), std::end(batch), i);
+        i += ring->try_push_n(std::begin(batch), 3);
+      } else if (ring->try_push(i)) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }};
+  std::uint64_t expected = 1;
+  while (expected <= item_count) {
+    std::uint64_t batch[5];
+    const auto popped = ring->try_pop_n(std::begin(batch), 5);
+    if (popped == 0) {
+      std::this_thread::yield();
+    }
+    for (std::size_t i = 0; i < popped; ++i) {
+      ASSERT_EQ(batch[i], expected++);
+    }
+  }
+  producer.join();
+}
+
+TEST(MpmcRing, ProducersConsumers) {
+  auto ring = std::make_unique<mpmc>();
+  std::atomic<std::uint64_t> sum{0};
+  std::atomic<std::uint64_t> received{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&ring, t] {
+      for (std::uint64_t i = static_cast<std::uint64_t>(t); i < item_count;
+           i += thread_count) {
+        while (!ring->try_push(i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&ring, &sum, &received] {
+      std::uint64_t batch[4];
+      while (received.load() < item_count) {
+        const auto popped = ring->try_pop_n(std::begin(batch), 4);
+        if (popped == 0) {
+          std::this_thread::yield();
+        }
+        for (std::size_t i = 0; i < popped; ++i) {
+          sum += batch[i];
+        }
+        received += popped;
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(received.load(), item_count);
+  ASSERT_EQ(sum.load(), item_count * (item_count - 1) / 2);
+}
+
+TEST(MpmcRing, NonTrivialValues) {
+  string_mpmc ring;
+  ASSERT_TRUE(ring.try_push("Hello World! This does not fit in SSO"));
+  ASSERT_TRUE(ring.try_push("Second"));
+  ASSERT_EQ(*ring.try_pop(), "Hello World! This does not fit in SSO");
+  std::vector<std::string> in{"a", "b", "c"};
+  ASSERT_EQ(ring.try_push_n(in.begin(), in.size()), 3);
+  std::vector<std::string> out(4);
+  ASSERT_EQ(ring.try_pop_n(out.begin(), out.size()), 4);
+  ASSERT_EQ(out[0], "Second");
+  ASSERT_EQ(out[3], "c");
+}
+
+TEST(Ring, Attach) {
+  alignas(mpmc) unsigned char memory[sizeof(mpmc)];
+  auto *created = mpmc::create_at(memory);
+  ASSERT_TRUE(created->try_push(1));
+  auto *attached = mpmc::attach(memory);
+  ASSERT_EQ(attached, created);
+  ASSERT_EQ(*attached->try_pop(), 1);
+  ASSERT_EQ((dpsg::mpmc_ring<std::uint64_t, 32>::attach(memory)), nullptr);
+  ASSERT_EQ((dpsg::mpmc_ring<std::uint32_t, 16>::attach(memory)), nullptr);
+  created->~mpmc();
+}
+
+#if defined(__unix__)
+TEST(Ring, SharedMemory) {
+  void *memory = mmap(nullptr, sizeof(spsc), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(memory, MAP_FAILED);
+  spsc::create_at(memory);
+  const pid_t child = fork();
+  ASSERT_NE(child, -1);
+  if (child == 0) {
+    auto *ring = spsc::attach(memory);
+    for (std::uint64_t i = 1; ring != nullptr && i <= item_count;) {
+      if (ring->try_push(i)) {
+        ++i;
+      } else {
+        sched_yield();
+      }
+    }
+    _exit(ring == nullptr ? 1 : 0);
+  }
+  auto *ring = spsc::attach(memory);
+  ASSERT_NE(ring, nullptr);
+  std::uint64_t expected = 1;
+  while (expected <= item_count) {
+    auto value = ring->try_pop();
+    if (value.has_value()) {
+      ASSERT_EQ(*value, expected++);
+    } else {
+      sched_yield();
+    }
+  }
+  int status = 0;
+  waitpid(child, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  munmap(memory, sizeof(spsc));
+}
+#endif
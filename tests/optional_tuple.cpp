@@ -0,0 +1,174 @@
+#include "optional_tuple.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace {
+struct id {};
+struct name {};
+struct score {};
+
+using record = dpsg::optional_tuple<dpsg::field<id, std::int64_t>,
+                                    dpsg::field<name, std::string>,
+                                    dpsg::field<score, double>, char>;
+
+struct eight_fields {
+  dpsg::optional<std::int32_t> a, b, c, d, e, f, g, h;
+};
+using packed = dpsg::optional_tuple<std::int32_t, std::int32_t, std::int32_t,
+                                    std::int32_t, std::int32_t, std::int32_t,
+                                    std::int32_t, std::int32_t>;
+
+// Counts live instances, throws on the copy of a poisoned one
+struct tracked {
+  static inline int live = 0;
+  int value;
+  bool poisoned = false;
+
+  explicit tracked(int v, bool p = false) : value(v), poisoned(p) { ++live; }
+  tracked(const tracked &other) : value(other.value) {
+    if (other.poisoned) {
+      throw std::runtime_error("copy");
+    }
+    ++live;
+  }
+  tracked(tracked &&other) noexcept
+      : value(other.value), poisoned(other.poisoned) {
+    ++live;
+  }
+  tracked &operator=(const tracked &) = default;
+  tracked &operator=(tracked &&) = default;
+  ~tracked() { --live; }
+};
+} // namespace
+
+// Payloads by decreasing alignment, then a single mask byte
+static_assert(sizeof(eight_fields) == 64);
+static_assert(sizeof(packed) == 36);
+static_assert(std::is_same_v<packed::mask_type, std::uint8_t>);
+static_assert(packed::full_mask == 0xFF);
+static_assert(sizeof(dpsg::optional_tuple<char, double, char, std::int32_t>) ==
+              16);
+static_assert(std::is_same_v<dpsg::optional_tuple<char, char, char, char, char,
+                                                  char, char, char, char>::
+                                 mask_type,
+                             std::uint16_t>);
+
+static_assert(std::is_trivially_copyable_v<packed>);
+static_assert(dpsg::is_trivially_relocatable_v<packed>);
+static_assert(!std::is_trivially_copyable_v<record>);
+static_assert(std::is_nothrow_move_constructible_v<record>);
+static_assert(!std::is_copy_constructible_v<
+              dpsg::optional_tuple<std::unique_ptr<int>, int>>);
+static_assert(std::is_move_constructible_v<
+              dpsg::optional_tuple<std::unique_ptr<int>, int>>);
+static_assert(dpsg::is_trivially_relocatable_v<
+              dpsg::optional_tuple<std::unique_ptr<int>, int>>);
+
+static_assert(std::is_same_v<record::element_type<1>, std::string>);
+static_assert(std::is_same_v<decltype(std::declval<record &>().get<name>()),
+                             record::reference<1>>);
+
+TEST(OptionalTuple, PerField) {
+  packed values;
+  ASSERT_FALSE(values.any_engaged());
+  ASSERT_EQ(values.count(), 0U);
+  values.get<0>() = 1;
+  values.get<3>().emplace(4);
+  ASSERT_TRUE(values.has_value<0>());
+  ASSERT_FALSE(values.has_value<1>());
+  ASSERT_EQ(*values.get<0>(), 1);
+  ASSERT_EQ(values.get<3>().value(), 4);
+  ASSERT_THROW((void)values.get<1>().value(), dpsg::bad_optional_access);
+  ASSERT_EQ(values.get<1>().value_or(-1), -1);
+  ASSERT_EQ(values.mask(), 0b1001);
+  ASSERT_EQ(values.count(), 2U);
+
+  values.get<0>().reset();
+  ASSERT_EQ(values.mask(), 0b1000);
+  values.get<3>() = dpsg::nullopt;
+  ASSERT_FALSE(values.any_engaged());
+}
+
+TEST(OptionalTuple, AllEngaged) {
+  packed values{1, 2, 3, 4, 5, 6, 7, dpsg::nullopt};
+  ASSERT_TRUE(values.any_engaged());
+  ASSERT_FALSE(values.all_engaged());
+  ASSERT_EQ(values.count(), 7U);
+  values.get<7>() = 8;
+  ASSERT_TRUE(values.all_engaged());
+  int sum = 0;
+  const packed &view = values;
+  sum += *view.get<0>() + *view.get<1>() + *view.get<2>() + *view.get<3>();
+  sum += *view.get<4>() + *view.get<5>() + *view.get<6>() + *view.get<7>();
+  ASSERT_EQ(sum, 36);
+  values.reset();
+  ASSERT_FALSE(values.any_engaged());
+}
+
+TEST(OptionalTuple, Tags) {
+  record r{std::int64_t{1}, "name", dpsg::nullopt, 'c'};
+  ASSERT_EQ(*r.get<id>(), 1);
+  ASSERT_EQ(r.get<name>()->size(), 4U);
+  ASSERT_FALSE(r.has_value<score>());
+  ASSERT_EQ(*r.get<char>(), 'c');
+  r.get<score>() = 2.5;
+  ASSERT_EQ(r.get<score>().with_value([](double s) { return s * 2; }, 0.0),
+            5.0);
+  ASSERT_TRUE(r.all_engaged());
+
+  const record &view = r;
+  ASSERT_EQ(view.get<name>().value(), "name");
+  ASSERT_EQ(&*view.get<name>(), &*r.get<1>());
+}
+
+TEST(OptionalTuple, CopyAndMove) {
+  {
+    dpsg::optional_tuple<tracked, std::string, tracked> a{
+        tracked{1}, std::string(40, 'a'), dpsg::nullopt};
+    ASSERT_EQ(tracked::live, 1);
+    auto b = a;
+    ASSERT_EQ(tracked::live, 2);
+    ASSERT_EQ(*b.get<1>(), std::string(40, 'a'));
+    ASSERT_FALSE(b.has_value<2>());
+
+    b.get<2>().emplace(3);
+    b.get<0>().reset();
+    a = b;
+    ASSERT_EQ(tracked::live, 2);
+    ASSERT_FALSE(a.has_value<0>());
+    ASSERT_EQ(a.get<2>()->value, 3);
+
+    auto c = std::move(a);
+    ASSERT_EQ(*c.get<1>(), std::string(40, 'a'));
+    a = std::move(b);
+    ASSERT_EQ(a.get<2>()->value, 3);
+    // Moved from, but still engaged
+    ASSERT_TRUE(b.has_value<2>());
+    ASSERT_EQ(tracked::live, 3);
+    c.reset();
+    ASSERT_EQ(tracked::live, 2);
+  }
+  ASSERT_EQ(tracked::live, 0);
+}
+
+TEST(OptionalTuple, ThrowingCopy) {
+  {
+    dpsg::optional_tuple<tracked, tracked, tracked> a{
+        tracked{1}, tracked{2, true}, tracked{3}};
+    ASSERT_EQ(tracked::live, 3);
+    ASSERT_THROW(auto b = a, std::runtime_error);
+    ASSERT_EQ(tracked::live, 3);
+    const tracked poisoned{4, true};
+    using tuple = dpsg::optional_tuple<tracked, tracked>;
+    ASSERT_THROW((tuple{tracked{5}, poisoned}), std::runtime_error);
+    ASSERT_EQ(tracked::live, 4);
+  }
+  ASSERT_EQ(tracked::live, 0);
+}
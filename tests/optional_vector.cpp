@@ -0,0 +1,300 @@
+#include "optional_vector.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+constexpr static inline int fourty_two = 42;
+constexpr static inline const char *hello_world = "Hello World!";
+
+TEST(OptionalVector, PushBackAndAccess) {
+  dpsg::optional_vector<double> v;
+  ASSERT_TRUE(v.empty());
+  v.push_back(1.5);
+  v.push_back(dpsg::nullopt);
+  v.emplace_back(2.5);
+  ASSERT_EQ(v.size(), 3);
+  ASSERT_EQ(v.count(), 2);
+  ASSERT_TRUE(v[0].has_value());
+  ASSERT_FALSE(v[1].has_value());
+  ASSERT_TRUE(v.has_value(2));
+  ASSERT_EQ(*v[0], 1.5);
+  ASSERT_EQ(v[2].value(), 2.5);
+  ASSERT_THROW(v[1].value(), dpsg::bad_optional_access); // NOLINT
+  ASSERT_EQ(v[1].value_or(0.0), 0.0);
+  ASSERT_THROW((void)v.at(3), std::out_of_range); // NOLINT
+}
+
+TEST(OptionalVector, ElementCost) {
+  dpsg::optional_vector<double> v;
+  v.reserve(1024);
+  ASSERT_EQ(v.capacity(), 1024);
+  for (int i = 0; i < 1024; ++i) {
+    v.push_back(i);
+  }
+  ASSERT_EQ(v.capacity(), 1024);
+  ASSERT_EQ(static_cast<const void *>(v.data() + 1),
+            static_cast<const void *>(&*v[1]));
+}
+
+TEST(OptionalVector, ProxyAssignment) {
+  dpsg::optional_vector<string> v(3);
+  ASSERT_EQ(v.count(), 0);
+  v[1] = hello_world;
+  ASSERT_TRUE(v[1].has_value());
+  ASSERT_EQ(*v[1], hello_world);
+  v[0] = v[1];
+  ASSERT_EQ(*v[0], hello_world);
+  v[1] = dpsg::nullopt;
+  ASSERT_FALSE(v[1].has_value());
+  v[2].emplace(hello_world, static_cast<size_t>(5));
+  ASSERT_EQ(*v[2], "Hello");
+  ASSERT_EQ(v[2]->size(), 5);
+
+  // Temporary proxies do not move from the element
+  string s = *v[0];
+  ASSERT_EQ(*v[0], hello_world);
+  ASSERT_EQ(s, hello_world);
+
+  dpsg::optional<string> o = v[0];
+  ASSERT_TRUE(o.has_value());
+  ASSERT_EQ(*o, hello_world);
+  dpsg::optional<string> o2 = v[1];
+  ASSERT_FALSE(o2.has_value());
+}
+
+TEST(OptionalVector, Resize) {
+  dpsg::optional_vector<int> v;
+  v.resize(100);
+  ASSERT_EQ(v.size(), 100);
+  ASSERT_EQ(v.count(), 0);
+  v.resize(150, fourty_two);
+  ASSERT_EQ(v.count(), 50);
+  ASSERT_EQ(*v[149], fourty_two);
+  v.resize(120);
+  ASSERT_EQ(v.count(), 20);
+  v.resize(200);
+  ASSERT_EQ(v.count(), 20);
+  ASSERT_FALSE(v[150].has_value());
+}
+
+TEST(OptionalVector, Erase) {
+  dpsg::optional_vector<string> v;
+  for (int i = 0; i < 130; ++i) {
+    if (i % 3 == 0) {
+      v.push_back(dpsg::nullopt);
+    } else {
+      v.push_back(to_string(i));
+    }
+  }
+  auto it = v.erase(v.begin() + 1, v.begin() + 70);
+  ASSERT_EQ(it - v.begin(), 1);
+  ASSERT_EQ(v.size(), 61);
+  for (size_t i = 1; i < v.size(); ++i) {
+    const size_t original = i + 69;
+    ASSERT_EQ(v[i].has_value(), original % 3 != 0);
+    if (original % 3 != 0) {
+      ASSERT_EQ(*v[i], to_string(original));
+    }
+  }
+  v.erase(v.begin());
+  ASSERT_EQ(v.size(), 60);
+  ASSERT_EQ(*v[0], "70");
+
+  dpsg::optional_vector<int> vi{1, 2, 3, 4};
+  vi[1] = dpsg::nullopt;
+  vi.erase(vi.begin());
+  ASSERT_EQ(vi.size(), 3);
+  ASSERT_FALSE(vi[0].has_value());
+  ASSERT_EQ(*vi[1], 3);
+  ASSERT_EQ(vi.count(), 2);
+}
+
+TEST(OptionalVector, CopyAndMove) {
+  dpsg::optional_vector<string> v;
+  for (int i = 0; i < 200; ++i) {
+    if (i % 2 == 0) {
+      v.push_back(to_string(i));
+    } else {
+      v.push_back(dpsg::nullopt);
+    }
+  }
+  auto cpy = v;
+  ASSERT_EQ(cpy.size(), v.size());
+  ASSERT_EQ(cpy.count(), 100);
+  ASSERT_EQ(*cpy[198], "198");
+  auto moved = std::move(cpy);
+  ASSERT_EQ(moved.size(), 200);
+  ASSERT_TRUE(cpy.empty()); // NOLINT intentional
+  moved.pop_back();
+  moved.pop_back();
+  ASSERT_EQ(moved.count(), 99);
+  v = moved;
+  ASSERT_EQ(v.size(), 198);
+}
+
+TEST(OptionalVector, Iteration) {
+  dpsg::optional_vector<int> v{3, 1, 2};
+  v.push_back(dpsg::nullopt);
+  int sum = 0;
+  for (auto e : v) {
+    e.with_value([&sum](int i) { sum += i; });
+  }
+  ASSERT_EQ(sum, 6);
+  const auto &cv = v;
+  ASSERT_EQ(std::count_if(cv.begin(), cv.end(),
+                          [](auto e) { return e.has_value(); }),
+            3);
+  std::reverse(v.begin(), v.end());
+  ASSERT_FALSE(v[0].has_value());
+  ASSERT_EQ(*v[1], 2);
+  ASSERT_EQ(*v[2], 1);
+  ASSERT_EQ(*v[3], 3);
+}
+
+namespace {
+// Not nothrow movable, so reallocation copies; copies throw on demand
+struct fragile {
+  static inline std::set<const fragile *> live;
+  static inline int copies_left = -1;
+  int value;
+
+  explicit fragile(int v) : value(v) { live.insert(this); }
+  fragile(const fragile &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+    live.insert(this);
+  }
+  fragile(fragile &&other) : value(other.value) { // NOLINT
+    live.insert(this);
+  }
+  fragile &operator=(const fragile &) = default;
+  ~fragile() { EXPECT_EQ(live.erase(this), 1U); }
+};
+} // namespace
+
+TEST(OptionalVector, ThrowingReallocation) {
+  {
+    dpsg::optional_vector<fragile> v;
+    v.reserve(4);
+    for (int i = 0; i < 4; ++i) {
+      v.emplace_back(i);
+    }
+    v.push_back(dpsg::nullopt);
+    v.emplace_back(5);
+    ASSERT_EQ(fragile::live.size(), 5U);
+
+    fragile::copies_left = 3;
+    ASSERT_THROW(v.reserve(256), std::runtime_error);
+    ASSERT_EQ(fragile::live.size(), 5U);
+    ASSERT_EQ(v.size(), 6);
+    ASSERT_EQ(v[3]->value, 3);
+    ASSERT_FALSE(v[4].has_value());
+
+    fragile::copies_left = -1;
+    v.reserve(256);
+    ASSERT_EQ(fragile::live.size(), 5U);
+    ASSERT_EQ(v[5]->value, 5);
+  }
+  ASSERT_EQ(fragile::live.size(), 0U);
+}
+
+// The argument may be an element, which reallocation moves
+TEST(OptionalVector, PushBackOwnElement) {
+  const string text(100, 'x');
+  dpsg::optional_vector<string> v;
+  v.push_back(text);
+  while (v.size() < v.capacity()) {
+    v.push_back(dpsg::nullopt);
+  }
+  const string &first = *v[0];
+  v.push_back(first);
+  ASSERT_EQ(*v.back(), text);
+  ASSERT_EQ(*v[0], text);
+
+  dpsg::optional_vector<string> w;
+  w.push_back(text);
+  w.resize(w.capacity() + 1, *w[0]);
+  ASSERT_EQ(*w.back(), text);
+}
+
+namespace {
+std::map<const void *, int> arena_owners;
+
+// Stateful allocator that does not propagate, and checks that blocks are
+// freed by an allocator equal to the one that allocated them
+template <class T> struct arena_allocator {
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_swap = std::false_type;
+  using is_always_equal = std::false_type;
+
+  int arena;
+
+  explicit arena_allocator(int a) noexcept : arena(a) {}
+  template <class U>
+  // NOLINTNEXTLINE
+  arena_allocator(const arena_allocator<U> &other) noexcept
+      : arena(other.arena) {}
+
+  T *allocate(std::size_t n) {
+    T *result = std::allocator<T>{}.allocate(n);
+    arena_owners[result] = arena;
+    return result;
+  }
+  void deallocate(T *p, std::size_t n) noexcept {
+    EXPECT_EQ(arena_owners[p], arena);
+    arena_owners.erase(p);
+    std::allocator<T>{}.deallocate(p, n);
+  }
+
+  template <class U>
+  friend bool operator==(const arena_allocator &lhv,
+                         const arena_allocator<U> &rhv) noexcept {
+    return lhv.arena == rhv.arena;
+  }
+  template <class U>
+  friend bool operator!=(const arena_allocator &lhv,
+                         const arena_allocator<U> &rhv) noexcept {
+    return lhv.arena != rhv.arena;
+  }
+};
+} // namespace
+
+TEST(OptionalVector, NonPropagatingAllocator) {
+  using arena_vector =
+      dpsg::optional_vector<string, dpsg::access::extended,
+                            arena_allocator<string>>;
+  {
+    arena_vector a{arena_allocator<string>{1}};
+    arena_vector b{arena_allocator<string>{2}};
+    a.push_back(hello_world);
+    b.push_back(dpsg::nullopt);
+    b.push_back("b");
+
+    a = std::move(b);
+    ASSERT_EQ(a.get_allocator().arena, 1);
+    ASSERT_EQ(a.size(), 2);
+    ASSERT_FALSE(a[0].has_value());
+    ASSERT_EQ(*a[1], "b");
+
+    arena_vector c{arena_allocator<string>{1}};
+    c.push_back("c");
+    a = std::move(c);
+    ASSERT_EQ(*a[0], "c");
+    ASSERT_TRUE(c.empty()); // NOLINT(bugprone-use-after-move)
+
+    b = a;
+    ASSERT_EQ(b.get_allocator().arena, 2);
+    ASSERT_EQ(*b[0], "c");
+  }
+  ASSERT_TRUE(arena_owners.empty());
+}
@@ -0,0 +1,141 @@
+#include "pooled_storage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <utility>
+
+struct big_config {
+  std::string name;
+  std::array<int, 512> values{};
+
+  static inline int live = 0;
+
+  explicit big_config(std::string n) : name{std::move(n)} { ++live; }
+  big_config(const big_config &other) : name{other.name}, values{other.values} {
+    ++live;
+  }
+  big_config(big_config &&other) noexcept
+      : name{std::move(other.name)}, values{other.values} {
+    ++live;
+  }
+  big_config &operator=(const big_config &) = default;
+  big_config &operator=(big_config &&) = default;
+  ~big_config() { --live; }
+};
+
+using opooled = dpsg::optional_pooled<big_config>;
+using obool_pooled = dpsg::generalized_optional<
+    big_config, dpsg::policy<dpsg::access::extended,
+                             dpsg::control::dependent_bool,
+                             dpsg::storage::pooled<>>>;
+
+std::size_t allocations = 0;
+std::pmr::memory_resource *counting_resource() noexcept {
+  struct counting : std::pmr::memory_resource {
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+      ++allocations;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes,
+                       std::size_t alignment) override {
+      --allocations;
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    [[nodiscard]] bool do_is_equal(
+        const std::pmr::memory_resource &other) const noexcept override {
+      return this == &other;
+    }
+  };
+  static counting resource;
+  return &resource;
+}
+
+static_assert(sizeof(opooled) == sizeof(void *));
+static_assert(
+    sizeof(dpsg::optional_pooled<int, dpsg::pool::memory_resource<>>) ==
+    sizeof(void *));
+static_assert(!std::is_trivially_copyable_v<dpsg::optional_pooled<int>>);
+static_assert(std::is_nothrow_move_constructible_v<opooled>);
+
+TEST(Pooled, Lifetime) {
+  {
+    opooled o;
+    ASSERT_FALSE(o.has_value());
+    o.emplace("first");
+    ASSERT_TRUE(o.has_value());
+    ASSERT_EQ(o->name, "first");
+    ASSERT_EQ(big_config::live, 1);
+    o = big_config{"second"};
+    ASSERT_EQ(o->name, "second");
+    ASSERT_EQ(big_config::live, 1);
+
+    opooled cpy{o};
+    ASSERT_EQ(cpy->name, "second");
+    ASSERT_NE(&*cpy, &*o);
+    ASSERT_EQ(big_config::live, 2);
+
+    const auto *address = &*cpy;
+    opooled moved{std::move(cpy)};
+    ASSERT_EQ(&*moved, address);
+    ASSERT_FALSE(cpy.has_value()); // NOLINT(bugprone-use-after-move)
+    ASSERT_EQ(big_config::live, 2);
+
+    o = std::move(moved);
+    ASSERT_EQ(&*o, address);
+    ASSERT_EQ(big_config::live, 1);
+
+    cpy = o;
+    ASSERT_EQ(big_config::live, 2);
+    cpy.swap(moved);
+    ASSERT_FALSE(cpy.has_value());
+    ASSERT_EQ(moved->name, "second");
+    moved.reset();
+    ASSERT_EQ(big_config::live, 1);
+    o = dpsg::nullopt;
+    ASSERT_EQ(big_config::live, 0);
+    o.emplace("third");
+  }
+  ASSERT_EQ(big_config::live, 0);
+}
+
+TEST(Pooled, FreelistReuse) {
+  opooled o{big_config{"reused"}};
+  const auto *address = &*o;
+  o.reset();
+  o.emplace("again");
+  ASSERT_EQ(&*o, address);
+  std::thread{[address] {
+    opooled other{big_config{"other thread"}};
+    ASSERT_NE(&*other, address);
+  }}.join();
+}
+
+TEST(Pooled, WithDependentBool) {
+  obool_pooled o{big_config{"flagged"}};
+  obool_pooled cpy{o};
+  obool_pooled moved{std::move(cpy)};
+  ASSERT_EQ(moved->name, "flagged");
+  o.reset();
+  ASSERT_FALSE(o.has_value());
+  o = moved;
+  ASSERT_EQ(o->name, "flagged");
+}
+
+TEST(Pooled, MemoryResource) {
+  using ores = dpsg::optional_pooled<
+      std::string, dpsg::pool::memory_resource<&counting_resource>>;
+  {
+    ores o{"Hello World!"};
+    ASSERT_EQ(allocations, 1);
+    ores cpy{o};
+    ASSERT_EQ(allocations, 2);
+    ASSERT_EQ(*cpy, "Hello World!");
+    o.reset();
+    ASSERT_EQ(allocations, 1);
+  }
+  ASSERT_EQ(allocations, 0);
+}
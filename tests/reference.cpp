@@ -0,0 +1,183 @@
+#include "generalized_optional.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace {
+template <class T, class Access>
+using reference = dpsg::generalized_optional<
+    T &, dpsg::policy<Access, dpsg::control::from_storage,
+                      dpsg::storage::reference>>;
+
+struct record {
+  int id;
+  char payload[196];
+};
+
+struct animal {
+  int legs = 4;
+};
+struct bird : animal {
+  bird() { legs = 2; }
+};
+
+// Maybe a reference into the table, rather than a copy of the record
+dpsg::optional_ref<const record> find(const std::array<record, 4> &table,
+                                      int id) {
+  for (const auto &r : table) {
+    if (r.id == id) {
+      return r;
+    }
+  }
+  return dpsg::nullopt;
+}
+
+constexpr static int answer = 42;
+constexpr dpsg::optional_ref<const int> to_answer{answer};
+} // namespace
+
+static_assert(sizeof(dpsg::optional_ref<record>) == sizeof(record *));
+static_assert(std::is_trivially_copyable_v<dpsg::optional_ref<std::string>>);
+static_assert(dpsg::is_trivially_relocatable_v<dpsg::optional_ref<int>>);
+static_assert(std::is_same_v<dpsg::optional_ref<int>::value_type, int &>);
+
+// Never bound to a temporary
+static_assert(std::is_constructible_v<dpsg::optional_ref<const int>, int &>);
+static_assert(!std::is_constructible_v<dpsg::optional_ref<const int>, int>);
+static_assert(!std::is_constructible_v<dpsg::optional_ref<const int>, long &>);
+static_assert(!std::is_constructible_v<dpsg::optional_ref<int>, const int &>);
+static_assert(!std::is_assignable_v<dpsg::optional_ref<const int> &, int>);
+static_assert(!std::is_constructible_v<dpsg::optional_ref<const int>,
+                                       dpsg::optional<int> &&>);
+static_assert(!std::is_assignable_v<dpsg::optional_ref<const int> &,
+                                    dpsg::optional<int> &&>);
+static_assert(std::is_constructible_v<dpsg::optional_ref<const int>,
+                                      dpsg::optional<int> &>);
+static_assert(std::is_constructible_v<dpsg::optional_ref<const animal>,
+                                      dpsg::optional_ref<bird> &&>);
+static_assert(std::is_convertible_v<bird &, dpsg::optional_ref<animal>>);
+static_assert(std::is_convertible_v<dpsg::optional_ref<bird>,
+                                    dpsg::optional_ref<const animal>>);
+
+// Moving the optional does not move the referred object
+static_assert(
+    std::is_same_v<decltype(*std::declval<dpsg::optional_ref<int>>()), int &>);
+static_assert(std::is_same_v<decltype(std::declval<dpsg::optional_ref<int>>()
+                                          .value()),
+                             int &>);
+static_assert(std::is_same_v<decltype(std::declval<dpsg::optional_ref<int>>()
+                                          .value_or(0)),
+                             int>);
+
+static_assert(to_answer.has_value() && *to_answer == 42);
+static_assert(&to_answer.value() == &answer);
+static_assert(!dpsg::optional_ref<const int>{}.has_value());
+
+TEST(Reference, Lookup) {
+  std::array<record, 4> table{};
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    table[i].id = static_cast<int>(i) * 10;
+  }
+  const auto found = find(table, 20);
+  ASSERT_TRUE(found.has_value());
+  ASSERT_EQ(&*found, &table[2]);
+  ASSERT_EQ(found->id, 20);
+  ASSERT_EQ(found.with_value([](const record &r) { return r.id; }, -1), 20);
+
+  const auto missing = find(table, 25);
+  ASSERT_FALSE(missing);
+  ASSERT_THROW((void)missing.value(), dpsg::bad_optional_access);
+  ASSERT_EQ(missing.with_value([](const record &r) { return r.id; }, -1), -1);
+  ASSERT_EQ(missing.value_or(table[3]).id, 30);
+}
+
+TEST(Reference, Rebind) {
+  int a = 1;
+  int b = 2;
+  dpsg::optional_ref<int> ref{a};
+  ref = b;
+  ASSERT_EQ(a, 1);
+  ASSERT_EQ(&*ref, &b);
+  *ref = 3;
+  ASSERT_EQ(b, 3);
+
+  dpsg::optional_ref<int> other{a};
+  ref = other;
+  ASSERT_EQ(&*ref, &a);
+  ASSERT_EQ(b, 3);
+  ASSERT_EQ(&ref.emplace(b), &b);
+  ref = std::move(other);
+  ASSERT_EQ(&*ref, &a);
+  ASSERT_EQ(&*other, &a);
+
+  ref = dpsg::nullopt;
+  ASSERT_FALSE(ref.has_value());
+  ref = b;
+  ASSERT_EQ(*ref, 3);
+  ref.reset();
+  ASSERT_EQ(ref.value_or(4), 4);
+
+  swap(ref, other);
+  ASSERT_EQ(&*ref, &a);
+  ASSERT_FALSE(other.has_value());
+}
+
+TEST(Reference, Conversions) {
+  bird tweety;
+  dpsg::optional_ref<bird> to_bird{tweety};
+  dpsg::optional_ref<const animal> to_animal = to_bird;
+  ASSERT_EQ(&*to_animal, &tweety);
+  ASSERT_EQ(to_animal->legs, 2);
+
+  dpsg::optional_ref<animal> empty = dpsg::optional_ref<bird>{};
+  ASSERT_FALSE(empty.has_value());
+  empty = to_bird;
+  ASSERT_EQ(empty->legs, 2);
+
+  // Constness is shallow, as for a pointer
+  const dpsg::optional_ref<animal> fixed{tweety};
+  fixed->legs = 1;
+  ASSERT_EQ(tweety.legs, 1);
+
+  int a = 1;
+  dpsg::optional_ref<int> from_call{dpsg::from_invoke,
+                                    [&]() -> int & { return a; }};
+  ASSERT_EQ(&*from_call, &a);
+}
+
+TEST(Reference, AccessPolicies) {
+  std::string text = "text";
+  reference<std::string, dpsg::access::unchecked> unchecked{text};
+  ASSERT_EQ(unchecked->size(), 4U);
+  ASSERT_EQ(&std::move(unchecked).value(), &text);
+
+  reference<std::string, dpsg::access::throw_exception> throwing;
+  ASSERT_THROW((void)throwing->size(), dpsg::bad_optional_access);
+  throwing = text;
+  ASSERT_EQ(*throwing, "text");
+
+  reference<std::string, dpsg::access::extended_checked_in_debug> checked{
+      text};
+  std::move(checked).with_value([](std::string &s) { s += "!"; });
+  ASSERT_EQ(text, "text!");
+  ASSERT_EQ(checked.value().size(), 5U);
+}
+
+TEST(Reference, Comparisons) {
+  int a = 1;
+  int b = 1;
+  dpsg::optional_ref<int> ref_a{a};
+  dpsg::optional_ref<int> ref_b{b};
+  dpsg::optional_ref<int> empty;
+  // The referred values are compared, as with std::optional
+  ASSERT_TRUE(ref_a == ref_b);
+  ASSERT_TRUE(ref_a == 1);
+  ASSERT_TRUE(empty < ref_a);
+  ASSERT_EQ(std::hash<dpsg::optional_ref<int>>{}(ref_a), std::hash<int>{}(1));
+}
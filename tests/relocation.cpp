@@ -0,0 +1,163 @@
+#include "flat_map.hpp"
+#include "generalized_optional.hpp"
+#include "optional_vector.hpp"
+#include "pooled_storage.hpp"
+#include "small_buffer_storage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+// Owns a heap block, and counts its moves: relocations must not call them
+struct boxed {
+  static inline int moves = 0;
+
+  explicit boxed(int v) : value(std::make_unique<int>(v)) {}
+  boxed(boxed &&other) noexcept : value(std::move(other.value)) { ++moves; }
+  boxed &operator=(boxed &&other) noexcept {
+    value = std::move(other.value);
+    ++moves;
+    return *this;
+  }
+  ~boxed() = default;
+
+  std::unique_ptr<int> value;
+};
+
+// Same, without opting in
+struct pinned_boxed : boxed {
+  using boxed::boxed;
+};
+} // namespace
+
+template <> struct dpsg::is_trivially_relocatable<boxed> : std::true_type {};
+
+namespace {
+using pooled_string = dpsg::optional_pooled<std::string>;
+} // namespace
+
+static_assert(dpsg::is_trivially_relocatable_v<int>);
+static_assert(dpsg::is_trivially_relocatable_v<std::unique_ptr<int>>);
+static_assert(!dpsg::is_trivially_relocatable_v<pinned_boxed>);
+static_assert(dpsg::is_trivially_relocatable_v<dpsg::optional<boxed>>);
+static_assert(!dpsg::is_trivially_relocatable_v<dpsg::optional<pinned_boxed>>);
+static_assert(dpsg::is_trivially_relocatable_v<dpsg::optional_tombstone<int>>);
+static_assert(!dpsg::is_trivially_relocatable_v<dpsg::optional_small<
+                  std::string, sizeof(std::string)>>);
+// Stored out of line, whatever the payload
+static_assert(
+    dpsg::is_trivially_relocatable_v<dpsg::optional_small<std::string, 8>>);
+static_assert(dpsg::is_trivially_relocatable_v<pooled_string>);
+static_assert(std::is_nothrow_swappable_v<dpsg::optional<boxed>>);
+
+TEST(Relocation, RelocateAt) {
+  alignas(boxed) unsigned char raw[sizeof(boxed)];
+  auto *src = new boxed{3}; // NOLINT
+  boxed::moves = 0;
+  boxed *dst = dpsg::relocate_at(src, reinterpret_cast<boxed *>(raw));
+  ::operator delete(src);
+  ASSERT_EQ(*dst->value, 3);
+  ASSERT_EQ(boxed::moves, 0);
+  dst->~boxed();
+
+  alignas(pinned_boxed) unsigned char other[sizeof(pinned_boxed)];
+  auto *pinned = new pinned_boxed{4}; // NOLINT
+  pinned_boxed *moved = dpsg::relocate_at(
+      pinned, reinterpret_cast<pinned_boxed *>(other)); // NOLINT
+  ::operator delete(pinned);
+  ASSERT_EQ(*moved->value, 4);
+  ASSERT_EQ(boxed::moves, 1);
+  moved->~pinned_boxed();
+}
+
+TEST(Relocation, UninitializedRelocate) {
+  std::allocator<dpsg::optional<boxed>> alloc;
+  auto *first = alloc.allocate(3);
+  auto *second = alloc.allocate(3);
+  ::new (first) dpsg::optional<boxed>{dpsg::in_place, 1};
+  ::new (first + 1) dpsg::optional<boxed>{};
+  ::new (first + 2) dpsg::optional<boxed>{dpsg::in_place, 3};
+  boxed::moves = 0;
+  ASSERT_EQ(dpsg::uninitialized_relocate(first, first + 3, second),
+            second + 3);
+  ASSERT_EQ(boxed::moves, 0);
+  ASSERT_EQ(*second[0]->value, 1);
+  ASSERT_FALSE(second[1].has_value());
+  ASSERT_EQ(*second[2]->value, 3);
+  std::destroy(second, second + 3);
+  alloc.deallocate(first, 3);
+  alloc.deallocate(second, 3);
+}
+
+template <class O, class Make> void check_swap(Make make) {
+  O a{make(1)};
+  O b{make(2)};
+  O empty;
+  a.swap(b);
+  ASSERT_EQ(*a, make(2));
+  ASSERT_EQ(*b, make(1));
+  swap(a, empty);
+  ASSERT_FALSE(a.has_value());
+  ASSERT_EQ(*empty, make(2));
+  a.swap(a);
+  ASSERT_FALSE(a.has_value());
+  empty.swap(empty);
+  ASSERT_EQ(*empty, make(2));
+}
+
+TEST(Relocation, Swap) {
+  const auto number = [](int i) { return i; };
+  const auto text = [](int i) { return std::string(40, 'a' + i); };
+  check_swap<dpsg::optional<int>>(number);
+  check_swap<dpsg::optional_tombstone<int>>(number);
+  check_swap<dpsg::optional<std::string>>(text);
+  check_swap<dpsg::optional_small<std::string, 8>>(text);
+  check_swap<pooled_string>(text);
+
+  dpsg::optional<boxed> a{dpsg::in_place, 1};
+  dpsg::optional<boxed> b;
+  boxed::moves = 0;
+  swap(a, b);
+  ASSERT_EQ(boxed::moves, 0);
+  ASSERT_FALSE(a.has_value());
+  ASSERT_EQ(*b->value, 1);
+}
+
+TEST(Relocation, OptionalVector) {
+  dpsg::optional_vector<boxed> vec;
+  boxed::moves = 0;
+  for (int i = 0; i < 1000; ++i) {
+    if (i % 3 == 0) {
+      vec.push_back(dpsg::nullopt);
+    } else {
+      vec.emplace_back(i);
+    }
+  }
+  vec.erase(vec.begin() + 10, vec.begin() + 20);
+  ASSERT_EQ(boxed::moves, 0);
+  ASSERT_EQ(vec.size(), 990U);
+  for (std::size_t i = 0; i < vec.size(); ++i) {
+    const std::size_t original = i < 10 ? i : i + 10;
+    ASSERT_EQ(vec[i].has_value(), original % 3 != 0);
+    if (vec[i].has_value()) {
+      ASSERT_EQ(*vec[i]->value, static_cast<int>(original));
+    }
+  }
+}
+
+TEST(Relocation, FlatMap) {
+  dpsg::flat_map<std::int32_t, boxed> map;
+  boxed::moves = 0;
+  for (int i = 0; i < 1000; ++i) {
+    map.try_emplace(i, i);
+  }
+  ASSERT_EQ(boxed::moves, 0);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(*map.at(i).value, i);
+  }
+}
@@ -0,0 +1,140 @@
+#include "small_buffer_storage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace {
+struct counted {
+  static inline int live = 0;
+  int value;
+
+  explicit counted(int v) noexcept : value{v} { ++live; }
+  counted(const counted &other) noexcept : value{other.value} { ++live; }
+  counted(counted &&other) noexcept : value{other.value} { ++live; }
+  counted &operator=(const counted &) = default;
+  counted &operator=(counted &&) = default;
+  ~counted() { --live; }
+};
+
+struct large_state {
+  std::array<int, 64> values{};
+  explicit large_state(int v) noexcept { values.fill(v); }
+};
+
+// Small, but moving it may throw
+struct throwing_move {
+  int value;
+  explicit throwing_move(int v) : value{v} {}
+  throwing_move(const throwing_move &) = default;
+  throwing_move(throwing_move &&other) noexcept(false) : value{other.value} {}
+  throwing_move &operator=(const throwing_move &) = default;
+  throwing_move &operator=(throwing_move &&) = default;
+  ~throwing_move() = default;
+};
+
+using buffer = dpsg::storage::small_buffer<32>;
+template <class T> using osmall = dpsg::optional_small<T, 32>;
+} // namespace
+
+static_assert(buffer::stores_inline<int>);
+static_assert(buffer::stores_inline<counted>);
+static_assert(buffer::stores_inline<std::unique_ptr<int>>);
+static_assert(!buffer::stores_inline<large_state>);
+static_assert(!buffer::stores_inline<throwing_move>);
+
+// Same footprint whatever the payload
+static_assert(sizeof(osmall<int>) == sizeof(osmall<large_state>));
+static_assert(sizeof(osmall<int>) == sizeof(osmall<throwing_move>));
+static_assert(sizeof(osmall<int>) == sizeof(osmall<std::string>));
+
+static_assert(std::is_trivially_copyable_v<osmall<int>>);
+static_assert(!std::is_trivially_copyable_v<osmall<large_state>>);
+static_assert(std::is_nothrow_move_constructible_v<osmall<large_state>>);
+
+TEST(SmallBuffer, Inline) {
+  {
+    osmall<counted> o;
+    ASSERT_FALSE(o.has_value());
+    o.emplace(1);
+    ASSERT_TRUE(o.has_value());
+    ASSERT_EQ(o->value, 1);
+    auto *address = reinterpret_cast<const unsigned char *>(&*o); // NOLINT
+    auto *begin = reinterpret_cast<const unsigned char *>(&o);    // NOLINT
+    ASSERT_GE(address, begin);
+    ASSERT_LT(address, begin + sizeof(o));
+
+    osmall<counted> cpy{o};
+    ASSERT_EQ(cpy->value, 1);
+    ASSERT_EQ(counted::live, 2);
+    o.reset();
+    ASSERT_EQ(counted::live, 1);
+    o = std::move(cpy);
+    ASSERT_EQ(o->value, 1);
+  }
+  ASSERT_EQ(counted::live, 0);
+}
+
+TEST(SmallBuffer, Heap) {
+  osmall<large_state> o{large_state{3}};
+  ASSERT_TRUE(o.has_value());
+  ASSERT_EQ(o->values.back(), 3);
+  auto *address = reinterpret_cast<const unsigned char *>(&*o); // NOLINT
+  auto *begin = reinterpret_cast<const unsigned char *>(&o);    // NOLINT
+  ASSERT_TRUE(address < begin || address >= begin + sizeof(o));
+
+  osmall<large_state> cpy{o};
+  ASSERT_NE(&*cpy, &*o);
+  ASSERT_EQ(cpy->values.front(), 3);
+
+  // Moves hand the block over
+  const large_state *block = &*cpy;
+  osmall<large_state> moved{std::move(cpy)};
+  ASSERT_EQ(&*moved, block);
+  ASSERT_FALSE(cpy.has_value()); // NOLINT(bugprone-use-after-move)
+
+  o = std::move(moved);
+  ASSERT_EQ(&*o, block);
+  ASSERT_FALSE(moved.has_value()); // NOLINT(bugprone-use-after-move)
+
+  o.reset();
+  ASSERT_FALSE(o.has_value());
+  o.emplace(4);
+  ASSERT_EQ(o->values.front(), 4);
+}
+
+TEST(SmallBuffer, ThrowingMoveGoesToTheHeap) {
+  osmall<throwing_move> o{throwing_move{5}};
+  osmall<throwing_move> cpy = o;
+  ASSERT_EQ(cpy->value, 5);
+  const throwing_move *block = &*cpy;
+  osmall<throwing_move> moved{std::move(cpy)};
+  ASSERT_EQ(&*moved, block);
+}
+
+TEST(SmallBuffer, MoveOnly) {
+  osmall<std::unique_ptr<int>> o{std::make_unique<int>(6)};
+  osmall<std::unique_ptr<int>> moved{std::move(o)};
+  ASSERT_EQ(**moved, 6);
+}
+
+// Moved-from optionals are empty when heap backed, engaged when inline
+TEST(SmallBuffer, MovedFrom) {
+  osmall<std::unique_ptr<int>> small{std::make_unique<int>(7)};
+  osmall<std::unique_ptr<int>> small_moved{std::move(small)};
+  ASSERT_TRUE(small.has_value()); // NOLINT(bugprone-use-after-move)
+  ASSERT_EQ(*small, nullptr);
+  small = std::move(small_moved);
+  ASSERT_TRUE(small_moved.has_value()); // NOLINT(bugprone-use-after-move)
+  ASSERT_EQ(**small, 7);
+
+  osmall<large_state> large{large_state{8}};
+  osmall<large_state> large_moved{std::move(large)};
+  ASSERT_FALSE(large.has_value()); // NOLINT(bugprone-use-after-move)
+  large = std::move(large_moved);
+  ASSERT_FALSE(large_moved.has_value()); // NOLINT(bugprone-use-after-move)
+  ASSERT_EQ(large->values.front(), 8);
+}
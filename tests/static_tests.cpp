@@ -1,4 +1,5 @@
 #include "generalized_optional.hpp"
+#include <cstdint>
 #include <limits>
 #include <string>
 #include <type_traits>
@@ -35,4 +36,72 @@ static_assert(dtv<unsigned int>::value ==
 constexpr static inline char min_char = -128;
 constexpr static inline unsigned char max_uchar = 255;
 static_assert(dtv<char>::value == min_char);
-static_assert(dtv<unsigned char>::value == max_uchar);
\ No newline at end of file
+static_assert(dtv<unsigned char>::value == max_uchar);
+static_assert(std::is_same_v<std::remove_cv_t<decltype(dtv<double>::value)>,
+                             std::uint64_t>);
+static_assert(std::is_same_v<std::remove_cv_t<decltype(dtv<float>::value)>,
+                             std::uint32_t>);
+template <class T>
+using unchecked_optional = dpsg::generalized_optional<
+    T, dpsg::policy<dpsg::access::unchecked, dpsg::control::dependent_bool,
+                    dpsg::storage::aligned>>;
+
+template <class T> struct test_triviality {
+  constexpr static inline bool trivial = std::is_trivially_copyable_v<T>;
+  static_assert(std::is_trivially_copyable_v<dpsg::optional<T>> == trivial);
+  static_assert(std::is_trivially_copy_constructible_v<dpsg::optional<T>> ==
+                trivial);
+  static_assert(std::is_trivially_move_constructible_v<dpsg::optional<T>> ==
+                trivial);
+  static_assert(std::is_trivially_copy_assignable_v<dpsg::optional<T>> ==
+                trivial);
+  static_assert(std::is_trivially_move_assignable_v<dpsg::optional<T>> ==
+                trivial);
+  static_assert(std::is_trivially_destructible_v<dpsg::optional<T>> ==
+                std::is_trivially_destructible_v<T>);
+  static_assert(std::is_trivially_copyable_v<unchecked_optional<T>> ==
+                trivial);
+  template <class> using type = void;
+};
+
+template <class... Args> struct test_all_triviality;
+template <> struct test_all_triviality<> { using type = void; };
+template <class T, class... Args> struct test_all_triviality<T, Args...> {
+  using type = typename test_triviality<T>::template type<
+      typename test_all_triviality<Args...>::type>;
+};
+
+struct trivial_aggregate {
+  int i;
+  double d;
+};
+
+static_assert(
+    std::is_same_v<typename test_all_triviality<char, int, double, char *,
+                                                trivial_aggregate, string,
+                                                vector<string>>::type,
+                   void>);
+
+static_assert(std::is_trivially_copyable_v<dpsg::optional_tombstone<int>>);
+static_assert(
+    std::is_trivially_copyable_v<dpsg::optional_tombstone<unsigned long>>);
+static_assert(std::is_trivially_copyable_v<dpsg::optional_tombstone<char *>>);
+static_assert(
+    std::is_trivially_destructible_v<dpsg::optional_tombstone<char *>>);
+
+// combine is flattened into the policy chain
+static_assert(std::is_same_v<
+              dpsg::detail::base<dpsg::optional<int>, dpsg::access::extended,
+                                 dpsg::control::dependent_bool,
+                                 dpsg::storage::aligned>,
+              dpsg::detail::base<dpsg::optional<int>, dpsg::access::functional,
+                                 dpsg::access::unchecked_deref,
+                                 dpsg::access::throw_exception_value,
+                                 dpsg::control::dependent_bool,
+                                 dpsg::storage::aligned>>);
+
+static_assert(std::is_nothrow_constructible_v<dpsg::optional<int>, int>);
+static_assert(std::is_nothrow_constructible_v<dpsg::optional<int>,
+                                              dpsg::in_place_t, int>);
+static_assert(
+    !std::is_nothrow_constructible_v<dpsg::optional<string>, const char *>);
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "generalized_optional.hpp"
+
+#include <cstdint>
+
+enum class node_handle : std::uint32_t {};
+
+template <>
+struct dpsg::tag_bits<node_handle> : std::integral_constant<unsigned, 2> {};
+
+struct alignas(8) node {
+  int value;
+};
+
+template <class T> using tg = dpsg::optional_tagged<T>;
+constexpr static inline auto fourty_two = 42;
+
+static_assert(sizeof(tg<node *>) == sizeof(node *));
+static_assert(sizeof(tg<node_handle>) == sizeof(node_handle));
+static_assert(dpsg::tag_bits_v<node *> == 3);
+static_assert(dpsg::tag_bits_v<std::uint64_t *> == 3);
+static_assert(dpsg::tag_bits_v<char *> == 0);
+static_assert(dpsg::tag_bits_v<node_handle> == 2);
+static_assert(std::is_trivially_copyable_v<tg<node *>>);
+
+TEST(Tagged, HoldsNullptr) {
+  tg<node *> empty;
+  ASSERT_FALSE(empty.has_value());
+  tg<node *> null{nullptr};
+  ASSERT_TRUE(null.has_value());
+  ASSERT_EQ(*null, nullptr);
+  null.reset();
+  ASSERT_FALSE(null.has_value());
+}
+
+TEST(Tagged, Pointers) {
+  node n{fourty_two};
+  tg<node *> o{&n};
+  ASSERT_TRUE(o.has_value());
+  ASSERT_EQ(*o, &n);
+  ASSERT_EQ((*o)->value, fourty_two);
+  tg<node *> cpy{o};
+  ASSERT_EQ(cpy.value(), &n);
+  o = dpsg::nullopt;
+  ASSERT_FALSE(o.has_value());
+  ASSERT_EQ(o.value_or(nullptr), nullptr);
+  ASSERT_THROW(o.value(), dpsg::bad_optional_access); // NOLINT
+  o = cpy;
+  ASSERT_EQ(*o, &n);
+  o.emplace(nullptr);
+  ASSERT_TRUE(o.has_value());
+  ASSERT_EQ(*o, nullptr);
+}
+
+TEST(Tagged, Handles) {
+  tg<node_handle> h;
+  ASSERT_FALSE(h.has_value());
+  h = node_handle{0};
+  ASSERT_TRUE(h.has_value());
+  h = node_handle{fourty_two * 4};
+  ASSERT_TRUE(h.has_value());
+  ASSERT_EQ(static_cast<int>(*h), fourty_two * 4);
+  tg<node_handle> h2;
+  h.swap(h2);
+  ASSERT_FALSE(h.has_value());
+  ASSERT_EQ(static_cast<int>(*h2), fourty_two * 4);
+}
@@ -2,8 +2,12 @@
 
 #include "generalized_optional.hpp"
 
+#include <cmath>
+#include <limits>
+
 template <class T> using tsd = dpsg::optional_tombstone<T>;
-template <class T, T V> using ts = dpsg::optional_tombstone<T, V>;
+template <class T, dpsg::detail::tombstone_value_t<T> V>
+using ts = dpsg::optional_tombstone<T, V>;
 constexpr static inline auto fourty_two = 42;
 
 TEST(Tombstone, Ctor) {
@@ -89,4 +93,40 @@ TEST(Tombstone, WithValue) {
   auto f2 = [](int i) { return i * 2; };
   ASSERT_EQ(i1.with_value(f2, -1), -1);
   ASSERT_EQ(i2.with_value(f2, -1), fourty_two * 2);
-}
\ No newline at end of file
+}
+TEST(Tombstone, FloatingPoint) {
+  static_assert(sizeof(tsd<double>) == sizeof(double));
+  static_assert(sizeof(tsd<float>) == sizeof(float));
+  tsd<double> d1;
+  ASSERT_FALSE(d1.has_value());
+  tsd<double> d2{std::numeric_limits<double>::quiet_NaN()};
+  ASSERT_TRUE(d2.has_value());
+  ASSERT_TRUE(std::isnan(*d2));
+  const double zero = 0.0;
+  d1 = zero / zero;
+  ASSERT_TRUE(d1.has_value());
+  d1 = std::numeric_limits<double>::infinity();
+  ASSERT_TRUE(d1.has_value());
+  d1.reset();
+  ASSERT_FALSE(d1.has_value());
+  ASSERT_EQ(d1.value_or(1.5), 1.5);
+
+  tsd<float> f1{42.F};
+  ASSERT_TRUE(f1.has_value());
+  ASSERT_EQ(*f1, 42.F);
+  tsd<float> f2{f1};
+  ASSERT_TRUE(f2.has_value());
+  f1 = tsd<float>{};
+  ASSERT_FALSE(f1.has_value());
+  f1 = std::numeric_limits<float>::signaling_NaN();
+  ASSERT_TRUE(f1.has_value());
+}
+
+TEST(Tombstone, CustomFloatingPointSentinel) {
+  // Empty is represented by negative zero, positive zero is still a value
+  using o = ts<double, 0x8000000000000000>;
+  o d{0.0};
+  ASSERT_TRUE(d.has_value());
+  d = -0.0;
+  ASSERT_FALSE(d.has_value());
+}
@@ -0,0 +1,119 @@
+#include "tombstone_scan.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace scan = dpsg::scan;
+
+template <class T> using tsd = dpsg::optional_tombstone<T>;
+
+constexpr static inline dpsg::scan::isa all_isas[] = {
+    scan::isa::scalar, scan::isa::sse2, scan::isa::avx2, scan::isa::avx512};
+
+template <class T>
+std::vector<tsd<T>> make_column(std::size_t size, int empty_percent,
+                                unsigned seed) {
+  std::mt19937 gen{seed};
+  std::uniform_int_distribution<int> percent{0, 99};
+  std::uniform_int_distribution<int> values{0, 100};
+  std::vector<tsd<T>> result(size);
+  for (auto &o : result) {
+    if (percent(gen) >= empty_percent) {
+      o = static_cast<T>(values(gen));
+    }
+  }
+  return result;
+}
+
+template <class T> void check_column(const std::vector<tsd<T>> &column) {
+  const std::size_t size = column.size();
+  std::size_t engaged = 0;
+  std::size_t first_engaged = size;
+  std::size_t first_empty = size;
+  std::size_t last_engaged = size;
+  std::size_t last_empty = size;
+  for (std::size_t i = 0; i < size; ++i) {
+    if (column[i].has_value()) {
+      ++engaged;
+      first_engaged = first_engaged == size ? i : first_engaged;
+      last_engaged = i;
+    } else {
+      first_empty = first_empty == size ? i : first_empty;
+      last_empty = i;
+    }
+  }
+
+  for (auto target : all_isas) {
+    if (!scan::supports(target)) {
+      continue;
+    }
+    const auto *data = column.data();
+    ASSERT_EQ(scan::count_engaged(target, data, size), engaged);
+    ASSERT_EQ(scan::count_empty(target, data, size), size - engaged);
+    ASSERT_EQ(scan::find_first_engaged(target, data, size), first_engaged);
+    ASSERT_EQ(scan::find_first_empty(target, data, size), first_empty);
+    ASSERT_EQ(scan::find_last_engaged(target, data, size), last_engaged);
+    ASSERT_EQ(scan::find_last_empty(target, data, size), last_empty);
+    ASSERT_EQ(scan::all_engaged(target, data, size), engaged == size);
+    ASSERT_EQ(scan::any_engaged(target, data, size), engaged != 0);
+    ASSERT_EQ(scan::none_engaged(target, data, size), engaged == 0);
+
+    std::vector<T> out(size);
+    scan::value_or(target, data, size, out.data(), T{7});
+    for (std::size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(out[i], column[i].value_or(T{7}));
+    }
+
+    auto cpy = column;
+    scan::replace_sentinel(target, cpy.data(), size, T{9});
+    for (std::size_t i = 0; i < size; ++i) {
+      ASSERT_TRUE(cpy[i].has_value());
+      ASSERT_EQ(*cpy[i], column[i].value_or(T{9}));
+    }
+  }
+}
+
+template <class T> void check_type() {
+  for (std::size_t size : {0, 1, 7, 31, 64, 100, 257, 1000}) {
+    for (int empty_percent : {0, 1, 50, 99, 100}) {
+      check_column(make_column<T>(size, empty_percent,
+                                  static_cast<unsigned>(size) + empty_percent));
+    }
+  }
+}
+
+TEST(TombstoneScan, Int8) { check_type<std::int8_t>(); }
+TEST(TombstoneScan, UInt16) { check_type<std::uint16_t>(); }
+TEST(TombstoneScan, Int32) { check_type<std::int32_t>(); }
+TEST(TombstoneScan, UInt32) { check_type<std::uint32_t>(); }
+TEST(TombstoneScan, Int64) { check_type<std::int64_t>(); }
+TEST(TombstoneScan, UInt64) { check_type<std::uint64_t>(); }
+
+TEST(TombstoneScan, Float) { check_type<float>(); }
+TEST(TombstoneScan, Double) { check_type<double>(); }
+
+TEST(TombstoneScan, CustomSentinel) {
+  using o = dpsg::optional_tombstone<int, 0>;
+  std::vector<o> column(100, o{1});
+  column[42] = o{};
+  ASSERT_FALSE(column[42].has_value());
+  ASSERT_EQ(scan::find_first_empty(column.data(), column.size()), 42);
+  ASSERT_EQ(scan::count_engaged(column.data(), column.size()), 99);
+}
+
+TEST(TombstoneScan, Pointers) {
+  int values[3] = {1, 2, 3};
+  std::vector<tsd<int *>> column(40);
+  column[5] = &values[0];
+  column[33] = &values[2];
+  ASSERT_EQ(scan::count_engaged(column.data(), column.size()), 2);
+  ASSERT_EQ(scan::find_first_engaged(column.data(), column.size()), 5);
+  ASSERT_EQ(scan::find_last_engaged(column.data(), column.size()), 33);
+  std::vector<int *> out(column.size());
+  scan::value_or(column.data(), column.size(), out.data(), &values[1]);
+  ASSERT_EQ(out[5], &values[0]);
+  ASSERT_EQ(out[6], &values[1]);
+}